@@ -27,15 +27,75 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += \
+        attendanceexporter.cpp \
+        attendancemodel.cpp \
+        attendancestore.cpp \
+        attendancesummary.cpp \
+        attendancewriter.cpp \
+        bulkenroller.cpp \
+        capturethread.cpp \
+        dashboardview.cpp \
+        databaseschema.cpp \
+        facedetector.cpp \
+        faceembedder.cpp \
+        facequality.cpp \
+        facegallery.cpp \
+        facematcher.cpp \
+        facetracker.cpp \
+        frameanalyzer.cpp \
+        framepipeline.cpp \
+        galleryindex.cpp \
+        gallerystore.cpp \
+        httpserver.cpp \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        metrics.cpp \
+        motiondetector.cpp \
+        previewview.cpp \
+        recognitionworker.cpp \
+        replayrunner.cpp \
+        startupsequence.cpp \
+        toastoverlay.cpp
 
 HEADERS += \
-        mainwindow.h
+        attendanceexporter.h \
+        attendancemodel.h \
+        attendancestore.h \
+        attendancesummary.h \
+        attendancewriter.h \
+        boundedqueue.h \
+        bulkenroller.h \
+        capturethread.h \
+        dashboardview.h \
+        databaseschema.h \
+        facedetector.h \
+        faceembedder.h \
+        facequality.h \
+        facegallery.h \
+        facematcher.h \
+        facetracker.h \
+        fairqueue.h \
+        frameanalyzer.h \
+        framepipeline.h \
+        galleryindex.h \
+        gallerystore.h \
+        httpserver.h \
+        lockfreequeue.h \
+        mainwindow.h \
+        metrics.h \
+        motiondetector.h \
+        notification.h \
+        previewview.h \
+        recognitionworker.h \
+        replayrunner.h \
+        startupsequence.h \
+        toastoverlay.h
 
 FORMS += \
         mainwindow.ui
 
+# 微基准测试是单独的构建目标，见 benchmark/benchmark.pro
+
 
 INCLUDEPATH +=D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\include \
               D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\include \
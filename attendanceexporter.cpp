@@ -0,0 +1,301 @@
+#include "attendanceexporter.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+const quint32 kColumnarVersion = 1; // 列式格式版本
+const quint8 kInt64Column = 1; // 列类型：int64
+const quint8 kStringColumn = 2; // 列类型：字典编码字符串
+
+// 一块记录，按列存放
+struct Chunk
+{
+    QVector<qint64> ids;//主键
+    QVector<qint64> times;//签到时间(本地时间秒数)
+    QVector<QString> employeeIds;//员工编号
+    QVector<QString> names;//姓名
+    QVector<QString> departments;//部门
+
+    int size() const { return ids.size(); }
+    void clear() {
+        ids.resize(0);
+        times.resize(0);
+        employeeIds.resize(0);
+        names.resize(0);
+        departments.resize(0);
+    }
+};
+
+// CSV 字段：含逗号、引号或换行时用双引号包围，引号写两次
+void appendCsvField(QByteArray &out, const QString &field) {
+    QByteArray utf8 = field.toUtf8();
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') || utf8.contains('\r')) {
+        out += '"';
+        out += utf8.replace("\"", "\"\"");
+        out += '"';
+    } else {
+        out += utf8;
+    }
+}
+
+void encodeCsv(const Chunk &chunk, QByteArray &out) {
+    for (int i = 0; i < chunk.size(); ++i) {
+        out += QByteArray::number(chunk.ids[i]);
+        out += ',';
+        appendCsvField(out, chunk.employeeIds[i]);
+        out += ',';
+        appendCsvField(out, chunk.names[i]);
+        out += ',';
+        appendCsvField(out, chunk.departments[i]);
+        out += ',';
+        out += AttendanceStore::toTimestamp(chunk.times[i]).toUtf8();
+        out += "\r\n";
+    }
+}
+
+void writeUtf8(QDataStream &out, const QString &text) {
+    QByteArray utf8 = text.toUtf8();
+    out << quint32(utf8.size());
+    out.writeRawData(utf8.constData(), utf8.size());
+}
+
+// 一列写入临时缓冲区后，以字节数开头追加到块中
+void appendColumn(QDataStream &out, const QByteArray &column) {
+    out << quint32(column.size());
+    out.writeRawData(column.constData(), column.size());
+}
+
+void encodeInt64Column(const QVector<qint64> &values, QByteArray &column) {
+    column.resize(0);
+    QDataStream out(&column, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    for (qint64 value : values) {
+        out << value;
+    }
+}
+
+// 字典只在本块内有效，每块可以单独解码
+void encodeStringColumn(const QVector<QString> &values, QByteArray &column) {
+    QHash<QString, quint32> codes;
+    QVector<QString> dictionary;
+    QVector<quint32> indexes;
+    indexes.reserve(values.size());
+    for (const QString &value : values) {
+        auto it = codes.constFind(value);
+        if (it == codes.constEnd()) {
+            it = codes.insert(value, dictionary.size());
+            dictionary.append(value);
+        }
+        indexes.append(it.value());
+    }
+
+    column.resize(0);
+    QDataStream out(&column, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint32(dictionary.size());
+    for (const QString &value : dictionary) {
+        writeUtf8(out, value);
+    }
+    for (quint32 index : indexes) {
+        out << index;
+    }
+}
+
+void writeColumnarHeader(QDataStream &out) {
+    out.writeRawData("FATC", 4);
+    out << kColumnarVersion << quint32(5);
+    out << kInt64Column;
+    writeUtf8(out, "id");
+    out << kInt64Column;
+    writeUtf8(out, "timestamp");
+    out << kStringColumn;
+    writeUtf8(out, "employee_id");
+    out << kStringColumn;
+    writeUtf8(out, "name");
+    out << kStringColumn;
+    writeUtf8(out, "department");
+}
+
+// 编码一块记录追加到缓冲区
+void encodeChunk(const Chunk &chunk, ExportConfig::Format format, QByteArray &buffer, QByteArray &column) {
+    if (format == ExportConfig::Csv) {
+        encodeCsv(chunk, buffer);
+        return;
+    }
+    QDataStream out(&buffer, QIODevice::Append);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint32(chunk.size());
+    encodeInt64Column(chunk.ids, column);
+    appendColumn(out, column);
+    encodeInt64Column(chunk.times, column);
+    appendColumn(out, column);
+    encodeStringColumn(chunk.employeeIds, column);
+    appendColumn(out, column);
+    encodeStringColumn(chunk.names, column);
+    appendColumn(out, column);
+    encodeStringColumn(chunk.departments, column);
+    appendColumn(out, column);
+}
+}
+
+ExportConfig::Format ExportConfig::formatForPath(const QString &path) {
+    return QFileInfo(path).suffix().compare("fatc", Qt::CaseInsensitive) == 0 ? Columnar : Csv;
+}
+
+QString ExportReport::toString() const {
+    return QString("exported %1 records, %2 KB in %3 ms (%4 records/s)\n")
+            .arg(rows)
+            .arg(bytes / 1024)
+            .arg(elapsedMs, 0, 'f', 0)
+            .arg(elapsedMs > 0.0 ? rows * 1000.0 / elapsedMs : 0.0, 0, 'f', 0);
+}
+
+AttendanceExporter::AttendanceExporter(const ExportConfig &config)
+    : config(config)
+    , exported(0)
+    , expected(0)
+    , cancelled(false)
+{
+}
+
+bool AttendanceExporter::run() {
+    QElapsedTimer timer;
+    timer.start();
+    result = ExportReport();
+    exported = 0;
+
+    // 导出可能在后台线程中进行，使用自己的连接
+    QString connectionName = QString("attendance_export_%1").arg(reinterpret_cast<quintptr>(this));
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(config.databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (!db.open()) {
+            error = db.lastError().text();
+        } else {
+            // 先统计行数用于显示进度，只统计时间范围内的分区
+            AttendanceStore store(db);
+            expected = qMax<qint64>(0, store.count(config.filter));
+            ok = writeRows(store);
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    result.rows = exported;
+    result.elapsedMs = timer.nsecsElapsed() / 1e6;
+    if (!ok) {
+        qDebug() << "Error exporting attendance:" << error;
+    }
+    return ok;
+}
+
+bool AttendanceExporter::writeRows(AttendanceStore &store) {
+    QSaveFile file(config.outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    int chunkRows = qMax(1, config.chunkRows);
+    Chunk chunk;
+    chunk.ids.reserve(chunkRows);
+    chunk.times.reserve(chunkRows);
+    chunk.employeeIds.reserve(chunkRows);
+    chunk.names.reserve(chunkRows);
+    chunk.departments.reserve(chunkRows);
+    QByteArray buffer;
+    QByteArray column;
+
+    if (config.format == ExportConfig::Csv) {
+        buffer = "\xEF\xBB\xBF"; // UTF-8 BOM，Excel按UTF-8打开
+        buffer += "id,employee_id,name,department,timestamp\r\n";
+    } else {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out.setByteOrder(QDataStream::LittleEndian);
+        writeColumnarHeader(out);
+    }
+
+    // 编码当前块并写入文件，每块写一次，缓冲区大小与块大小相当
+    bool written = true;
+    auto flush = [&]() {
+        if (chunk.size() > 0) {
+            encodeChunk(chunk, config.format, buffer, column);
+        }
+        if (!buffer.isEmpty()) {
+            if (file.write(buffer) != buffer.size()) {
+                error = file.errorString();
+                written = false;
+                return;
+            }
+            result.bytes += buffer.size();
+            buffer.resize(0);
+        }
+        exported += chunk.size();
+        chunk.clear();
+    };
+
+    bool scanned = store.scan(config.filter, [&](const AttendanceRecord &record) {
+        chunk.ids.append(record.id);
+        chunk.times.append(record.time);
+        chunk.employeeIds.append(record.employeeId);
+        chunk.names.append(record.name);
+        chunk.departments.append(record.department);
+        if (chunk.size() < chunkRows) {
+            return true;
+        }
+        flush();
+        return written && !cancelled;
+    });
+    if (scanned && written && !cancelled) {
+        flush();
+    }
+
+    if (!scanned) {
+        error = store.errorString();
+        file.cancelWriting();
+        return false;
+    }
+    if (!written) {
+        file.cancelWriting();
+        return false;
+    }
+    if (cancelled) {
+        error = "export cancelled";
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void AttendanceExporter::cancel() {
+    cancelled = true;
+}
+
+qint64 AttendanceExporter::progress() const {
+    return exported;
+}
+
+qint64 AttendanceExporter::total() const {
+    return expected;
+}
+
+const ExportReport &AttendanceExporter::report() const {
+    return result;
+}
+
+QString AttendanceExporter::errorString() const {
+    return error;
+}
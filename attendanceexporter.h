@@ -0,0 +1,67 @@
+#ifndef ATTENDANCEEXPORTER_H
+#define ATTENDANCEEXPORTER_H
+
+#include <QString>
+#include <atomic>
+#include "attendancestore.h"
+
+// 考勤导出参数
+struct ExportConfig
+{
+    enum Format {
+        Csv,//UTF-8 CSV(带BOM，Excel可直接打开)
+        Columnar//按块存放的列式二进制格式(.fatc)
+    };
+
+    QString databasePath;//数据库文件路径 导出使用自己的连接
+    QString outputPath;//输出文件路径
+    Format format = Csv;//输出格式
+    AttendanceFilter filter;//时间范围、部门和员工编号筛选
+    int chunkRows = 8192;//每块的行数 内存占用只与它有关
+
+    static Format formatForPath(const QString &path);//按扩展名选择格式 .fatc为列式格式 其余为CSV
+};
+
+// 导出结果
+struct ExportReport
+{
+    qint64 rows = 0;//导出的记录数
+    qint64 bytes = 0;//输出文件大小
+    double elapsedMs = 0.0;//耗时(毫秒)
+
+    QString toString() const;//格式化为文本报告
+};
+
+// 考勤导出：按签到时间顺序逐个分区遍历考勤记录(含归档文件)，每读满一块就编码并写入文件
+// 内存占用与记录总数无关；写入临时文件，完成后才替换目标文件，中途失败或取消不会留下不完整的文件
+//
+// 列式格式(小端)：文件头 "FATC"、版本(quint32)、列数(quint32)，每列一个类型字节(1=int64 2=字典编码字符串)和列名(quint32长度+UTF-8)；
+// 之后是若干块，每块以行数(quint32)开头，各列依次存放，每列以字节数(quint32)开头，读取方可以跳过不需要的列
+// int64列直接存放数值；字符串列先存本块的字典(quint32个数，每项quint32长度+UTF-8)，再存每行的字典下标(quint32)
+// 列为 id、timestamp(本地时间，自1970-01-01 00:00:00起的秒数，即分区中保存的值)、employee_id、name、department
+//
+// run 可在任意线程调用；progress/total/cancel 可在其他线程调用
+class AttendanceExporter
+{
+public:
+    explicit AttendanceExporter(const ExportConfig &config);
+
+    bool run();//执行导出 返回是否成功
+    void cancel();//请求取消 run在下一块结束时返回false
+    qint64 progress() const;//已导出的记录数
+    qint64 total() const;//符合筛选条件的记录数 开始导出后可用
+    const ExportReport &report() const;//导出结果
+    QString errorString() const;//失败原因
+
+private:
+    bool writeRows(AttendanceStore &store);//逐块读取记录并写入文件
+
+    ExportConfig config;//导出参数
+    ExportReport result;//导出结果
+    QString error;//失败原因
+    std::atomic<qint64> exported;//已导出的记录数
+    std::atomic<qint64> expected;//符合条件的记录数
+    std::atomic<bool> cancelled;//是否要求取消
+};
+
+#endif // ATTENDANCEEXPORTER_H
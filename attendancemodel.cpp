@@ -0,0 +1,92 @@
+#include "attendancemodel.h"
+#include <QStringList>
+#include <QFileInfo>
+#include <QDebug>
+
+AttendanceTableModel::AttendanceTableModel(const QSqlDatabase &db, QObject *parent)
+    : QAbstractTableModel(parent)
+    , store(db)
+    , lastId(0)
+    , hasMore(false)
+    , pageSize(200)
+{
+}
+
+void AttendanceTableModel::setFilter(const AttendanceFilter &filter) {
+    this->filter = filter;
+    refresh();
+}
+
+void AttendanceTableModel::refresh() {
+    beginResetModel();
+    rows.clear();
+    lastId = 0;
+    hasMore = true;
+    endResetModel();
+
+    // 只加载第一页
+    fetchMore(QModelIndex());
+}
+
+void AttendanceTableModel::setPageSize(int rows) {
+    pageSize = qMax(1, rows);
+}
+
+int AttendanceTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int AttendanceTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : 5;
+}
+
+QVariant AttendanceTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= rows.size()) {
+        return QVariant();
+    }
+    const AttendanceRecord &row = rows[index.row()];
+    switch (index.column()) {
+    case 0: return row.employeeId; // 员工编号
+    case 1: return row.name; // 姓名
+    case 2: return row.department; // 部门
+    case 3: return row.timestamp(); // 签到时间
+    case 4: return QFileInfo(row.faceImage).fileName(); // 人脸图像文件名
+    default: return QVariant();
+    }
+}
+
+QVariant AttendanceTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"员工编号", "姓名", "部门", "签到时间", "人脸图像"};
+    return headers.value(section);
+}
+
+bool AttendanceTableModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && hasMore;
+}
+
+void AttendanceTableModel::fetchMore(const QModelIndex &parent) {
+    if (parent.isValid() || !hasMore) {
+        return;
+    }
+
+    // 按主键倒序的 keyset 分页：每页都从上一页最后一行继续，不使用 OFFSET，任何一页的代价都相同
+    QVector<AttendanceRecord> page;
+    if (!store.page(filter, lastId, pageSize, page)) {
+        qDebug() << "Error fetching attendance records:" << store.errorString();
+        hasMore = false;
+        return;
+    }
+
+    hasMore = page.size() == pageSize;
+    if (page.isEmpty()) {
+        return;
+    }
+    lastId = page.last().id;
+
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + page.size() - 1);
+    rows += page;
+    endInsertRows();
+}
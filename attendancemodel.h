@@ -0,0 +1,38 @@
+#ifndef ATTENDANCEMODEL_H
+#define ATTENDANCEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSqlDatabase>
+#include <QVector>
+#include "attendancestore.h"
+
+// 考勤记录表模型：按主键倒序分页(keyset)按需加载，筛选条件在数据库中执行，只访问时间范围内的月份分区
+// 打开时只读取第一页，滚动到底部时视图通过 canFetchMore/fetchMore 加载下一页，耗时与历史记录总量无关
+class AttendanceTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit AttendanceTableModel(const QSqlDatabase &db, QObject *parent = nullptr);
+
+    void setFilter(const AttendanceFilter &filter);//设置筛选条件并重新加载
+    void refresh();//按当前筛选条件重新加载
+    void setPageSize(int rows);//每页行数
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    AttendanceStore store;//考勤存储(界面线程的连接)
+    AttendanceFilter filter;//当前筛选条件
+    QVector<AttendanceRecord> rows;//已加载的行
+    qint64 lastId;//已加载的最小主键，下一页从这里继续
+    bool hasMore;//是否还有未加载的行
+    int pageSize;//每页行数
+};
+
+#endif // ATTENDANCEMODEL_H
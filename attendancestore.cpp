@@ -0,0 +1,655 @@
+#include "attendancestore.h"
+#include <QSqlError>
+#include <QDate>
+#include <QTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace {
+const char *kLegacyTable = "attendance"; // 旧版考勤表 也是归档文件中的分区表名
+const int kMigrateBatch = 10000; // 迁移旧表时每个事务搬运的记录数
+const char *kQuarantineTable = "attendance_invalid"; // 迁移时时间无法解析的旧记录原样保存在这里，不随旧表删除
+const QDate kEpoch(1970, 1, 1);
+
+// 分区表：id 的高32位为月份，ts 为本地时间秒数，person 指向员工快照
+const char *kPartitionColumns =
+        "id INTEGER PRIMARY KEY, "
+        "person INTEGER NOT NULL REFERENCES attendance_people(id), "
+        "ts INTEGER NOT NULL";
+
+// 与主数据库中的 attendance_people 相同，归档文件只带自己引用的员工快照
+const char *kArchivePeople =
+        "CREATE TABLE archive.attendance_people ("
+        "id INTEGER PRIMARY KEY, "
+        "employee_id TEXT NOT NULL, "
+        "name TEXT NOT NULL, "
+        "department TEXT NOT NULL, "
+        "face_image TEXT NOT NULL, "
+        "UNIQUE (employee_id, name, department, face_image))";
+
+// 字符串中固定位置的数字 不是数字时返回-1
+int number(const QString &text, int position, int length) {
+    bool ok = false;
+    int value = text.midRef(position, length).toInt(&ok);
+    return ok ? value : -1;
+}
+
+// 保存时空值写成空字符串，员工快照的唯一约束才能生效
+QString text(const QString &value) {
+    return value.isNull() ? QString("") : value;
+}
+
+// 分区表的索引
+bool createIndexes(QSqlQuery &query, const QString &schema, const QString &table) {
+    return query.exec(QString("CREATE INDEX IF NOT EXISTS %1%2_ts ON %2(ts)").arg(schema, table))
+            && query.exec(QString("CREATE INDEX IF NOT EXISTS %1%2_person ON %2(person, ts)").arg(schema, table));
+}
+}
+
+QString AttendanceRecord::timestamp() const {
+    return AttendanceStore::toTimestamp(time);
+}
+
+AttendanceStore::AttendanceStore(const QSqlDatabase &db)
+    : db(db)
+    , prepared(false)
+{
+}
+
+bool AttendanceStore::prepare() {
+    if (prepared) {
+        return true;
+    }
+    // 在第一次写入时才创建语句，此时连接已经打开；只读取的实例(表格模型、接口)不需要
+    findPerson = QSqlQuery(db);
+    addPerson = QSqlQuery(db);
+    if (!findPerson.prepare("SELECT id FROM attendance_people "
+                            "WHERE employee_id = ? AND name = ? AND department = ? AND face_image = ?")
+            || !addPerson.prepare("INSERT INTO attendance_people (employee_id, name, department, face_image) VALUES (?, ?, ?, ?)")) {
+        error = db.lastError().text();
+        return false;
+    }
+    prepared = true;
+    return true;
+}
+
+bool AttendanceStore::insert(const EmployeeRecord &employee, const QString &timestamp) {
+    qint64 seconds = toSeconds(timestamp);
+    if (seconds < 0) {
+        error = QString("invalid timestamp: %1").arg(timestamp);
+        return false;
+    }
+    int month = monthOf(seconds);
+    if (!ensurePartition(month)) {
+        return false;
+    }
+    qint64 person = personId(employee);
+    if (person < 0) {
+        return false;
+    }
+
+    // 每个分区一条预编译语句；主键在分区内连续递增，第一条记录从 月份<<32 + 1 开始
+    auto it = inserts.find(month);
+    if (it == inserts.end()) {
+        QString table = partitionTable(month);
+        QSqlQuery query(db);
+        if (!query.prepare(QString("INSERT INTO %1 (id, person, ts) VALUES (COALESCE((SELECT MAX(id) FROM %1), %2) + 1, ?, ?)")
+                           .arg(table).arg(qint64(month) << 32))) {
+            error = query.lastError().text();
+            return false;
+        }
+        it = inserts.insert(month, query);
+    }
+    it.value().addBindValue(person);
+    it.value().addBindValue(seconds);
+    if (!it.value().exec()) {
+        error = it.value().lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void AttendanceStore::discardCache() {
+    // 回滚后本事务中新建的分区和员工快照都不存在了
+    people.clear();
+    knownPartitions.clear();
+    inserts.clear();
+}
+
+bool AttendanceStore::ensurePartition(int month) {
+    if (knownPartitions.contains(month)) {
+        return true;
+    }
+    QSqlQuery query(db);
+    query.prepare("SELECT archive FROM attendance_partitions WHERE month = ?");
+    query.addBindValue(month);
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+    if (query.next() && !query.value(0).isNull()) {
+        // 归档文件是只读的，已归档的月份不再接受写入
+        error = QString("attendance partition %1 is archived").arg(month);
+        return false;
+    }
+    query.finish();
+
+    QString table = partitionTable(month);
+    if (!query.exec(QString("CREATE TABLE IF NOT EXISTS %1 (%2)").arg(table, kPartitionColumns))
+            || !createIndexes(query, QString(), table)) {
+        error = query.lastError().text();
+        return false;
+    }
+    query.prepare("INSERT OR IGNORE INTO attendance_partitions (month, archive, rows) VALUES (?, NULL, 0)");
+    query.addBindValue(month);
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+    knownPartitions.insert(month);
+    return true;
+}
+
+qint64 AttendanceStore::personId(const EmployeeRecord &employee) {
+    QString key = employee.employeeId + QChar(0x1f) + employee.name + QChar(0x1f) + employee.department + QChar(0x1f) + employee.faceImage;
+    auto it = people.constFind(key);
+    if (it != people.constEnd()) {
+        return it.value();
+    }
+    if (!prepare()) {
+        return -1;
+    }
+
+    // 员工信息不变时所有签到共用一个快照；改名或调部门后新增一个，历史记录仍显示当时的信息
+    findPerson.addBindValue(text(employee.employeeId));
+    findPerson.addBindValue(text(employee.name));
+    findPerson.addBindValue(text(employee.department));
+    findPerson.addBindValue(text(employee.faceImage));
+    if (!findPerson.exec()) {
+        error = findPerson.lastError().text();
+        return -1;
+    }
+    qint64 id = -1;
+    if (findPerson.next()) {
+        id = findPerson.value(0).toLongLong();
+    } else {
+        addPerson.addBindValue(text(employee.employeeId));
+        addPerson.addBindValue(text(employee.name));
+        addPerson.addBindValue(text(employee.department));
+        addPerson.addBindValue(text(employee.faceImage));
+        if (!addPerson.exec()) {
+            error = addPerson.lastError().text();
+            return -1;
+        }
+        id = addPerson.lastInsertId().toLongLong();
+    }
+    findPerson.finish();
+    people.insert(key, id);
+    return id;
+}
+
+void AttendanceStore::conditions(const AttendanceFilter &filter, QStringList &where, QVariantList &values) {
+    // 时间条件直接写成整数，分区表的 ts 索引可以直接使用
+    if (filter.from.isValid()) {
+        where << QString("a.ts >= %1").arg(toSeconds(filter.from));
+    }
+    if (filter.to.isValid()) {
+        where << QString("a.ts <= %1").arg(toSeconds(filter.to));
+    }
+    // 归档文件中的员工快照主键与主数据库不同，用子查询在各自的数据库中查找
+    QStringList snapshot;
+    if (!filter.department.isEmpty()) {
+        snapshot << "department = ?";
+        values << filter.department;
+    }
+    if (!filter.employeeId.isEmpty()) {
+        snapshot << "employee_id = ?";
+        values << filter.employeeId;
+    }
+    if (!snapshot.isEmpty()) {
+        where << "a.person IN (SELECT id FROM attendance_people WHERE " + snapshot.join(" AND ") + ")";
+    }
+}
+
+QString AttendanceStore::selectRecords(const QString &table, const QStringList &where) {
+    QString sql = QString("SELECT a.id, a.ts, p.employee_id, p.name, p.department, p.face_image "
+                          "FROM %1 a JOIN attendance_people p ON p.id = a.person").arg(table);
+    if (!where.isEmpty()) {
+        sql += " WHERE " + where.join(" AND ");
+    }
+    return sql;
+}
+
+AttendanceRecord AttendanceStore::readRecord(const QSqlQuery &query) {
+    AttendanceRecord record;
+    record.id = query.value(0).toLongLong();
+    record.time = query.value(1).toLongLong();
+    record.employeeId = query.value(2).toString();
+    record.name = query.value(3).toString();
+    record.department = query.value(4).toString();
+    record.faceImage = query.value(5).toString();
+    return record;
+}
+
+bool AttendanceStore::partitions(const AttendanceFilter &filter, Order order, QVector<Partition> &result, int maxMonth) {
+    result.clear();
+    // 只取时间范围覆盖的月份，范围之外的分区和归档文件都不打开
+    QStringList where;
+    if (filter.from.isValid()) {
+        where << QString("month >= %1").arg(monthOf(toSeconds(filter.from)));
+    }
+    if (filter.to.isValid()) {
+        where << QString("month <= %1").arg(monthOf(toSeconds(filter.to)));
+    }
+    if (maxMonth > 0) {
+        where << QString("month <= %1").arg(maxMonth); // 分页时 beforeId 之后的月份已经取过
+    }
+    QString sql = "SELECT month, archive FROM attendance_partitions";
+    if (!where.isEmpty()) {
+        sql += " WHERE " + where.join(" AND ");
+    }
+    sql += order == NewestFirst ? " ORDER BY month DESC" : " ORDER BY month";
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(sql)) {
+        error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        Partition partition;
+        partition.month = query.value(0).toInt();
+        partition.archive = query.value(1).toString();
+        result.append(partition);
+    }
+    return true;
+}
+
+bool AttendanceStore::forEachPartition(const AttendanceFilter &filter, Order order, const PartitionVisitor &visit, int maxMonth) {
+    QVector<Partition> list;
+    if (!partitions(filter, order, list, maxMonth)) {
+        return false;
+    }
+    for (const Partition &partition : list) {
+        if (partition.archive.isEmpty()) {
+            if (!visit(db, partitionTable(partition.month), partition.month)) {
+                return true;
+            }
+            continue;
+        }
+
+        // 归档文件用临时连接只读打开，访问完立即关闭
+        QString connectionName = QString("attendance_archive_%1_%2").arg(reinterpret_cast<quintptr>(this)).arg(partition.month);
+        bool opened = false;
+        bool more = true;
+        {
+            QSqlDatabase archiveDb = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            archiveDb.setDatabaseName(partition.archive);
+            archiveDb.setConnectOptions("QSQLITE_OPEN_READONLY");
+            opened = archiveDb.open();
+            if (!opened) {
+                error = QString("cannot open attendance archive %1: %2").arg(partition.archive, archiveDb.lastError().text());
+            } else {
+                more = visit(archiveDb, kLegacyTable, partition.month);
+            }
+            archiveDb.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        if (!opened) {
+            return false;
+        }
+        if (!more) {
+            return true;
+        }
+    }
+    return true;
+}
+
+bool AttendanceStore::page(const AttendanceFilter &filter, qint64 beforeId, int limit, QVector<AttendanceRecord> &records) {
+    records.clear();
+    if (limit <= 0) {
+        return true;
+    }
+    QStringList where;
+    QVariantList values;
+    conditions(filter, where, values);
+
+    // 主键的高32位是月份：从 beforeId 所在的分区开始，按月份从新到旧取满一页
+    int beforeMonth = beforeId > 0 ? static_cast<int>(beforeId >> 32) : 0;
+    bool ok = true;
+    // 比 beforeId 新的分区在选择分区时就排除，不打开它们的归档文件
+    bool visited = forEachPartition(filter, NewestFirst, [&](QSqlDatabase &partitionDb, const QString &table, int month) {
+        QStringList partitionWhere = where;
+        if (month == beforeMonth) {
+            partitionWhere << QString("a.id < %1").arg(beforeId);
+        }
+        QSqlQuery query(partitionDb);
+        query.setForwardOnly(true);
+        query.prepare(selectRecords(table, partitionWhere) + QString(" ORDER BY a.id DESC LIMIT %1").arg(limit - records.size()));
+        for (const QVariant &value : values) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            error = query.lastError().text();
+            ok = false;
+            return false;
+        }
+        while (query.next()) {
+            records.append(readRecord(query));
+        }
+        return records.size() < limit;
+    }, beforeMonth);
+    return visited && ok;
+}
+
+bool AttendanceStore::scan(const AttendanceFilter &filter, const Visitor &visit) {
+    QStringList where;
+    QVariantList values;
+    conditions(filter, where, values);
+
+    // 分区按月份从旧到新，分区内 ts 索引本身按 (ts, id) 有序，不需要额外的排序
+    bool ok = true;
+    bool visited = forEachPartition(filter, OldestFirst, [&](QSqlDatabase &partitionDb, const QString &table, int) {
+        QSqlQuery query(partitionDb);
+        query.setForwardOnly(true);
+        query.prepare(selectRecords(table, where) + " ORDER BY a.ts, a.id");
+        for (const QVariant &value : values) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            error = query.lastError().text();
+            ok = false;
+            return false;
+        }
+        while (query.next()) {
+            if (!visit(readRecord(query))) {
+                return false;
+            }
+        }
+        if (query.lastError().isValid()) {
+            error = query.lastError().text();
+            ok = false;
+            return false;
+        }
+        return true;
+    });
+    return visited && ok;
+}
+
+qint64 AttendanceStore::count(const AttendanceFilter &filter) {
+    QStringList where;
+    QVariantList values;
+    conditions(filter, where, values);
+
+    qint64 total = 0;
+    bool ok = true;
+    bool visited = forEachPartition(filter, OldestFirst, [&](QSqlDatabase &partitionDb, const QString &table, int) {
+        QString sql = QString("SELECT COUNT(*) FROM %1 a").arg(table);
+        if (!where.isEmpty()) {
+            sql += " WHERE " + where.join(" AND ");
+        }
+        QSqlQuery query(partitionDb);
+        query.prepare(sql);
+        for (const QVariant &value : values) {
+            query.addBindValue(value);
+        }
+        if (!query.exec() || !query.next()) {
+            error = query.lastError().text();
+            ok = false;
+            return false;
+        }
+        total += query.value(0).toLongLong();
+        return true;
+    });
+    return visited && ok ? total : -1;
+}
+
+bool AttendanceStore::migrateLegacy(qint64 *rows) {
+    if (rows) {
+        *rows = 0;
+    }
+    QSqlQuery query(db);
+    if (!query.exec(QString("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = '%1'").arg(kLegacyTable))) {
+        error = query.lastError().text();
+        return false;
+    }
+    if (!query.next()) {
+        return true;
+    }
+    query.finish();
+
+    // 隔离表与旧表结构相同，无法迁移的记录搬到这里，由人工核对
+    if (!query.exec(QString("CREATE TABLE IF NOT EXISTS %1 AS SELECT * FROM %2 WHERE 0").arg(kQuarantineTable).arg(kLegacyTable))) {
+        error = query.lastError().text();
+        return false;
+    }
+    QSqlQuery quarantine(db);
+
+    // 每批记录的写入和从旧表删除在同一个事务中，中途退出后再次启动从剩下的记录继续
+    forever {
+        db.transaction();
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT id, employee_id, name, department, timestamp, face_image FROM %1 ORDER BY id LIMIT ?").arg(kLegacyTable));
+        query.addBindValue(kMigrateBatch);
+        bool ok = query.exec();
+        if (!ok) {
+            error = query.lastError().text();
+        }
+        qint64 lastId = -1;
+        int moved = 0;
+        QVector<qint64> invalidIds;
+        while (ok && query.next()) {
+            lastId = query.value(0).toLongLong();
+            EmployeeRecord employee;
+            employee.employeeId = query.value(1).toString();
+            employee.name = query.value(2).toString();
+            employee.department = query.value(3).toString();
+            employee.faceImage = query.value(5).toString();
+            QString timestamp = query.value(4).toString();
+            if (toSeconds(timestamp) < 0) {
+                qDebug() << "Quarantining attendance record with invalid timestamp:" << lastId << timestamp;
+                invalidIds.append(lastId);
+                continue;
+            }
+            ok = insert(employee, timestamp);
+            ++moved;
+        }
+        if (ok && query.lastError().isValid()) {
+            error = query.lastError().text();
+            ok = false;
+        }
+        query.finish();
+
+        // 无法迁移的记录先复制到隔离表，再随本批一起从旧表删除
+        if (ok && !invalidIds.isEmpty()) {
+            quarantine.prepare(QString("INSERT INTO %1 SELECT * FROM %2 WHERE id = ?").arg(kQuarantineTable).arg(kLegacyTable));
+            for (int i = 0; ok && i < invalidIds.size(); ++i) {
+                quarantine.addBindValue(invalidIds[i]);
+                ok = quarantine.exec();
+                if (!ok) {
+                    error = quarantine.lastError().text();
+                }
+            }
+            quarantine.finish();
+        }
+
+        if (ok && lastId < 0) {
+            // 旧表已经搬空，删除表和它的索引
+            ok = query.exec(QString("DROP TABLE %1").arg(kLegacyTable));
+            if (!ok) {
+                error = query.lastError().text();
+            }
+        } else if (ok) {
+            query.prepare(QString("DELETE FROM %1 WHERE id <= ?").arg(kLegacyTable));
+            query.addBindValue(lastId);
+            ok = query.exec();
+            if (!ok) {
+                error = query.lastError().text();
+            }
+        }
+        if (!ok || !db.commit()) {
+            if (ok) {
+                error = db.lastError().text();
+            }
+            db.rollback();
+            discardCache();
+            qDebug() << "Error migrating attendance records:" << error;
+            return false;
+        }
+        if (lastId < 0) {
+            return true;
+        }
+        if (rows) {
+            *rows += moved;
+        }
+    }
+}
+
+bool AttendanceStore::archive(const QString &directory, int keepMonths, QStringList *archived) {
+    if (!QDir().mkpath(directory)) {
+        error = QString("cannot create archive directory %1").arg(directory);
+        return false;
+    }
+
+    // 保留最近 keepMonths 个月(含当月)，更早的分区归档
+    QDate cutoff = QDate::currentDate().addMonths(-(qMax(1, keepMonths) - 1));
+    QSqlQuery query(db);
+    query.prepare("SELECT month FROM attendance_partitions WHERE archive IS NULL AND month < ? ORDER BY month");
+    query.addBindValue(cutoff.year() * 100 + cutoff.month());
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+    QVector<int> months;
+    while (query.next()) {
+        months.append(query.value(0).toInt());
+    }
+    query.finish();
+
+    for (int month : months) {
+        QString table = partitionTable(month);
+        QString path = QFileInfo(QDir(directory).filePath(table + ".db")).absoluteFilePath();
+        if (QFile::exists(path)) {
+            // 目录中还没有登记，是上次中途失败留下的文件
+            QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+            QFile::remove(path);
+        }
+
+        query.prepare("ATTACH DATABASE ? AS archive");
+        query.addBindValue(path);
+        if (!query.exec()) {
+            error = query.lastError().text();
+            return false;
+        }
+        // 归档文件使用回滚日志，写完后只有一个文件，可以直接复制或备份
+        query.exec("PRAGMA archive.journal_mode=DELETE");
+
+        db.transaction();
+        bool ok = query.exec(kArchivePeople)
+                && query.exec(QString("CREATE TABLE archive.%1 (%2)").arg(kLegacyTable, kPartitionColumns))
+                && query.exec(QString("INSERT INTO archive.attendance_people "
+                                      "SELECT id, employee_id, name, department, face_image FROM main.attendance_people WHERE id IN (SELECT DISTINCT person FROM main.%1)").arg(table))
+                && query.exec(QString("INSERT INTO archive.%1 (id, person, ts) SELECT id, person, ts FROM main.%2 ORDER BY id").arg(kLegacyTable, table))
+                && createIndexes(query, "archive.", kLegacyTable)
+                && query.exec(QString("SELECT COUNT(*) FROM archive.%1").arg(kLegacyTable)) && query.next();
+        qint64 rows = ok ? query.value(0).toLongLong() : 0;
+        if (!ok) {
+            error = query.lastError().text();
+        }
+        query.finish();
+        if (!ok || !db.commit()) {
+            if (ok) {
+                error = db.lastError().text();
+            }
+            db.rollback();
+            query.exec("DETACH DATABASE archive");
+            QFile::remove(path);
+            return false;
+        }
+        query.exec("DETACH DATABASE archive");
+        QFile::setPermissions(path, QFile::ReadOwner | QFile::ReadGroup | QFile::ReadOther);
+
+        // WAL 模式下跨数据库的事务不是整体原子的：归档文件先单独提交，再在一个事务中登记并删除分区
+        db.transaction();
+        query.prepare("UPDATE attendance_partitions SET archive = ?, rows = ? WHERE month = ?");
+        query.addBindValue(path);
+        query.addBindValue(rows);
+        query.addBindValue(month);
+        ok = query.exec() && query.exec(QString("DROP TABLE %1").arg(table));
+        if (!ok) {
+            error = query.lastError().text();
+        }
+        if (!ok || !db.commit()) {
+            if (ok) {
+                error = db.lastError().text();
+            }
+            db.rollback();
+            return false;
+        }
+        knownPartitions.remove(month);
+        inserts.remove(month);
+        if (archived) {
+            archived->append(path);
+        }
+        qDebug() << "Archived attendance partition" << month << rows << "records to" << path;
+    }
+    return true;
+}
+
+bool AttendanceStore::compact() {
+    QSqlQuery query(db);
+    // 先把 WAL 写回主文件并截断，VACUUM 再重写整个文件，释放删除的分区和旧表占用的页
+    if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)") || !query.exec("VACUUM")) {
+        error = query.lastError().text();
+        return false;
+    }
+    query.exec("PRAGMA optimize");
+    return true;
+}
+
+QString AttendanceStore::errorString() const {
+    return error;
+}
+
+QString AttendanceStore::partitionTable(int month) {
+    return QString("attendance_%1").arg(month);
+}
+
+int AttendanceStore::monthOf(qint64 seconds) {
+    QDate date = kEpoch.addDays(seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400);
+    return date.year() * 100 + date.month();
+}
+
+qint64 AttendanceStore::toSeconds(const QString &timestamp) {
+    // 只解析固定位置的数字，比 QDateTime::fromString 快得多，迁移和导出时每条记录都要调用
+    if (timestamp.size() < 19 || timestamp.at(4) != '-' || timestamp.at(7) != '-'
+            || timestamp.at(13) != ':' || timestamp.at(16) != ':') {
+        return -1;
+    }
+    QDate date(number(timestamp, 0, 4), number(timestamp, 5, 2), number(timestamp, 8, 2));
+    int hour = number(timestamp, 11, 2);
+    int minute = number(timestamp, 14, 2);
+    int second = number(timestamp, 17, 2);
+    if (!date.isValid() || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+        return -1;
+    }
+    return kEpoch.daysTo(date) * 86400LL + hour * 3600 + minute * 60 + second;
+}
+
+qint64 AttendanceStore::toSeconds(const QDateTime &time) {
+    return kEpoch.daysTo(time.date()) * 86400LL + time.time().msecsSinceStartOfDay() / 1000;
+}
+
+QString AttendanceStore::toTimestamp(qint64 seconds) {
+    qint64 days = seconds / 86400;
+    qint64 rest = seconds % 86400;
+    if (rest < 0) {
+        rest += 86400;
+        --days;
+    }
+    // 日期和时刻分开格式化，不经过时区换算，夏令时切换时也不会出现无效时间
+    return kEpoch.addDays(days).toString("yyyy-MM-dd") + ' '
+            + QTime::fromMSecsSinceStartOfDay(static_cast<int>(rest) * 1000).toString("HH:mm:ss");
+}
@@ -0,0 +1,99 @@
+#ifndef ATTENDANCESTORE_H
+#define ATTENDANCESTORE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+#include <functional>
+#include "facegallery.h"
+
+// 考勤记录筛选条件，空值表示不限制
+struct AttendanceFilter
+{
+    QDateTime from;//起始时间(含)
+    QDateTime to;//结束时间(含)
+    QString department;//部门
+    QString employeeId;//员工编号
+};
+
+// 一条考勤记录
+struct AttendanceRecord
+{
+    qint64 id = 0;//主键 高32位为分区月份(yyyymm)，低32位为分区内序号，按写入顺序递增
+    qint64 time = 0;//签到时间 本地时间自1970-01-01 00:00:00起的秒数(不换算时区)
+    QString employeeId;//员工编号
+    QString name;//姓名
+    QString department;//部门
+    QString faceImage;//人脸图像路径
+
+    QString timestamp() const;//签到时间 "yyyy-MM-dd HH:mm:ss"
+};
+
+// 按月分区的考勤存储：每月一张表 attendance_yyyymm(id, person, ts)，只存整数
+// ts为本地时间秒数，person指向 attendance_people 中的员工快照(编号、姓名、部门、人脸图像，变化时才新增一行)，不再每行重复字符串
+// 分区目录 attendance_partitions 记录每个月份在主数据库中还是已归档；归档文件是只读的独立数据库，自带所引用的员工快照
+// 查询只访问时间范围内的分区，逐个分区执行后合并；当月的写入和查询代价与历史记录总量无关
+// 每个实例绑定一个连接，只能在该连接所在的线程中使用
+class AttendanceStore
+{
+public:
+    enum Order {
+        NewestFirst,//按月份从新到旧
+        OldestFirst//按月份从旧到新
+    };
+
+    typedef std::function<bool(const AttendanceRecord &record)> Visitor;//逐条处理记录 返回false时停止
+    typedef std::function<bool(QSqlDatabase &db, const QString &table, int month)> PartitionVisitor;//处理一个分区 db为分区所在的连接 返回false时停止
+
+    explicit AttendanceStore(const QSqlDatabase &db);
+
+    bool insert(const EmployeeRecord &employee, const QString &timestamp);//写入一条签到 分区不存在时创建 事务由调用方负责
+    void discardCache();//事务回滚后调用 丢弃可能未提交的员工快照和分区
+    bool page(const AttendanceFilter &filter, qint64 beforeId, int limit, QVector<AttendanceRecord> &records);//按主键倒序取一页 beforeId为0时从最新一条开始
+    bool scan(const AttendanceFilter &filter, const Visitor &visit);//按签到时间顺序遍历 visit返回false时提前结束(仍返回true)
+    qint64 count(const AttendanceFilter &filter);//符合条件的记录数 出错时返回-1
+    bool forEachPartition(const AttendanceFilter &filter, Order order, const PartitionVisitor &visit, int maxMonth = 0);//依次访问时间范围内(且不晚于maxMonth 0表示不限)的分区 归档分区用临时的只读连接打开
+
+    bool migrateLegacy(qint64 *rows);//把旧版 attendance 表(文本时间、每行重复字符串)分批搬进分区后删除 时间无法解析的记录移到 attendance_invalid 表 没有旧表时直接返回true
+    bool archive(const QString &directory, int keepMonths, QStringList *archived);//把保留期之前的分区写成只读归档文件并从主数据库删除 在事务之外调用
+    bool compact();//检查点并 VACUUM，回收删除分区和旧表后的空间 需要数据库没有其他写入
+    QString errorString() const;//最近一次失败的原因
+
+    static QString partitionTable(int month);//分区表名 attendance_yyyymm
+    static int monthOf(qint64 seconds);//所在月份 yyyymm
+    static qint64 toSeconds(const QString &timestamp);//"yyyy-MM-dd HH:mm:ss" 转换为本地时间秒数 格式错误时返回-1
+    static qint64 toSeconds(const QDateTime &time);//本地时间秒数
+    static QString toTimestamp(qint64 seconds);//本地时间秒数转换为 "yyyy-MM-dd HH:mm:ss"
+
+private:
+    struct Partition
+    {
+        int month;//yyyymm
+        QString archive;//归档文件路径 在主数据库中时为空
+    };
+
+    bool prepare();//预编译员工快照的查找和新增语句 第一次写入时调用
+    bool ensurePartition(int month);//创建分区表和目录项 月份已归档时返回false
+    qint64 personId(const EmployeeRecord &employee);//员工快照的主键 不存在时新增 失败时返回-1
+    bool partitions(const AttendanceFilter &filter, Order order, QVector<Partition> &result, int maxMonth = 0);//时间范围内(且不晚于maxMonth 0表示不限)的分区
+    static void conditions(const AttendanceFilter &filter, QStringList &where, QVariantList &values);//分区上的查询条件 部门和员工用子查询在分区所在的数据库中解析
+    static QString selectRecords(const QString &table, const QStringList &where);//查询一个分区的记录(与员工快照连接)
+    static AttendanceRecord readRecord(const QSqlQuery &query);//读取 selectRecords 的一行
+
+    QSqlDatabase db;//主数据库连接
+    QSqlQuery findPerson;//按全部字段查找员工快照
+    QSqlQuery addPerson;//新增员工快照
+    QHash<QString, qint64> people;//员工快照缓存 字段拼接 -> 主键
+    QSet<int> knownPartitions;//已确认存在的分区
+    QHash<int, QSqlQuery> inserts;//每个分区预编译的插入语句
+    bool prepared;//员工快照语句是否已预编译
+    QString error;//失败原因
+};
+
+#endif // ATTENDANCESTORE_H
@@ -0,0 +1,179 @@
+#include "attendancesummary.h"
+#include "attendancestore.h"
+#include <QSqlError>
+#include <QVariant>
+#include <QDebug>
+
+namespace {
+const int kWorkStartSeconds = 9 * 3600; // 上班时间 09:00:00
+
+// 按天和员工插入一行，已存在时累加：首次签到取较早者，末次签到取较晚者，迟到以首次签到为准
+const char *kUpsertDaily =
+        "INSERT INTO attendance_daily (day, employee_id, name, department, first_checkin, last_checkin, checkins, late) "
+        "VALUES (?, ?, ?, ?, ?, ?, 1, ?) "
+        "ON CONFLICT(day, employee_id) DO UPDATE SET "
+        "first_checkin = min(first_checkin, excluded.first_checkin), "
+        "last_checkin = max(last_checkin, excluded.last_checkin), "
+        "checkins = checkins + 1, "
+        "late = late AND excluded.late";
+
+// 部门汇总由员工日汇总聚合得到；一天的员工日汇总只有在岗人数那么多行，重算比逐条维护计数简单且不会出错
+const char *kDepartmentSelect =
+        "SELECT day, department, COUNT(*), SUM(checkins), SUM(late), SUM(first_checkin) FROM attendance_daily";
+}
+
+AttendanceSummary::AttendanceSummary(const QSqlDatabase &db)
+    : db(db)
+    , upsertDaily(db)
+    , clearDepartments(db)
+    , rebuildDepartments(db)
+{
+}
+
+bool AttendanceSummary::prepare() {
+    if (!upsertDaily.prepare(kUpsertDaily)
+            || !clearDepartments.prepare("DELETE FROM attendance_department_daily WHERE day = ?")
+            || !rebuildDepartments.prepare(QString("INSERT INTO attendance_department_daily "
+                                                   "(day, department, employees, checkins, late, arrival_total) "
+                                                   "%1 WHERE day = ? GROUP BY department").arg(kDepartmentSelect))) {
+        error = db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool AttendanceSummary::add(const EmployeeRecord &employee, const QString &timestamp) {
+    int seconds = secondsOfDay(timestamp);
+    if (seconds < 0) {
+        error = QString("invalid timestamp: %1").arg(timestamp);
+        return false;
+    }
+    QString day = timestamp.left(10);
+    upsertDaily.addBindValue(day);
+    upsertDaily.addBindValue(employee.employeeId);
+    upsertDaily.addBindValue(employee.name);
+    upsertDaily.addBindValue(employee.department.isNull() ? QString("") : employee.department);
+    upsertDaily.addBindValue(seconds);
+    upsertDaily.addBindValue(seconds);
+    upsertDaily.addBindValue(seconds > kWorkStartSeconds ? 1 : 0);
+    if (!upsertDaily.exec()) {
+        error = upsertDaily.lastError().text();
+        return false;
+    }
+    touchedDays.insert(day);
+    return true;
+}
+
+bool AttendanceSummary::flush() {
+    bool ok = true;
+    for (const QString &day : touchedDays) {
+        clearDepartments.addBindValue(day);
+        rebuildDepartments.addBindValue(day);
+        if (!clearDepartments.exec()) {
+            error = clearDepartments.lastError().text();
+            ok = false;
+        } else if (!rebuildDepartments.exec()) {
+            error = rebuildDepartments.lastError().text();
+            ok = false;
+        }
+    }
+    touchedDays.clear();
+    return ok;
+}
+
+void AttendanceSummary::discard() {
+    touchedDays.clear();
+}
+
+QString AttendanceSummary::errorString() const {
+    return error;
+}
+
+int AttendanceSummary::workStartSeconds() {
+    return kWorkStartSeconds;
+}
+
+int AttendanceSummary::secondsOfDay(const QString &timestamp) {
+    // 只解析固定位置的数字，比 QDateTime::fromString 快得多
+    if (timestamp.size() < 19 || timestamp.at(13) != ':' || timestamp.at(16) != ':') {
+        return -1;
+    }
+    bool hourOk = false, minuteOk = false, secondOk = false;
+    int hour = timestamp.midRef(11, 2).toInt(&hourOk);
+    int minute = timestamp.midRef(14, 2).toInt(&minuteOk);
+    int second = timestamp.midRef(17, 2).toInt(&secondOk);
+    if (!hourOk || !minuteOk || !secondOk) {
+        return -1;
+    }
+    return hour * 3600 + minute * 60 + second;
+}
+
+bool AttendanceSummary::backfill(QSqlDatabase &db, int *days, QString *error) {
+    QSqlQuery query(db);
+    db.transaction();
+    // 在一个事务中清空并重建，中途失败时汇总表保持原样
+    bool ok = query.exec("DELETE FROM attendance_daily")
+            && query.exec("DELETE FROM attendance_department_daily");
+
+    // 每个分区(含归档文件)在所在的数据库中分组聚合，结果写入主数据库；一天只会落在一个分区中
+    // 分区中的签到时间是本地时间秒数，按 UTC 解释即得到本地日期和当天秒数；同一天内员工的姓名和部门取其中任意一条记录的值
+    QSqlQuery insert(db);
+    if (ok) {
+        ok = insert.prepare("INSERT INTO attendance_daily (day, employee_id, name, department, first_checkin, last_checkin, checkins, late) "
+                            "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    }
+    QString storeError;
+    if (ok) {
+        AttendanceStore store(db);
+        bool partitionsOk = true;
+        ok = store.forEachPartition(AttendanceFilter(), AttendanceStore::OldestFirst, [&](QSqlDatabase &partitionDb, const QString &table, int) {
+            QSqlQuery grouped(partitionDb);
+            grouped.setForwardOnly(true);
+            if (!grouped.exec(QString("SELECT date(a.ts, 'unixepoch') AS day, p.employee_id, p.name, p.department, "
+                                   "min(a.ts % 86400), max(a.ts % 86400), COUNT(*) "
+                                   "FROM %1 a JOIN attendance_people p ON p.id = a.person "
+                                   "WHERE p.employee_id <> '' GROUP BY day, p.employee_id").arg(table))) {
+                storeError = grouped.lastError().text();
+                partitionsOk = false;
+                return false;
+            }
+            while (grouped.next()) {
+                int first = grouped.value(4).toInt();
+                for (int column = 0; column < 7; ++column) {
+                    insert.addBindValue(grouped.value(column));
+                }
+                insert.addBindValue(first > kWorkStartSeconds ? 1 : 0);
+                if (!insert.exec()) {
+                    storeError = insert.lastError().text();
+                    partitionsOk = false;
+                    return false;
+                }
+            }
+            return true;
+        }) && partitionsOk;
+        if (!ok && storeError.isEmpty()) {
+            storeError = store.errorString();
+        }
+    }
+    if (ok) {
+        ok = query.exec(QString("INSERT INTO attendance_department_daily "
+                                "(day, department, employees, checkins, late, arrival_total) "
+                                "%1 GROUP BY day, department").arg(kDepartmentSelect));
+    }
+    if (ok && days) {
+        ok = query.exec("SELECT COUNT(*) FROM attendance_daily") && query.next();
+        *days = ok ? query.value(0).toInt() : 0;
+    }
+
+    if (!ok || !db.commit()) {
+        QString message = !storeError.isEmpty() ? storeError
+                : query.lastError().isValid() ? query.lastError().text() : db.lastError().text();
+        if (error) {
+            *error = message;
+        }
+        qDebug() << "Error backfilling attendance summary:" << message;
+        db.rollback();
+        return false;
+    }
+    return true;
+}
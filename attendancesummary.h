@@ -0,0 +1,37 @@
+#ifndef ATTENDANCESUMMARY_H
+#define ATTENDANCESUMMARY_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSet>
+#include <QString>
+#include "facegallery.h"
+
+// 考勤汇总表：attendance_daily 按天和员工记录首次/末次签到时刻、签到次数和迟到标记，
+// attendance_department_daily 按天和部门记录出勤人数、签到次数、迟到人数和到岗时刻之和
+// 考勤写入线程在写入原始记录的同一个事务中增量更新，统计页面只读汇总表，报表耗时与原始签到记录数无关
+class AttendanceSummary
+{
+public:
+    explicit AttendanceSummary(const QSqlDatabase &db);
+
+    bool prepare();//预编译更新语句 在写入线程的连接上调用一次
+    bool add(const EmployeeRecord &employee, const QString &timestamp);//累加一条签到记录 部门汇总在flush时更新
+    bool flush();//重算本批次涉及日期的部门汇总 在提交事务之前调用
+    void discard();//事务回滚后丢弃本批次累加的日期
+    QString errorString() const;//最近一次失败的原因
+
+    static int workStartSeconds();//上班时刻(当天秒数) 首次签到晚于该时刻记为迟到
+    static int secondsOfDay(const QString &timestamp);//"yyyy-MM-dd HH:mm:ss" 中的时刻转换为当天秒数
+    static bool backfill(QSqlDatabase &db, int *days, QString *error);//从考勤表重建全部汇总 用于升级前的已有数据 days返回汇总的员工日数
+
+private:
+    QSqlDatabase db;//数据库连接(写入线程)
+    QSqlQuery upsertDaily;//插入或累加员工日汇总
+    QSqlQuery clearDepartments;//删除某天的部门汇总
+    QSqlQuery rebuildDepartments;//由员工日汇总重算某天的部门汇总
+    QSet<QString> touchedDays;//本批次涉及的日期
+    QString error;//失败原因
+};
+
+#endif // ATTENDANCESUMMARY_H
@@ -0,0 +1,252 @@
+#include "attendancewriter.h"
+#include "attendancestore.h"
+#include "attendancesummary.h"
+#include "metrics.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+const char *kConnectionName = "attendance_writer"; // 写入线程专用的连接名
+const int kMaxBatch = 256; // 每个事务最多写入的记录数
+const int kGroupCommitMs = 20; // 收到第一条记录后再等待的时间，让更多记录合并到同一个事务
+const int kMaxAttempts = 3; // 一条记录最多尝试写入的次数，之后放弃并报告
+const int kRetryDelayMs = 500; // 整批提交失败后重试前的等待时间
+}
+
+AttendanceWriter::AttendanceWriter(const QString &databasePath, QObject *parent)
+    : QThread(parent)
+    , databasePath(databasePath)
+    , debounceSeconds(60)
+    , stopping(false)
+    , notifications(nullptr)
+{
+}
+
+AttendanceWriter::~AttendanceWriter() {
+    stop();
+}
+
+bool AttendanceWriter::submit(const EmployeeRecord &employee, const QDateTime &time) {
+    qint64 now = time.toMSecsSinceEpoch();
+
+    QMutexLocker locker(&mutex);
+    // 防止频繁重复签到：每个员工单独计时，互不影响
+    auto it = lastCheckin.find(employee.employeeId);
+    if (it != lastCheckin.end() && now - it.value() < debounceSeconds * 1000LL) {
+        return false;
+    }
+    lastCheckin.insert(employee.employeeId, now);
+
+    Entry entry;
+    entry.employee = employee;
+    entry.checkinMs = now;
+    entry.timestamp = time.toString("yyyy-MM-dd HH:mm:ss");
+    pending.append(entry);
+    Metrics::instance().set(Metrics::DbQueueDepth, pending.size());
+    hasWork.wakeOne();
+    return true;
+}
+
+void AttendanceWriter::stop() {
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        hasWork.wakeAll();
+    }
+    wait();
+}
+
+void AttendanceWriter::setNotificationQueue(NotificationQueue *queue) {
+    notifications = queue;
+}
+
+void AttendanceWriter::setDebounceSeconds(int seconds) {
+    QMutexLocker locker(&mutex);
+    debounceSeconds = seconds;
+}
+
+int AttendanceWriter::queueDepth() const {
+    QMutexLocker locker(&mutex);
+    return pending.size();
+}
+
+void AttendanceWriter::run() {
+    {
+        // Qt 的数据库连接只能在创建它的线程中使用，写入线程使用自己的连接
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", kConnectionName);
+        db.setDatabaseName(databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (!db.open()) {
+            qDebug() << "Error opening attendance database:" << db.lastError().text();
+            emit writeFailed(db.lastError().text());
+            return;
+        }
+
+        // WAL 模式下读写互不阻塞，synchronous=NORMAL 在 WAL 下仍能保证数据库不损坏
+        QSqlQuery pragma(db);
+        pragma.exec("PRAGMA journal_mode=WAL");
+        pragma.exec("PRAGMA synchronous=NORMAL");
+
+        // 按月分区写入，每个分区的插入语句预编译一次，所有记录复用
+        AttendanceStore store(db);
+
+        // 汇总表与原始记录在同一个事务中更新；汇总更新失败与写入失败一样回滚整批并重试，保证两者一致
+        AttendanceSummary summary(db);
+        bool summaryReady = summary.prepare();
+        if (!summaryReady) {
+            qDebug() << "Error preparing attendance summary:" << summary.errorString();
+        }
+
+        forever {
+            QVector<Entry> batch;
+            {
+                QMutexLocker locker(&mutex);
+                while (pending.isEmpty() && !stopping) {
+                    hasWork.wait(&mutex);
+                }
+                if (pending.isEmpty() && stopping) {
+                    break;
+                }
+                // 等待一小段时间，把高峰期的签到合并到同一个事务中；每次 submit 都会唤醒，按截止时间继续等，直到时间到或攒满一批
+                QElapsedTimer groupTimer;
+                groupTimer.start();
+                while (!stopping && pending.size() < kMaxBatch && groupTimer.elapsed() < kGroupCommitMs) {
+                    hasWork.wait(&mutex, static_cast<unsigned long>(kGroupCommitMs - groupTimer.elapsed()));
+                }
+                if (pending.size() <= kMaxBatch) {
+                    batch.swap(pending);
+                } else {
+                    batch = pending.mid(0, kMaxBatch);
+                    pending.remove(0, kMaxBatch);
+                }
+                Metrics::instance().set(Metrics::DbQueueDepth, pending.size());
+            }
+
+            // 一个事务提交整批记录
+            QElapsedTimer commitTimer;
+            commitTimer.start();
+            int failed = -1;
+            QString error;
+            if (!commitBatch(db, store, summary, &summaryReady, batch, &failed, &error)) {
+                qDebug() << "Error recording attendance:" << error; // 记录签到信息出错
+                emit writeFailed(error);
+
+                // 整批回滚后放回队列重试，保证不丢记录；出错的记录(或整批提交失败时的每条记录)计一次失败，多次失败后才放弃
+                QVector<Entry> retry;
+                QVector<Entry> dropped;
+                for (int i = 0; i < batch.size(); ++i) {
+                    Entry entry = batch[i];
+                    if (failed < 0 || failed == i) {
+                        ++entry.attempts;
+                    }
+                    (entry.attempts >= kMaxAttempts ? dropped : retry).append(entry);
+                }
+
+                QMutexLocker locker(&mutex);
+                if (stopping && !retry.isEmpty()) {
+                    // 停止时不再排队等待，立即同步重试一次，仍然失败就放弃
+                    locker.unlock();
+                    msleep(failed < 0 ? kRetryDelayMs : 0);
+                    if (commitBatch(db, store, summary, &summaryReady, retry, &failed, &error)) {
+                        batch = retry;
+                        if (!dropped.isEmpty()) {
+                            locker.relock();
+                            abandon(dropped);
+                            locker.unlock();
+                            emit writeFailed(QString("dropped %1 attendance records on shutdown: %2").arg(dropped.size()).arg(error));
+                        }
+                    } else {
+                        locker.relock();
+                        abandon(retry + dropped);
+                        locker.unlock();
+                        qDebug() << "Dropping" << retry.size() + dropped.size() << "attendance records on shutdown:" << error;
+                        emit writeFailed(QString("dropped %1 attendance records on shutdown: %2").arg(retry.size() + dropped.size()).arg(error));
+                        continue;
+                    }
+                } else {
+                    abandon(dropped);
+                    pending = retry + pending;
+                    Metrics::instance().set(Metrics::DbQueueDepth, pending.size());
+                    locker.unlock();
+                    if (!dropped.isEmpty()) {
+                        emit writeFailed(QString("dropped %1 attendance records: %2").arg(dropped.size()).arg(error));
+                    }
+                    if (failed < 0) {
+                        msleep(kRetryDelayMs);
+                    }
+                    continue;
+                }
+            }
+            Metrics::instance().record(Metrics::DbCommit, commitTimer.nsecsElapsed());
+            Metrics::instance().add(Metrics::AttendanceWritten, batch.size());
+            for (const Entry &entry : batch) {
+                emit recorded(entry.employee, entry.timestamp);
+                if (notifications) {
+                    Notification notification;
+                    notification.kind = Notification::CheckedIn;
+                    notification.employee = entry.employee;
+                    notification.timestamp = entry.timestamp;
+                    if (!notifications->push(notification)) {
+                        Metrics::instance().add(Metrics::NotificationsDropped);
+                    }
+                }
+            }
+        }
+
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(kConnectionName);
+}
+
+bool AttendanceWriter::commitBatch(QSqlDatabase &db, AttendanceStore &store, AttendanceSummary &summary, bool *summaryReady,
+                                   const QVector<Entry> &batch, int *failed, QString *error) {
+    *failed = -1;
+    // 上次预编译失败(例如数据库被锁)时重新准备，仍然失败则整批稍后重试
+    if (!*summaryReady && !(*summaryReady = summary.prepare())) {
+        *error = summary.errorString();
+        return false;
+    }
+    db.transaction();
+    bool ok = true;
+    for (int i = 0; ok && i < batch.size(); ++i) {
+        const Entry &entry = batch[i];
+        if (!store.insert(entry.employee, entry.timestamp)) {
+            *error = store.errorString();
+            *failed = i;
+            ok = false;
+        } else if (!summary.add(entry.employee, entry.timestamp)) {
+            *error = summary.errorString();
+            *failed = i;
+            ok = false;
+        }
+    }
+    if (ok && !summary.flush()) {
+        *error = summary.errorString();
+        ok = false;
+    }
+    if (ok && !db.commit()) {
+        *error = db.lastError().text();
+        ok = false;
+    }
+    if (!ok) {
+        db.rollback();
+        store.discardCache();
+        summary.discard();
+    }
+    return ok;
+}
+
+void AttendanceWriter::abandon(const QVector<Entry> &entries) {
+    // 放弃的记录不占用去重间隔，员工可以立即重新签到
+    for (const Entry &entry : entries) {
+        auto it = lastCheckin.find(entry.employee.employeeId);
+        if (it != lastCheckin.end() && it.value() == entry.checkinMs) {
+            lastCheckin.erase(it);
+        }
+        qDebug() << "Giving up on attendance record:" << entry.employee.employeeId << entry.timestamp;
+    }
+    Metrics::instance().add(Metrics::AttendanceFailed, entries.size());
+}
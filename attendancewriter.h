@@ -0,0 +1,63 @@
+#ifndef ATTENDANCEWRITER_H
+#define ATTENDANCEWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QDateTime>
+#include <QVector>
+#include "facegallery.h"
+#include "notification.h"
+
+class AttendanceStore;
+class AttendanceSummary;
+class QSqlDatabase;
+
+// 考勤写入线程：使用独立的数据库连接，按批次在一个事务中提交签到记录
+// 任意线程都可以调用 submit，重复签到在内存中按员工去重，不访问数据库
+class AttendanceWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit AttendanceWriter(const QString &databasePath, QObject *parent = nullptr);
+    ~AttendanceWriter();
+
+    bool submit(const EmployeeRecord &employee, const QDateTime &time = QDateTime::currentDateTime());//提交一条签到 在去重间隔内重复签到时返回false
+    void stop();//写完队列中剩余的记录后停止
+    void setDebounceSeconds(int seconds);//同一员工两次签到的最小间隔(秒)
+    int queueDepth() const;//等待写入的记录数
+    void setNotificationQueue(NotificationQueue *queue);//写入成功后发布签到通知的队列 在start之前调用
+
+signals:
+    void recorded(const EmployeeRecord &employee, const QString &timestamp);//签到记录已写入数据库
+    void writeFailed(const QString &error);//写入失败
+
+protected:
+    void run() override;
+
+private:
+    struct Entry
+    {
+        EmployeeRecord employee;//员工信息
+        QString timestamp;//签到时间
+        qint64 checkinMs = 0;//签到时间(毫秒) 放弃写入时用来撤销去重
+        int attempts = 0;//写入失败的次数
+    };
+
+    bool commitBatch(QSqlDatabase &db, AttendanceStore &store, AttendanceSummary &summary, bool *summaryReady,
+                     const QVector<Entry> &batch, int *failed, QString *error);//在一个事务中写入整批记录和汇总 任一失败时回滚 failed为出错记录的下标(整批失败时为-1)
+    void abandon(const QVector<Entry> &entries);//放弃多次写入失败的记录 撤销去重并计数 调用时持有mutex
+
+    QString databasePath;//数据库文件路径
+    mutable QMutex mutex;//保护以下成员
+    QWaitCondition hasWork;//有新记录或要求停止
+    QVector<Entry> pending;//等待写入的记录，不设上限，保证不丢记录
+    QHash<QString, qint64> lastCheckin;//员工编号 -> 上次签到时间(毫秒)
+    int debounceSeconds;//去重间隔
+    bool stopping;//是否要求停止
+    NotificationQueue *notifications;//通知队列
+};
+
+#endif // ATTENDANCEWRITER_H
@@ -0,0 +1,47 @@
+#-------------------------------------------------
+#
+# 微基准测试：与主程序分开构建，复用主程序的源文件
+# 在 Qt Creator 中单独打开本文件，或 qmake benchmark/benchmark.pro
+#
+#-------------------------------------------------
+
+QT       += core gui
+QT += sql
+
+TARGET = OpenCV_Face_bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 主程序的源文件在上一级目录
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+        benchmarkrunner.cpp \
+        kernelbenchmarks.cpp \
+        main.cpp \
+        ../attendancestore.cpp \
+        ../attendancesummary.cpp \
+        ../databaseschema.cpp \
+        ../facedetector.cpp \
+        ../facematcher.cpp \
+        ../galleryindex.cpp
+
+HEADERS += \
+        benchmarkrunner.h \
+        kernelbenchmarks.h \
+        ../attendancestore.h \
+        ../attendancesummary.h \
+        ../databaseschema.h \
+        ../facedetector.h \
+        ../facematcher.h \
+        ../galleryindex.h
+
+
+INCLUDEPATH +=D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\include \
+              D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\include \
+              D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\include\opencv2
+
+LIBS +=D:\opencv3.4.0\OpenCV-MinGW-Build-OpenCV-3.4.5\x86\mingw\bin\libopencv_*.dll
@@ -0,0 +1,238 @@
+#include "benchmarkrunner.h"
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace {
+double percentileUs(const std::vector<qint64> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)] / 1000.0;
+}
+
+// 读取一个结果文件 键 -> 结果，保持文件中的顺序
+bool readResults(const QString &path, QStringList &order, QHash<QString, BenchmarkResult> &results) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    while (!file.atEnd()) {
+        QJsonObject object = QJsonDocument::fromJson(file.readLine()).object();
+        if (!object.contains("benchmark")) {
+            continue; // 运行环境说明或空行
+        }
+        BenchmarkResult result = BenchmarkResult::fromJson(object);
+        if (!results.contains(result.key())) {
+            order.append(result.key());
+        }
+        results.insert(result.key(), result);
+    }
+    return true;
+}
+}
+
+QString BenchmarkResult::key() const {
+    // QVariantMap 按参数名排序，键与参数的书写顺序无关
+    QStringList parts;
+    for (auto it = params.begin(); it != params.end(); ++it) {
+        parts.append(it.key() + "=" + it.value().toString());
+    }
+    return name + " " + parts.join(",");
+}
+
+QJsonObject BenchmarkResult::toJson() const {
+    QJsonObject object;
+    object["benchmark"] = name;
+    object["params"] = QJsonObject::fromVariantMap(params);
+    object["iterations"] = iterations;
+    object["mean_us"] = meanUs;
+    object["min_us"] = minUs;
+    object["p50_us"] = p50Us;
+    object["p90_us"] = p90Us;
+    object["p99_us"] = p99Us;
+    object["items_per_sec"] = itemsPerSecond;
+    if (!observed.isEmpty()) {
+        object["observed"] = QJsonObject::fromVariantMap(observed);
+    }
+    return object;
+}
+
+BenchmarkResult BenchmarkResult::fromJson(const QJsonObject &object) {
+    BenchmarkResult result;
+    result.name = object.value("benchmark").toString();
+    result.params = object.value("params").toObject().toVariantMap();
+    result.iterations = static_cast<qint64>(object.value("iterations").toDouble());
+    result.meanUs = object.value("mean_us").toDouble();
+    result.minUs = object.value("min_us").toDouble();
+    result.p50Us = object.value("p50_us").toDouble();
+    result.p90Us = object.value("p90_us").toDouble();
+    result.p99Us = object.value("p99_us").toDouble();
+    result.itemsPerSecond = object.value("items_per_sec").toDouble();
+    result.observed = object.value("observed").toObject().toVariantMap();
+    return result;
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions &options)
+    : options(options)
+    , output(nullptr)
+{
+}
+
+void BenchmarkRunner::setOutput(QTextStream *out) {
+    output = out;
+}
+
+void BenchmarkRunner::writeHeader(const QVariantMap &environment) {
+    if (!output) {
+        return;
+    }
+    QJsonObject object;
+    object["environment"] = QJsonObject::fromVariantMap(environment);
+    *output << QJsonDocument(object).toJson(QJsonDocument::Compact) << "\n";
+    output->flush();
+}
+
+bool BenchmarkRunner::enabled(const QString &name) const {
+    return options.filter.isEmpty() || name.contains(options.filter);
+}
+
+BenchmarkResult BenchmarkRunner::run(const QString &name, const QVariantMap &params, int threads, const Setup &setup,
+                                     int itemsPerCall, const QVariantMap &observed) {
+    threads = std::max(1, threads);
+    BenchmarkResult result;
+    result.name = name;
+    result.params = params;
+    result.params["threads"] = threads;
+    result.observed = observed;
+
+    std::vector<std::vector<qint64>> samples(threads);
+    std::vector<qint64> loopNanos(threads, 0);
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(threads == 1);
+
+    auto worker = [&](int thread) {
+        Body body = setup(thread);
+        for (int i = 0; i < options.warmupIterations; ++i) {
+            body();
+        }
+        // 所有线程都准备好后同时开始计时
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+            QThread::yieldCurrentThread();
+        }
+
+        std::vector<qint64> &times = samples[thread];
+        QElapsedTimer loop;
+        loop.start();
+        while (loop.nsecsElapsed() < options.minTimeMs * 1e6 || static_cast<int>(times.size()) < options.minIterations) {
+            QElapsedTimer call;
+            call.start();
+            body();
+            times.push_back(call.nsecsElapsed());
+        }
+        loopNanos[thread] = loop.nsecsElapsed();
+        body = Body(); // 在测试线程中释放数据，数据库连接只能在创建它的线程中使用
+    };
+
+    if (threads == 1) {
+        worker(0);
+    } else {
+        std::vector<std::unique_ptr<QThread>> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back(QThread::create([&worker, t]() { worker(t); }));
+            workers.back()->start();
+        }
+        while (ready.load() < threads) {
+            QThread::msleep(1);
+        }
+        go.store(true, std::memory_order_release);
+        for (auto &thread : workers) {
+            thread->wait();
+        }
+    }
+
+    // 合并所有线程的耗时；吞吐量按每个线程各自的计时区间累加
+    std::vector<qint64> all;
+    for (int t = 0; t < threads; ++t) {
+        all.insert(all.end(), samples[t].begin(), samples[t].end());
+        if (loopNanos[t] > 0) {
+            result.itemsPerSecond += samples[t].size() * static_cast<double>(itemsPerCall) * 1e9 / loopNanos[t];
+        }
+    }
+    std::sort(all.begin(), all.end());
+    double sum = 0.0;
+    for (qint64 t : all) {
+        sum += t;
+    }
+    result.iterations = static_cast<qint64>(all.size());
+    result.meanUs = all.empty() ? 0.0 : sum / all.size() / 1000.0;
+    result.minUs = percentileUs(all, 0.0);
+    result.p50Us = percentileUs(all, 0.5);
+    result.p90Us = percentileUs(all, 0.9);
+    result.p99Us = percentileUs(all, 0.99);
+
+    finished.push_back(result);
+    if (output) {
+        *output << QJsonDocument(result.toJson()).toJson(QJsonDocument::Compact) << "\n";
+        output->flush();
+    }
+    return result;
+}
+
+const std::vector<BenchmarkResult> &BenchmarkRunner::results() const {
+    return finished;
+}
+
+int BenchmarkRunner::compare(const QString &baselinePath, const QString &currentPath, double tolerance, QTextStream &out) {
+    QStringList baselineOrder;
+    QStringList currentOrder;
+    QHash<QString, BenchmarkResult> baseline;
+    QHash<QString, BenchmarkResult> current;
+    if (!readResults(baselinePath, baselineOrder, baseline)) {
+        out << "cannot read " << baselinePath << "\n";
+        return -1;
+    }
+    if (!readResults(currentPath, currentOrder, current)) {
+        out << "cannot read " << currentPath << "\n";
+        return -1;
+    }
+
+    // 中位数受偶发的调度抖动影响最小，用它判断快慢
+    int regressions = 0;
+    for (const QString &key : currentOrder) {
+        const BenchmarkResult &now = current.value(key);
+        if (!baseline.contains(key)) {
+            out << key << "  new  p50=" << QString::number(now.p50Us, 'f', 2) << "us\n";
+            continue;
+        }
+        const BenchmarkResult &before = baseline.value(key);
+        double change = before.p50Us > 0 ? now.p50Us / before.p50Us - 1.0 : 0.0;
+        QString verdict;
+        if (change > tolerance) {
+            verdict = "  REGRESSION";
+            ++regressions;
+        } else if (change < -tolerance) {
+            verdict = "  improved";
+        }
+        if (before.observed != now.observed) {
+            verdict += "  observed changed"; // 输出不同，耗时可能不可比
+        }
+        out << key << "  p50 " << QString::number(before.p50Us, 'f', 2) << "us -> " << QString::number(now.p50Us, 'f', 2) << "us"
+            << "  (" << (change >= 0 ? "+" : "") << QString::number(change * 100.0, 'f', 1) << "%)" << verdict << "\n";
+    }
+    for (const QString &key : baselineOrder) {
+        if (!current.contains(key)) {
+            out << key << "  missing\n";
+        }
+    }
+    out << regressions << " regression(s) over " << QString::number(tolerance * 100.0, 'f', 0) << "%\n";
+    return regressions;
+}
@@ -0,0 +1,64 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QJsonObject>
+#include <QTextStream>
+#include <functional>
+#include <vector>
+
+// 一项基准测试的结果，输出为一行JSON
+struct BenchmarkResult
+{
+    QString name;//测试名称 如 "match/topk"
+    QVariantMap params;//参数(人脸库大小、分辨率、线程数等) 与名称一起作为比较两次运行时的键
+    qint64 iterations = 0;//计时的调用次数(所有线程合计)
+    double meanUs = 0.0;//每次调用的平均耗时(微秒)
+    double minUs = 0.0;//最短耗时
+    double p50Us = 0.0;//耗时中位数
+    double p90Us = 0.0;//耗时90分位
+    double p99Us = 0.0;//耗时99分位
+    double itemsPerSecond = 0.0;//吞吐量(所有线程合计，每次调用处理的条目数由测试指定)
+    QVariantMap observed;//被测代码的输出(如检测到的人脸数) 参数变化导致结果变化时便于发现 不参与耗时比较
+
+    QString key() const;//名称和参数组成的键
+    QJsonObject toJson() const;//转换为JSON对象
+    static BenchmarkResult fromJson(const QJsonObject &object);//从JSON对象读取
+};
+
+// 基准测试运行参数
+struct BenchmarkOptions
+{
+    double minTimeMs = 500.0;//每项测试至少计时的时间(毫秒)
+    int minIterations = 10;//每个线程至少计时的调用次数
+    int warmupIterations = 3;//每个线程计时前的预热次数
+    QString filter;//只运行名称包含该字符串的测试 为空时全部运行
+};
+
+// 微基准测试运行器：每个线程先在计时之外准备自己的数据，预热后同时开始，记录每次调用的耗时
+// 结果按行写出JSON(JSON Lines)，不同版本的输出可以直接比较，找出变慢的测试
+class BenchmarkRunner
+{
+public:
+    typedef std::function<void()> Body;//被测的一次调用
+    typedef std::function<Body(int thread)> Setup;//在测试线程中准备数据并返回被测调用 不计时
+
+    explicit BenchmarkRunner(const BenchmarkOptions &options = BenchmarkOptions());
+
+    void setOutput(QTextStream *out);//每完成一项测试写出一行结果 为空时不写
+    void writeHeader(const QVariantMap &environment);//写出一行运行环境说明(编译器、库版本、线程数等)
+    bool enabled(const QString &name) const;//名称是否匹配过滤条件
+    BenchmarkResult run(const QString &name, const QVariantMap &params, int threads, const Setup &setup,
+                        int itemsPerCall = 1, const QVariantMap &observed = QVariantMap());//运行一项测试 threads为1时在当前线程运行
+    const std::vector<BenchmarkResult> &results() const;//已完成的测试结果
+
+    static int compare(const QString &baselinePath, const QString &currentPath, double tolerance, QTextStream &out);//按中位数比较两次运行 返回变慢超过容差的测试数 文件读取失败时返回-1
+
+private:
+    BenchmarkOptions options;//运行参数
+    QTextStream *output;//结果输出
+    std::vector<BenchmarkResult> finished;//已完成的测试结果
+};
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,332 @@
+#include "kernelbenchmarks.h"
+#include "attendancestore.h"
+#include "attendancesummary.h"
+#include "databaseschema.h"
+#include "facedetector.h"
+#include "facematcher.h"
+#include "galleryindex.h"
+#include <QImage>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <memory>
+
+namespace {
+const int kDimension = 128; // 与DNN人脸特征维数相同
+const int kTopK = 5; // 与识别时取的候选数相同
+const int kQueryCount = 256; // 每项搜索测试循环使用的探针数
+const int kEmployees = 1000; // 写入测试中的员工数
+const int kTimestamps = 20000; // 写入测试预先生成的签到时间数(每3秒一条，跨越几天，用完后循环)
+
+// Haar检测参数组合，第一组为界面的默认值
+struct DetectParams
+{
+    double scaleFactor;//金字塔缩放比例
+    int minNeighbors;//最少相邻检测数
+    int minFaceSize;//最小人脸边长(原始帧像素)
+    double detectionScale;//检测分辨率相对原始帧的比例
+};
+
+const DetectParams kDetectParams[] = {
+    {1.1, 3, 40, 1.0},
+    {1.2, 3, 40, 1.0},
+    {1.3, 3, 40, 1.0},
+    {1.1, 5, 40, 1.0},
+    {1.1, 3, 80, 1.0},
+    {1.1, 3, 40, 0.5}
+};
+
+cv::Mat unitRows(cv::RNG &rng, int rows, int dimension) {
+    cv::Mat features(rows, dimension, CV_32F);
+    rng.fill(features, cv::RNG::NORMAL, 0, 1);
+    for (int i = 0; i < rows; ++i) {
+        cv::Mat row = features.row(i);
+        cv::normalize(row, row);
+    }
+    return features;
+}
+
+QString resolutionText(const cv::Size &size) {
+    return QString("%1x%2").arg(size.width).arg(size.height);
+}
+
+// 按高度等比缩放样例人脸，贴到以center为中心的位置(超出画面的部分裁掉)
+void paste(const cv::Mat &sample, cv::Mat &frame, const cv::Point &center, int height) {
+    int width = std::max(1, cvRound(sample.cols * static_cast<double>(height) / sample.rows));
+    cv::Mat scaled;
+    cv::resize(sample, scaled, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+    cv::Rect target(center.x - width / 2, center.y - height / 2, width, height);
+    cv::Rect visible = target & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (visible.area() > 0) {
+        scaled(cv::Rect(visible.x - target.x, visible.y - target.y, visible.width, visible.height)).copyTo(frame(visible));
+    }
+}
+
+// 一个写入测试的连接和预编译语句，做法与考勤写入线程相同
+struct InsertState
+{
+    QSqlDatabase db;//写入连接
+    std::unique_ptr<AttendanceStore> store;//按月分区写入
+    std::unique_ptr<AttendanceSummary> summary;//汇总表 为空时只写原始记录
+    std::vector<EmployeeRecord> employees;//预先生成的员工
+    QStringList timestamps;//预先生成的签到时间
+    qint64 next = 0;//下一条记录的序号
+};
+}
+
+void KernelBenchmarks::match(BenchmarkRunner &runner, const std::vector<int> &gallerySizes, const std::vector<int> &threadCounts) {
+    if (!runner.enabled("match/topk") && !runner.enabled("match/int8")) {
+        return;
+    }
+    for (int size : gallerySizes) {
+        cv::RNG rng(size);
+        cv::Mat features = unitRows(rng, size, kDimension);
+        std::vector<int> ids(size);
+        for (int i = 0; i < size; ++i) {
+            ids[i] = i;
+        }
+
+        // 探针为库中员工加噪声，与真实识别时得分最高的几个候选分布相近
+        cv::Mat queries(kQueryCount, kDimension, CV_32F);
+        for (int i = 0; i < kQueryCount; ++i) {
+            cv::Mat noise(1, kDimension, CV_32F);
+            rng.fill(noise, cv::RNG::NORMAL, 0, 0.1);
+            cv::Mat q = features.row(rng.uniform(0, size)) + noise;
+            cv::normalize(q, q);
+            q.copyTo(queries.row(i));
+        }
+
+        QuantizedIndex int8(GalleryIndex::Int8);
+        int8.setFeatureSource([&features](int id) { return features.row(id); });
+        int8.build(features, ids);
+
+        QVariantMap params;
+        params["gallery"] = size;
+        params["dim"] = kDimension;
+        params["k"] = kTopK;
+        for (int threads : threadCounts) {
+            if (runner.enabled("match/topk")) {
+                runner.run("match/topk", params, threads, [&](int thread) -> BenchmarkRunner::Body {
+                    int next = thread * 37;
+                    return [&features, &queries, next]() mutable {
+                        FaceMatcher::topK(features, queries.row(next++ % kQueryCount), kTopK);
+                    };
+                });
+            }
+            if (runner.enabled("match/int8")) {
+                runner.run("match/int8", params, threads, [&](int thread) -> BenchmarkRunner::Body {
+                    int next = thread * 37;
+                    return [&int8, &queries, next]() mutable {
+                        int8.search(queries.row(next++ % kQueryCount), kTopK);
+                    };
+                });
+            }
+        }
+    }
+}
+
+void KernelBenchmarks::detect(BenchmarkRunner &runner, const QString &cascadePath, const cv::Mat &sample,
+                              const std::vector<cv::Size> &resolutions, const std::vector<int> &threadCounts) {
+    if (!runner.enabled("detect/haar")) {
+        return;
+    }
+    for (const cv::Size &resolution : resolutions) {
+        cv::Mat frame = syntheticFrame(sample, resolution);
+        for (const DetectParams &p : kDetectParams) {
+            // 与 FrameAnalyzer 相同：缩小检测时最小人脸按比例缩小
+            DetectorConfig config;
+            config.cascadePath = cascadePath;
+            config.scaleFactor = p.scaleFactor;
+            config.minNeighbors = p.minNeighbors;
+            config.minFaceSize = cvRound(p.minFaceSize * p.detectionScale);
+            double scale = p.detectionScale;
+
+            std::unique_ptr<FaceDetector> probe(FaceDetector::create(config));
+            if (!probe) {
+                QTextStream(stderr) << "skipping detect/haar: cannot load " << cascadePath << "\n";
+                return;
+            }
+            cv::Mat work = frame;
+            if (scale < 1.0) {
+                cv::resize(frame, work, cv::Size(), scale, scale, cv::INTER_AREA);
+            }
+            QVariantMap observed;
+            observed["faces"] = static_cast<int>(probe->detect(work).size()); // 参数改变检测结果时在比较中标出
+
+            QVariantMap params;
+            params["resolution"] = resolutionText(resolution);
+            params["scale_factor"] = p.scaleFactor;
+            params["min_neighbors"] = p.minNeighbors;
+            params["min_size"] = p.minFaceSize;
+            params["detect_scale"] = p.detectionScale;
+            for (int threads : threadCounts) {
+                // 每个线程一个检测器，检测器不是线程安全的；缩放计入耗时
+                runner.run("detect/haar", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    std::shared_ptr<FaceDetector> detector(FaceDetector::create(config));
+                    cv::Mat small;
+                    return [&frame, detector, scale, small]() mutable {
+                        if (scale < 1.0) {
+                            cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+                            detector->detect(small);
+                        } else {
+                            detector->detect(frame);
+                        }
+                    };
+                }, 1, observed);
+            }
+        }
+    }
+}
+
+void KernelBenchmarks::convert(BenchmarkRunner &runner, const cv::Mat &sample, const std::vector<cv::Size> &resolutions, const std::vector<int> &threadCounts) {
+    for (const cv::Size &resolution : resolutions) {
+        cv::Mat frame = syntheticFrame(sample, resolution);
+        QVariantMap params;
+        params["resolution"] = resolutionText(resolution);
+        for (int threads : threadCounts) {
+            // 每帧新分配RGB图像并深拷贝为QImage，最初的预览做法
+            if (runner.enabled("convert/cvtcolor_copy")) {
+                runner.run("convert/cvtcolor_copy", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    return [&frame]() {
+                        cv::Mat rgb;
+                        cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+                        QImage image = QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+                        Q_UNUSED(image);
+                    };
+                });
+            }
+            // 转换到重复使用的缓冲区后包装，Qt 5.14 以前 PreviewView 的做法
+            if (runner.enabled("convert/cvtcolor_wrap")) {
+                runner.run("convert/cvtcolor_wrap", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    cv::Mat rgb;
+                    return [&frame, rgb]() mutable {
+                        cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+                        QImage image(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888);
+                        Q_UNUSED(image);
+                    };
+                });
+            }
+            // 按RGB包装后由Qt交换红蓝通道
+            if (runner.enabled("convert/rgbswapped")) {
+                runner.run("convert/rgbswapped", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    return [&frame]() {
+                        QImage image = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_RGB888).rgbSwapped();
+                        Q_UNUSED(image);
+                    };
+                });
+            }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+            // 直接包装BGR数据(当前 PreviewView 的做法)；绘制时由Qt转换为屏幕格式，第二项测量这部分开销
+            if (runner.enabled("convert/bgr888_wrap")) {
+                runner.run("convert/bgr888_wrap", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    return [&frame]() {
+                        QImage image(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_BGR888);
+                        Q_UNUSED(image);
+                    };
+                });
+            }
+            if (runner.enabled("convert/bgr888_rgb32")) {
+                runner.run("convert/bgr888_rgb32", params, threads, [&](int) -> BenchmarkRunner::Body {
+                    return [&frame]() {
+                        QImage image = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_BGR888)
+                                .convertToFormat(QImage::Format_RGB32);
+                        Q_UNUSED(image);
+                    };
+                });
+            }
+#endif
+        }
+    }
+}
+
+void KernelBenchmarks::insert(BenchmarkRunner &runner) {
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "skipping insert: cannot create temporary directory\n";
+        return;
+    }
+
+    const int batchSizes[] = {1, 16, 256};
+    const bool summaryModes[] = {false, true};
+    for (bool withSummary : summaryModes) {
+        QString name = withSummary ? "insert/attendance_summary" : "insert/attendance";
+        if (!runner.enabled(name)) {
+            continue;
+        }
+        for (int batch : batchSizes) {
+            // 每项测试使用新的数据库，表的大小不受前面测试的影响
+            QString connectionName = QString("benchmark_%1_%2").arg(withSummary ? "summary" : "plain").arg(batch);
+            QString path = dir.filePath(connectionName + ".db");
+            QVariantMap params;
+            params["batch"] = batch;
+            runner.run(name, params, 1, [&](int) -> BenchmarkRunner::Body {
+                std::shared_ptr<InsertState> state(new InsertState);
+                state->db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+                state->db.setDatabaseName(path);
+                if (!state->db.open() || !DatabaseSchema::create(state->db)) {
+                    QTextStream(stderr) << "insert: cannot create database " << path << ": " << state->db.lastError().text() << "\n";
+                }
+                QSqlQuery pragma(state->db);
+                pragma.exec("PRAGMA synchronous=NORMAL"); // 与考勤写入线程相同
+                state->store.reset(new AttendanceStore(state->db));
+                if (withSummary) {
+                    state->summary.reset(new AttendanceSummary(state->db));
+                    state->summary->prepare();
+                }
+
+                // 员工信息和签到时间在计时之外生成，写入线程收到的也是已经格式化好的记录
+                for (int i = 0; i < kEmployees; ++i) {
+                    EmployeeRecord employee;
+                    employee.employeeId = QString("E%1").arg(i, 5, 10, QChar('0'));
+                    employee.name = QString("员工%1").arg(i);
+                    employee.department = QString("部门%1").arg(i % 10);
+                    employee.faceImage = QString("D:/code/qt_project/OpenCV_Face/faces/%1.png").arg(employee.employeeId);
+                    state->employees.push_back(employee);
+                }
+                QDateTime start(QDate(2024, 1, 1), QTime(8, 0));
+                for (int i = 0; i < kTimestamps; ++i) {
+                    state->timestamps.append(start.addSecs(i * 3).toString("yyyy-MM-dd HH:mm:ss"));
+                }
+
+                return [state, batch]() {
+                    state->db.transaction();
+                    for (int i = 0; i < batch; ++i) {
+                        int n = static_cast<int>(state->next++ % kTimestamps);
+                        const EmployeeRecord &employee = state->employees[n % kEmployees];
+                        const QString &timestamp = state->timestamps[n % kTimestamps];
+                        state->store->insert(employee, timestamp);
+                        if (state->summary) {
+                            state->summary->add(employee, timestamp);
+                        }
+                    }
+                    if (state->summary) {
+                        state->summary->flush();
+                    }
+                    state->db.commit();
+                };
+            }, batch);
+            QSqlDatabase::removeDatabase(connectionName);
+        }
+    }
+}
+
+cv::Mat KernelBenchmarks::syntheticFrame(const cv::Mat &sample, const cv::Size &size) {
+    // 低频噪声纹理，比纯色背景更接近真实画面(纯色区域会被级联的第一级直接拒绝)
+    cv::RNG rng(20230713);
+    cv::Mat noise(size.height / 8 + 1, size.width / 8 + 1, CV_8UC3);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat frame;
+    cv::resize(noise, frame, size, 0, 0, cv::INTER_LINEAR);
+    cv::GaussianBlur(frame, frame, cv::Size(5, 5), 0);
+
+    // 一张大脸居中，一张小脸在左上，覆盖检测金字塔的不同层
+    if (!sample.empty()) {
+        paste(sample, frame, cv::Point(size.width / 2, size.height / 2), size.height / 2);
+        paste(sample, frame, cv::Point(size.width / 6, size.height / 4), size.height / 6);
+    }
+    return frame;
+}
@@ -0,0 +1,23 @@
+#ifndef KERNELBENCHMARKS_H
+#define KERNELBENCHMARKS_H
+
+#include <QString>
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "benchmarkrunner.h"
+
+// 识别和存储热点的微基准测试：人脸库搜索、Haar检测参数、预览帧颜色转换、考勤写入
+// 数据都由固定种子生成或来自随仓库提供的样例图像，同一台机器上多次运行的结果可以直接比较
+class KernelBenchmarks
+{
+public:
+    static void match(BenchmarkRunner &runner, const std::vector<int> &gallerySizes, const std::vector<int> &threadCounts);//精确搜索与int8量化搜索 每个线程模拟一个识别线程
+    static void detect(BenchmarkRunner &runner, const QString &cascadePath, const cv::Mat &sample,
+                       const std::vector<cv::Size> &resolutions, const std::vector<int> &threadCounts);//不同分辨率和检测参数下的Haar检测 每个线程模拟一路摄像头
+    static void convert(BenchmarkRunner &runner, const cv::Mat &sample, const std::vector<cv::Size> &resolutions, const std::vector<int> &threadCounts);//BGR帧转换为QImage的几种做法
+    static void insert(BenchmarkRunner &runner);//考勤写入线程的事务：不同批大小，是否同时更新汇总表
+
+    static cv::Mat syntheticFrame(const cv::Mat &sample, const cv::Size &size);//把样例人脸贴在固定种子生成的纹理背景上 样例为空时只有背景
+};
+
+#endif // KERNELBENCHMARKS_H
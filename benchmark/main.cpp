@@ -0,0 +1,150 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QDateTime>
+#include <QThread>
+#include <QTextStream>
+#include <QStringList>
+#include "benchmarkrunner.h"
+#include "kernelbenchmarks.h"
+
+namespace {
+const char *kSamplePath = "D:/code/qt_project/OpenCV_Face/stu1.png"; // 随仓库提供的样例人脸
+const char *kCascadePath = "D:/code/qt_project/OpenCV_Face/haarcascade_frontalface_default.xml"; // 与界面相同的Haar分类器
+}
+
+// 查找 "--name 值" 形式的参数，不存在时返回空字符串
+static QString optionValue(int argc, char *argv[], const char *name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (qstrcmp(argv[i], name) == 0) {
+            return QString::fromLocal8Bit(argv[i + 1]);
+        }
+    }
+    return QString();
+}
+
+// 逗号分隔的整数列表 参数不存在时返回默认值
+static std::vector<int> intList(int argc, char *argv[], const char *name, const std::vector<int> &defaults) {
+    QString text = optionValue(argc, argv, name);
+    if (text.isEmpty()) {
+        return defaults;
+    }
+    std::vector<int> values;
+    for (const QString &item : text.split(',', QString::SkipEmptyParts)) {
+        if (item.toInt() > 0) {
+            values.push_back(item.toInt());
+        }
+    }
+    return values.empty() ? defaults : values;
+}
+
+// 逗号分隔的分辨率列表，如 640x480,1280x720
+static std::vector<cv::Size> sizeList(int argc, char *argv[], const char *name, const std::vector<cv::Size> &defaults) {
+    QString text = optionValue(argc, argv, name);
+    if (text.isEmpty()) {
+        return defaults;
+    }
+    std::vector<cv::Size> values;
+    for (const QString &item : text.split(',', QString::SkipEmptyParts)) {
+        QStringList parts = item.split('x');
+        if (parts.size() == 2 && parts[0].toInt() > 0 && parts[1].toInt() > 0) {
+            values.push_back(cv::Size(parts[0].toInt(), parts[1].toInt()));
+        }
+    }
+    return values.empty() ? defaults : values;
+}
+
+// OpenCV_Face_bench [--suite match,detect,convert,insert] [--filter 名称] [--threads 1,2,4] [--gallery-sizes 100,1000,10000,100000]
+//                   [--resolutions 640x480,1280x720,1920x1080] [--min-time 毫秒] [--cv-threads N] [--sample 图像] [--cascade 分类器] [--out 结果.jsonl]
+// OpenCV_Face_bench --compare <基准.jsonl> <当前.jsonl> [--tolerance 0.1]
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+
+    // 比较两次运行的结果，中位数变慢超过容差时返回非0，便于在构建脚本中使用
+    for (int i = 1; i + 2 < argc; ++i) {
+        if (qstrcmp(argv[i], "--compare") == 0) {
+            double tolerance = optionValue(argc, argv, "--tolerance").isEmpty() ? 0.1 : optionValue(argc, argv, "--tolerance").toDouble();
+            QTextStream out(stdout);
+            int regressions = BenchmarkRunner::compare(QString::fromLocal8Bit(argv[i + 1]), QString::fromLocal8Bit(argv[i + 2]), tolerance, out);
+            return regressions == 0 ? 0 : 1;
+        }
+    }
+
+    BenchmarkOptions options;
+    options.filter = optionValue(argc, argv, "--filter");
+    if (optionValue(argc, argv, "--min-time").toDouble() > 0) {
+        options.minTimeMs = optionValue(argc, argv, "--min-time").toDouble();
+    }
+    QStringList suites = QString("match,detect,convert,insert").split(',');
+    if (!optionValue(argc, argv, "--suite").isEmpty()) {
+        suites = optionValue(argc, argv, "--suite").split(',', QString::SkipEmptyParts);
+    }
+    std::vector<int> threadCounts = intList(argc, argv, "--threads", {1, 2, 4});
+    std::vector<int> gallerySizes = intList(argc, argv, "--gallery-sizes", {100, 1000, 10000, 100000});
+    std::vector<cv::Size> resolutions = sizeList(argc, argv, "--resolutions", {cv::Size(640, 480), cv::Size(1280, 720), cv::Size(1920, 1080)});
+
+    // OpenCV内部并行默认关闭，线程数由测试参数决定，结果不随机器核数漂移
+    int cvThreads = optionValue(argc, argv, "--cv-threads").isEmpty() ? 1 : optionValue(argc, argv, "--cv-threads").toInt();
+    cv::setNumThreads(cvThreads);
+
+    QString samplePath = optionValue(argc, argv, "--sample").isEmpty() ? QString(kSamplePath) : optionValue(argc, argv, "--sample");
+    QString cascadePath = optionValue(argc, argv, "--cascade").isEmpty() ? QString(kCascadePath) : optionValue(argc, argv, "--cascade");
+    cv::Mat sample = cv::imread(samplePath.toStdString());
+    if (sample.empty()) {
+        err << "cannot read sample image " << samplePath << ", frames contain background only\n";
+    }
+
+    QFile file;
+    QTextStream out(stdout);
+    QString outPath = optionValue(argc, argv, "--out");
+    if (!outPath.isEmpty()) {
+        file.setFileName(outPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+            err << "cannot write " << outPath << "\n";
+            return 1;
+        }
+        out.setDevice(&file);
+    }
+    out.setCodec("UTF-8");
+
+    BenchmarkRunner runner(options);
+    runner.setOutput(&out);
+
+    // 运行环境写在第一行，比较结果前先确认两次运行的条件相同
+    QVariantMap environment;
+    environment["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    environment["qt"] = QString(qVersion());
+    environment["opencv"] = QString(CV_VERSION);
+#ifdef __VERSION__
+    environment["compiler"] = QString(__VERSION__);
+#endif
+#ifdef QT_NO_DEBUG
+    environment["build"] = "release";
+#else
+    environment["build"] = "debug";
+#endif
+    environment["cpus"] = QThread::idealThreadCount();
+    environment["cv_threads"] = cv::getNumThreads();
+    environment["min_time_ms"] = options.minTimeMs;
+    environment["sample"] = sample.empty() ? QString() : samplePath;
+    runner.writeHeader(environment);
+
+    if (suites.contains("match")) {
+        err << "match...\n";
+        KernelBenchmarks::match(runner, gallerySizes, threadCounts);
+    }
+    if (suites.contains("detect")) {
+        err << "detect...\n";
+        KernelBenchmarks::detect(runner, cascadePath, sample, resolutions, threadCounts);
+    }
+    if (suites.contains("convert")) {
+        err << "convert...\n";
+        KernelBenchmarks::convert(runner, sample, resolutions, threadCounts);
+    }
+    if (suites.contains("insert")) {
+        err << "insert...\n";
+        KernelBenchmarks::insert(runner);
+    }
+    err << runner.results().size() << " benchmarks finished\n";
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <deque>
+
+// 有界队列，用于连接流水线各级
+// 队列满时丢弃最旧的元素，保证下游处理不过来时延迟仍然有上限
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int capacity = 2)
+        : capacity(capacity > 0 ? capacity : 1)
+        , closed(false)
+        , dropped(0)
+    {
+    }
+
+    // 放入一个元素 队列已满时丢弃最旧的元素 返回是否发生了丢弃
+    bool push(const T &item) {
+        QMutexLocker locker(&mutex);
+        if (closed) {
+            return false;
+        }
+        bool droppedOldest = false;
+        while (static_cast<int>(items.size()) >= capacity) {
+            items.pop_front();
+            ++dropped;
+            droppedOldest = true;
+        }
+        items.push_back(item);
+        notEmpty.wakeOne();
+        return droppedOldest;
+    }
+
+    // 取出最旧的元素 队列为空时最多等待timeoutMs毫秒 超时或队列关闭时返回false
+    bool pop(T &item, int timeoutMs) {
+        QMutexLocker locker(&mutex);
+        if (items.empty() && !closed) {
+            notEmpty.wait(&mutex, static_cast<unsigned long>(timeoutMs));
+        }
+        if (items.empty()) {
+            return false;
+        }
+        item = items.front();
+        items.pop_front();
+        return true;
+    }
+
+    // 不等待，取出最新的元素并丢弃其余元素（界面只需要显示最新一帧）
+    bool takeLatest(T &item) {
+        QMutexLocker locker(&mutex);
+        if (items.empty()) {
+            return false;
+        }
+        item = items.back();
+        items.clear();
+        return true;
+    }
+
+    // 关闭队列并唤醒所有等待者，之后push被忽略
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        items.clear();
+        notEmpty.wakeAll();
+    }
+
+    // 队列是否已关闭
+    bool isClosed() const {
+        QMutexLocker locker(&mutex);
+        return closed;
+    }
+
+    // 重新打开已关闭的队列
+    void reopen() {
+        QMutexLocker locker(&mutex);
+        closed = false;
+    }
+
+    int size() const {
+        QMutexLocker locker(&mutex);
+        return static_cast<int>(items.size());
+    }
+
+    quint64 droppedCount() const {
+        QMutexLocker locker(&mutex);
+        return dropped;
+    }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    std::deque<T> items;
+    int capacity;//最大容量
+    bool closed;//是否已关闭
+    quint64 dropped;//累计丢弃的元素个数
+};
+
+#endif // BOUNDEDQUEUE_H
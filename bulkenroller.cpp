@@ -0,0 +1,368 @@
+#include "bulkenroller.h"
+#include "faceembedder.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+
+namespace {
+const int kDetectSize = 640; // 照片长边超过该值时缩小后再检测，人脸仍从原图裁剪
+const char *kPhotoExtensions[] = {"jpg", "jpeg", "png", "bmp"};
+}
+
+QString BulkEnrollReport::toString() const {
+    QString text;
+    QTextStream out(&text);
+    double totalMs = extractMs + commitMs;
+    out << "employees:       " << rows << "\n";
+    out << "enrolled:        " << enrolled << "\n";
+    out << "duplicate id:    " << duplicateId << "\n";
+    out << "missing photo:   " << missingPhoto << "\n";
+    out << "no face:         " << noFace << "\n";
+    out << "multiple faces:  " << multipleFaces << "\n";
+    out << "low quality:     " << lowQuality << "\n";
+    out << "other failed:    " << otherFailed << "\n";
+    out << "database failed: " << databaseFailed << "\n";
+    out << "threads:         " << threads << "\n";
+    out << "extract:         " << QString::number(extractMs / 1000.0, 'f', 2) << " s\n";
+    out << "commit:          " << QString::number(commitMs / 1000.0, 'f', 2) << " s\n";
+    out << "throughput:      " << QString::number(totalMs > 0.0 ? rows * 1000.0 / totalMs : 0.0, 'f', 1) << " employees/s\n";
+    if (!failures.isEmpty()) {
+        out << "failures:\n";
+        for (const QString &failure : failures) {
+            out << "  " << failure << "\n";
+        }
+    }
+    return text;
+}
+
+BulkEnroller::BulkEnroller(const BulkEnrollConfig &config)
+    : config(config)
+    , nextJob(0)
+    , processed(0)
+{
+}
+
+int BulkEnroller::defaultThreadCount() {
+    return qMax(1, QThread::idealThreadCount());
+}
+
+bool BulkEnroller::run(QSqlDatabase &db, FaceGallery *gallery) {
+    if (!load(db)) {
+        return false;
+    }
+    extract();
+    return commit(db, gallery);
+}
+
+bool BulkEnroller::load(const QSqlDatabase &db) {
+    QFile file(config.csvPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "cannot open " + config.csvPath;
+        return false;
+    }
+
+    // 已录入的员工编号，重复时不覆盖
+    QSet<QString> seen;
+    QSqlQuery query(db);
+    if (query.exec("SELECT employee_id FROM employees")) {
+        while (query.next()) {
+            seen.insert(query.value(0).toString());
+        }
+    } else {
+        qDebug() << "Error reading enrolled employees:" << query.lastError().text();
+    }
+
+    jobs.clear();
+    result = BulkEnrollReport();
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    bool firstLine = true;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = parseCsvLine(line);
+        if (firstLine) {
+            firstLine = false;
+            if (fields.value(0).compare("employee_id", Qt::CaseInsensitive) == 0) {
+                continue; // 表头
+            }
+        }
+        if (fields.value(0).isEmpty()) {
+            continue;
+        }
+
+        ++result.rows;
+        Job job;
+        job.record.employeeId = fields.value(0);
+        job.record.name = fields.value(1);
+        job.record.department = fields.value(2);
+        if (seen.contains(job.record.employeeId)) {
+            ++result.duplicateId;
+            result.failures << job.record.employeeId + ": duplicate employee id";
+            continue;
+        }
+        seen.insert(job.record.employeeId);
+
+        job.photoPath = findPhoto(job.record.employeeId, fields.value(3));
+        if (job.photoPath.isEmpty()) {
+            ++result.missingPhoto;
+            result.failures << job.record.employeeId + ": photo not found";
+            continue;
+        }
+        job.record.faceImage = QDir(config.faceDir).filePath(job.record.employeeId + ".jpg");
+        job.tempImage = QDir(config.faceDir).filePath(job.record.employeeId + ".new.jpg");
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+void BulkEnroller::extract() {
+    QElapsedTimer timer;
+    timer.start();
+    nextJob = 0;
+    processed = 0;
+
+    int threadCount = config.threadCount > 0 ? config.threadCount : defaultThreadCount();
+    threadCount = qBound(1, threadCount, qMax(1, static_cast<int>(jobs.size())));
+    result.threads = threadCount;
+
+    // 每个线程依次领取下一个员工，照片大小不一时负载仍然均衡
+    auto work = [this]() {
+        std::unique_ptr<FaceDetector> detector(FaceDetector::create(config.detectorConfig));
+        FaceQualityScorer scorer(config.qualityConfig);
+        FaceEmbedder embedder;
+        embedder.load(config.embeddingModelPath, config.detectorConfig.dnnBackend, config.detectorConfig.dnnTarget);
+        int i;
+        while ((i = nextJob++) < static_cast<int>(jobs.size())) {
+            if (detector) {
+                process(jobs[i], *detector, scorer, embedder);
+            } else {
+                jobs[i].outcome = Job::Failed;
+                jobs[i].failure = "cannot load face detector";
+            }
+            ++processed;
+        }
+    };
+
+    std::vector<QThread *> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.push_back(QThread::create(work));
+        threads.back()->start();
+    }
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    result.extractMs = timer.nsecsElapsed() / 1e6;
+}
+
+void BulkEnroller::process(Job &job, FaceDetector &detector, FaceQualityScorer &scorer, FaceEmbedder &embedder) {
+    cv::Mat photo = cv::imread(job.photoPath.toStdString());
+    if (photo.empty()) {
+        job.outcome = Job::MissingPhoto;
+        job.failure = "cannot read photo";
+        return;
+    }
+
+    // 大照片缩小后检测，人脸框换算回原图坐标
+    double scale = std::min(1.0, static_cast<double>(kDetectSize) / std::max(photo.cols, photo.rows));
+    cv::Mat small = photo;
+    if (scale < 1.0) {
+        cv::resize(photo, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    std::vector<cv::Rect> faces = detector.detect(small);
+    if (faces.empty()) {
+        job.outcome = Job::NoFace;
+        job.failure = "no face found";
+        return;
+    }
+    if (faces.size() > 1) {
+        job.outcome = Job::MultipleFaces;
+        job.failure = QString("%1 faces found").arg(faces.size());
+        return;
+    }
+
+    cv::Rect face(cvRound(faces[0].x / scale), cvRound(faces[0].y / scale), cvRound(faces[0].width / scale), cvRound(faces[0].height / scale));
+    cv::Mat faceROI = photo(face & cv::Rect(0, 0, photo.cols, photo.rows));
+    if (scorer.config().enabled) {
+        FaceQuality quality = scorer.evaluate(faceROI);
+        if (!quality.acceptable()) {
+            job.outcome = Job::LowQuality;
+            job.failure = "low quality: " + quality.reasonText();
+            return;
+        }
+    }
+    job.feature = embedder.extract(faceROI);
+    if (job.feature.empty()) {
+        job.outcome = Job::Failed;
+        job.failure = "cannot extract feature";
+        return;
+    }
+
+    // 与界面录入相同，人脸图像以RGB顺序保存；先写临时文件，写入数据库成功后才替换正式文件
+    cv::Mat faceRGB;
+    cv::cvtColor(faceROI, faceRGB, cv::COLOR_BGR2RGB);
+    if (!cv::imwrite(job.tempImage.toStdString(), faceRGB)) {
+        QFile::remove(job.tempImage);
+        job.outcome = Job::Failed;
+        job.failure = "cannot save face image";
+        return;
+    }
+    job.outcome = Job::Extracted;
+}
+
+bool BulkEnroller::commit(QSqlDatabase &db, FaceGallery *gallery) {
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<int> rowIds;
+    std::vector<EmployeeRecord> records;
+    std::vector<cv::Mat> features;
+    std::vector<const Job *> written;
+
+    // 删除未能写入数据库的员工的临时人脸图像
+    auto discardImages = [this]() {
+        for (const Job &job : jobs) {
+            if (job.outcome == Job::Extracted) {
+                QFile::remove(job.tempImage);
+            }
+        }
+    };
+
+    // 所有员工在一个事务中写入，只同步一次磁盘
+    if (!db.transaction()) {
+        error = "cannot begin transaction: " + db.lastError().text();
+        discardImages();
+        return false;
+    }
+    // 载入名单后其他人可能已录入同一员工编号，这时不覆盖已有员工，按重复编号跳过并报告
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO employees (employee_id, name, department, face_image) VALUES (?, ?, ?, ?) "
+                  "ON CONFLICT(employee_id) DO NOTHING");
+    for (Job &job : jobs) {
+        if (job.outcome != Job::Extracted) {
+            switch (job.outcome) {
+            case Job::MissingPhoto: ++result.missingPhoto; break;
+            case Job::NoFace: ++result.noFace; break;
+            case Job::MultipleFaces: ++result.multipleFaces; break;
+            case Job::LowQuality: ++result.lowQuality; break;
+            default: ++result.otherFailed; break;
+            }
+            result.failures << job.record.employeeId + ": " + job.failure;
+            continue;
+        }
+
+        query.addBindValue(job.record.employeeId); // 员工编号
+        query.addBindValue(job.record.name); // 姓名
+        query.addBindValue(job.record.department); // 部门
+        query.addBindValue(job.record.faceImage); // 人脸图像文件名
+        if (!query.exec()) {
+            ++result.databaseFailed;
+            result.failures << job.record.employeeId + ": " + query.lastError().text();
+            continue;
+        }
+        if (query.numRowsAffected() == 0) {
+            ++result.duplicateId;
+            result.failures << job.record.employeeId + ": duplicate employee id";
+            continue;
+        }
+        rowIds.push_back(query.lastInsertId().toInt());
+        records.push_back(job.record);
+        features.push_back(job.feature);
+        written.push_back(&job);
+    }
+    if (!db.commit()) {
+        error = "cannot commit employees: " + db.lastError().text();
+        db.rollback();
+        discardImages();
+        return false;
+    }
+    result.enrolled = static_cast<int>(rowIds.size());
+
+    // 事务已提交，临时人脸图像改为正式文件名；未写入的员工删除临时文件
+    for (const Job *job : written) {
+        QFile::remove(job->record.faceImage);
+        if (!QFile::rename(job->tempImage, job->record.faceImage)) {
+            qDebug() << "Error saving face image:" << job->record.faceImage;
+        }
+    }
+    discardImages();
+
+    // 人脸库只更新一次
+    if (gallery) {
+        gallery->addEmployees(rowIds, records, features);
+    }
+    result.commitMs = timer.nsecsElapsed() / 1e6;
+    jobs.clear();
+    return true;
+}
+
+int BulkEnroller::progress() const {
+    return processed;
+}
+
+int BulkEnroller::total() const {
+    return static_cast<int>(jobs.size());
+}
+
+const BulkEnrollReport &BulkEnroller::report() const {
+    return result;
+}
+
+QString BulkEnroller::errorString() const {
+    return error;
+}
+
+QString BulkEnroller::findPhoto(const QString &employeeId, const QString &fileName) const {
+    QDir dir(config.photoDir);
+    if (!fileName.isEmpty()) {
+        QString path = dir.filePath(fileName);
+        return QFileInfo::exists(path) ? path : QString();
+    }
+    for (const char *extension : kPhotoExtensions) {
+        QString path = dir.filePath(employeeId + "." + extension);
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+QStringList BulkEnroller::parseCsvLine(const QString &line) {
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        QChar c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"'; // 引号内的两个双引号表示一个双引号
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields << field.trimmed();
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields << field.trimmed();
+    return fields;
+}
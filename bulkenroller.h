@@ -0,0 +1,101 @@
+#ifndef BULKENROLLER_H
+#define BULKENROLLER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSqlDatabase>
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+#include "facedetector.h"
+#include "facegallery.h"
+#include "facequality.h"
+
+// 批量录入参数
+struct BulkEnrollConfig
+{
+    QString photoDir;//照片目录 照片名为员工编号(jpg/jpeg/png/bmp)
+    QString csvPath;//员工名单 每行 employee_id,name,department[,照片文件名] 第一行可以是表头
+    QString faceDir;//裁剪后的人脸图像保存目录
+    QString embeddingModelPath;//人脸特征提取模型路径
+    DetectorConfig detectorConfig;//人脸检测器配置
+    QualityConfig qualityConfig;//人脸质量门限 质量不合格的照片不录入
+    int threadCount = 0;//并行线程数 0表示使用全部核心
+};
+
+// 批量录入结果
+struct BulkEnrollReport
+{
+    int rows = 0;//名单中的员工数
+    int enrolled = 0;//成功录入的员工数
+    int duplicateId = 0;//员工编号在名单中重复或已录入(包括提交时才发现已录入的)
+    int missingPhoto = 0;//找不到或无法读取照片
+    int noFace = 0;//照片中没有检测到人脸
+    int multipleFaces = 0;//照片中检测到多张人脸
+    int lowQuality = 0;//人脸质量不合格(模糊、过小、曝光不当)
+    int otherFailed = 0;//特征提取或保存人脸图像失败
+    int databaseFailed = 0;//写入数据库失败
+    int threads = 0;//实际使用的线程数
+    double extractMs = 0.0;//并行检测和特征提取耗时(毫秒)
+    double commitMs = 0.0;//数据库事务和人脸库更新耗时(毫秒)
+    QStringList failures;//每个失败员工一行 "员工编号: 原因"
+
+    QString toString() const;//格式化为文本报告
+};
+
+// 批量录入：从照片目录和员工名单一次录入大量员工
+// 检测、裁剪和特征提取按员工分给多个线程并行执行(每个线程自己的检测器和特征提取器)
+// 全部完成后在一个事务中写入 employees 表，并一次性更新内存人脸库
+// load 和 commit 在数据库连接所属的线程调用，extract 可在任意线程调用
+class BulkEnroller
+{
+public:
+    explicit BulkEnroller(const BulkEnrollConfig &config);
+
+    bool run(QSqlDatabase &db, FaceGallery *gallery);//依次执行 load、extract、commit 返回是否成功
+    bool load(const QSqlDatabase &db);//读取员工名单并排除重复的员工编号 返回是否成功
+    void extract();//并行检测人脸并提取特征
+    bool commit(QSqlDatabase &db, FaceGallery *gallery);//在一个事务中写入员工信息 gallery不为空时一次性更新 返回是否成功
+
+    int progress() const;//已处理的照片数
+    int total() const;//待处理的照片数
+    const BulkEnrollReport &report() const;//录入结果
+    QString errorString() const;//失败原因
+
+    static int defaultThreadCount();//默认线程数：全部核心
+
+private:
+    // 一个待录入的员工
+    struct Job
+    {
+        enum Outcome {
+            Pending,//尚未处理
+            Extracted,//已提取特征
+            MissingPhoto,//无法读取照片
+            NoFace,//没有检测到人脸
+            MultipleFaces,//检测到多张人脸
+            LowQuality,//人脸质量不合格
+            Failed//其他错误
+        };
+
+        EmployeeRecord record;//员工信息 faceImage为裁剪后人脸的保存路径
+        QString tempImage;//人脸图像的临时文件 事务提交后才改名为faceImage
+        QString photoPath;//原始照片路径
+        cv::Mat feature;//提取的特征 失败时为空
+        Outcome outcome = Pending;//处理结果
+        QString failure;//失败原因 成功时为空
+    };
+
+    void process(Job &job, FaceDetector &detector, FaceQualityScorer &scorer, FaceEmbedder &embedder);//处理一个员工的照片
+    QString findPhoto(const QString &employeeId, const QString &fileName) const;//按文件名或员工编号查找照片
+    static QStringList parseCsvLine(const QString &line);//拆分一行CSV 支持双引号包围的字段
+
+    BulkEnrollConfig config;//录入参数
+    BulkEnrollReport result;//录入结果
+    QString error;//失败原因
+    std::vector<Job> jobs;//待录入的员工
+    std::atomic<int> nextJob;//下一个待处理的员工下标
+    std::atomic<int> processed;//已处理的员工数
+};
+
+#endif // BULKENROLLER_H
@@ -0,0 +1,149 @@
+#include "capturethread.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QDebug>
+
+void FramePacket::buildPyramid(const std::vector<double> &scales) {
+    levels.clear();
+    levelScales.clear();
+    const cv::Mat *previous = &frame;
+    double previousScale = 1.0;
+    for (double scale : scales) {
+        if (scale <= 0.0 || scale >= previousScale) {
+            continue;
+        }
+        // 由上一层缩小，比每层都从原始帧缩小更省时
+        cv::Mat resized;
+        cv::Size size(qMax(1, cvRound(frame.cols * scale)), qMax(1, cvRound(frame.rows * scale)));
+        cv::resize(*previous, resized, size, 0, 0, cv::INTER_AREA);
+        levels.push_back(resized);
+        levelScales.push_back(scale);
+        previous = &levels.back();
+        previousScale = scale;
+    }
+}
+
+const cv::Mat &FramePacket::level(double scale, double *actualScale) const {
+    for (int i = static_cast<int>(levels.size()) - 1; i >= 0; --i) {
+        if (levelScales[i] >= scale - 1e-6) {
+            if (actualScale) {
+                *actualScale = levelScales[i];
+            }
+            return levels[i];
+        }
+    }
+    if (actualScale) {
+        *actualScale = 1.0;
+    }
+    return frame;
+}
+
+CaptureThread::CaptureThread(int cameraId, const QString &source, QObject *parent)
+    : QThread(parent)
+    , cameraId(cameraId)
+    , source(source)
+    , analysisQueue(nullptr)
+    , previewQueue(nullptr)
+    , analysisEnabled(false)
+{
+}
+
+bool CaptureThread::isDeviceIndex(const QString &source) {
+    bool isNumber = false;
+    source.toInt(&isNumber);
+    return isNumber;
+}
+
+void CaptureThread::setQueues(FairQueue<FramePacket> *analysisQueue, BoundedQueue<FramePacket> *previewQueue) {
+    this->analysisQueue = analysisQueue;
+    this->previewQueue = previewQueue;
+}
+
+void CaptureThread::setAnalysisEnabled(bool enabled) {
+    analysisEnabled = enabled;
+}
+
+void CaptureThread::setPyramidScales(const std::vector<double> &scales) {
+    pyramidScales = scales;
+}
+
+cv::Mat CaptureThread::latestFrame() const {
+    QMutexLocker locker(&frameMutex);
+    return lastFrame;
+}
+
+void CaptureThread::run() {
+    // 在采集线程中打开视频源
+    bool isDevice = isDeviceIndex(source);
+    cv::VideoCapture cap;
+    if (isDevice) {
+        cap.open(source.toInt());
+    } else {
+        cap.open(source.toStdString());
+    }
+    if (!cap.isOpened()) {
+        qDebug() << "Error opening video stream or file" << source;
+        emit openFailed(cameraId);
+        return;
+    }
+    emit opened(cameraId);
+
+    // 视频文件按原始帧率读取，模拟摄像头；摄像头和网络流由设备本身控制速度
+    double fps = isDevice ? 0.0 : cap.get(cv::CAP_PROP_FPS);
+    qint64 frameIntervalMs = fps > 0.0 ? static_cast<qint64>(1000.0 / fps) : 0;
+    qint64 nextDue = QDateTime::currentMSecsSinceEpoch();
+
+    Metrics::CameraStats &stats = Metrics::instance().camera(cameraId);
+    qint64 sequence = 0;
+    while (!isInterruptionRequested()) {
+        if (frameIntervalMs > 0) {
+            qint64 wait = nextDue - QDateTime::currentMSecsSinceEpoch();
+            if (wait > 0) {
+                msleep(static_cast<unsigned long>(wait));
+            }
+            nextDue += frameIntervalMs;
+        }
+
+        // 每次读取到新的Mat，已放入队列的帧不会被覆盖
+        cv::Mat frame;
+        {
+            ScopedTimer timer(Metrics::Capture);
+            cap >> frame;
+        }
+        if (frame.empty()) {
+            if (!isDevice) {
+                // 视频文件播放完后从头循环
+                cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+                nextDue = QDateTime::currentMSecsSinceEpoch();
+            }
+            msleep(10);
+            continue;
+        }
+        Metrics::instance().add(Metrics::FramesCaptured);
+        stats.captured.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            QMutexLocker locker(&frameMutex);
+            lastFrame = frame;
+        }
+
+        FramePacket packet;
+        packet.frame = frame;
+        packet.cameraId = cameraId;
+        packet.sequence = sequence++;
+        packet.captureTime = QDateTime::currentMSecsSinceEpoch();
+
+        bool dropped = false;
+        if (analysisEnabled && analysisQueue) {
+            // 缩小的图像在采集线程中生成，与识别线程并行
+            packet.buildPyramid(pyramidScales);
+            dropped = analysisQueue->push(cameraId, packet); // 识别线程处理完再送去预览
+        } else if (previewQueue) {
+            dropped = previewQueue->push(packet);
+        }
+        if (dropped) {
+            Metrics::instance().add(Metrics::FramesDropped);
+            stats.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef CAPTURETHREAD_H
+#define CAPTURETHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+#include "boundedqueue.h"
+#include "fairqueue.h"
+
+// 在流水线中传递的一帧图像
+struct FramePacket
+{
+    cv::Mat frame;//BGR原始帧，放入队列后不再修改
+    int cameraId = 0;//摄像头编号
+    qint64 sequence = 0;//帧序号
+    qint64 captureTime = 0;//采集时间(毫秒)
+    std::vector<cv::Rect> faces;//检测到的人脸区域(原始帧坐标)，由识别线程填写
+    std::vector<cv::Mat> levels;//分辨率金字塔，levels[i]为原始帧按levelScales[i]缩小的图像
+    std::vector<double> levelScales;//各层相对原始帧的缩放比例 从大到小
+
+    void buildPyramid(const std::vector<double> &scales);//按给定比例(从大到小)生成金字塔 每层由上一层缩小
+    const cv::Mat &level(double scale, double *actualScale = nullptr) const;//比例不小于scale的最小一层 没有时返回原始帧
+};
+
+// 采集线程：从一个视频源读取帧，每个摄像头一个线程
+// 检测开启时把帧送入分析队列(以摄像头编号为通道)，否则直接送入该摄像头的预览队列
+class CaptureThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    CaptureThread(int cameraId, const QString &source, QObject *parent = nullptr);
+
+    static bool isDeviceIndex(const QString &source);//视频源是否为摄像头编号(否则为文件或网络地址)
+
+    void setQueues(FairQueue<FramePacket> *analysisQueue, BoundedQueue<FramePacket> *previewQueue);//设置输出队列
+    void setAnalysisEnabled(bool enabled);//设置是否把帧送去分析
+    void setPyramidScales(const std::vector<double> &scales);//送去分析的帧额外生成的金字塔层 启动前设置
+    cv::Mat latestFrame() const;//获取最近采集到的一帧(录入时使用)
+
+signals:
+    void opened(int cameraId);//摄像头已打开
+    void openFailed(int cameraId);//摄像头打开失败
+
+protected:
+    void run() override;
+
+private:
+    int cameraId;//摄像头编号(流水线内的序号)
+    QString source;//视频源：摄像头编号、视频文件或网络地址
+    FairQueue<FramePacket> *analysisQueue;//分析队列(多个摄像头共用)
+    BoundedQueue<FramePacket> *previewQueue;//预览队列
+    std::atomic<bool> analysisEnabled;//是否送去分析
+    std::vector<double> pyramidScales;//金字塔各层的缩放比例
+    mutable QMutex frameMutex;//保护lastFrame
+    cv::Mat lastFrame;//最近采集到的一帧
+};
+
+#endif // CAPTURETHREAD_H
@@ -0,0 +1,245 @@
+#include "dashboardview.h"
+#include "attendancesummary.h"
+#include <QtCharts/QChart>
+#include <QtCharts/QBarSet>
+#include <QtCharts/QBarSeries>
+#include <QtCharts/QStackedBarSeries>
+#include <QtCharts/QBarCategoryAxis>
+#include <QtCharts/QValueAxis>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QElapsedTimer>
+#include <QTime>
+#include <QDebug>
+#include <algorithm>
+
+QT_CHARTS_USE_NAMESPACE
+
+namespace {
+const int kLateTableRows = 10; // 迟到排行显示的员工数
+
+// 当天秒数显示为 HH:mm
+QString clockText(double seconds) {
+    return QTime(0, 0).addSecs(static_cast<int>(seconds + 0.5)).toString("HH:mm");
+}
+
+// 换掉图表中的序列和坐标轴
+void resetChart(QChart *chart) {
+    chart->removeAllSeries();
+    for (QAbstractAxis *axis : chart->axes()) {
+        chart->removeAxis(axis);
+        delete axis;
+    }
+}
+}
+
+DashboardView::DashboardView(const QSqlDatabase &db, QWidget *parent)
+    : QWidget(parent)
+    , db(db)
+{
+    QHBoxLayout *filterLayout = new QHBoxLayout;
+    monthEdit = new QDateEdit(QDate::currentDate(), this);
+    monthEdit->setDisplayFormat("yyyy-MM");
+    monthEdit->setCalendarPopup(true);
+    departmentCombo = new QComboBox(this);
+    QPushButton *refreshButton = new QPushButton("统计", this);
+    refreshButton->setStyleSheet("background-color: #4CAF50; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
+    filterLayout->addWidget(new QLabel("月份", this));
+    filterLayout->addWidget(monthEdit);
+    filterLayout->addWidget(departmentCombo);
+    filterLayout->addWidget(refreshButton);
+    filterLayout->addStretch();
+
+    totalsLabel = new QLabel(this);
+
+    dailyChartView = new QChartView(new QChart, this);
+    dailyChartView->setRenderHint(QPainter::Antialiasing);
+    dailyChartView->chart()->setTitle("每日出勤");
+    departmentChartView = new QChartView(new QChart, this);
+    departmentChartView->setRenderHint(QPainter::Antialiasing);
+    departmentChartView->chart()->setTitle("部门出勤");
+
+    lateTable = new QTableWidget(0, 4, this);
+    lateTable->setHorizontalHeaderLabels(QStringList() << "员工编号" << "姓名" << "迟到天数" << "平均到岗");
+    lateTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    lateTable->verticalHeader()->setVisible(false);
+    lateTable->horizontalHeader()->setStretchLastSection(true);
+
+    QHBoxLayout *lowerLayout = new QHBoxLayout;
+    lowerLayout->addWidget(departmentChartView, 3);
+    lowerLayout->addWidget(lateTable, 2);
+
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->addLayout(filterLayout);
+    layout->addWidget(totalsLabel);
+    layout->addWidget(dailyChartView, 1);
+    layout->addLayout(lowerLayout, 1);
+    setLayout(layout);
+
+    connect(refreshButton, &QPushButton::clicked, this, &DashboardView::refresh);
+}
+
+void DashboardView::refresh() {
+    QElapsedTimer timer;
+    timer.start();
+
+    loadDepartments();
+    QDate month(monthEdit->date().year(), monthEdit->date().month(), 1);
+    QString from = month.toString("yyyy-MM-dd");
+    QString to = month.addMonths(1).addDays(-1).toString("yyyy-MM-dd");
+    QString department = departmentCombo->currentIndex() > 0 ? departmentCombo->currentText() : QString();
+
+    updateDailyChart(from, to, department);
+    updateDepartmentChart(from, to);
+    updateLateTable(from, to, department);
+
+    totalsLabel->setText(totalsLabel->text() + QString("    查询耗时 %1 ms").arg(timer.elapsed()));
+}
+
+void DashboardView::loadDepartments() {
+    // 部门列表来自员工表，切换月份时保留当前选择
+    QString current = departmentCombo->currentText();
+    departmentCombo->blockSignals(true);
+    departmentCombo->clear();
+    departmentCombo->addItem("全部部门");
+    QSqlQuery query(db);
+    if (query.exec("SELECT DISTINCT department FROM employees WHERE department <> '' ORDER BY department")) {
+        while (query.next()) {
+            departmentCombo->addItem(query.value(0).toString());
+        }
+    }
+    int index = departmentCombo->findText(current);
+    departmentCombo->setCurrentIndex(index > 0 ? index : 0);
+    departmentCombo->blockSignals(false);
+}
+
+void DashboardView::updateDailyChart(const QString &from, const QString &to, const QString &department) {
+    QSqlQuery query(db);
+    query.prepare(QString("SELECT day, SUM(employees), SUM(late), SUM(arrival_total) FROM attendance_department_daily "
+                          "WHERE day BETWEEN ? AND ? %1 GROUP BY day ORDER BY day")
+                  .arg(department.isEmpty() ? "" : "AND department = ?"));
+    query.addBindValue(from);
+    query.addBindValue(to);
+    if (!department.isEmpty()) {
+        query.addBindValue(department);
+    }
+    if (!query.exec()) {
+        qDebug() << "Error querying daily summary:" << query.lastError().text();
+    }
+
+    QBarSet *onTime = new QBarSet("准时");
+    QBarSet *late = new QBarSet("迟到");
+    onTime->setColor(QColor("#4CAF50"));
+    late->setColor(QColor("#f44336"));
+    QStringList days;
+    qint64 totalEmployees = 0, totalLate = 0;
+    double totalArrival = 0.0;
+    int maxEmployees = 0;
+    while (query.next()) {
+        int employees = query.value(1).toInt();
+        int lateCount = query.value(2).toInt();
+        days << query.value(0).toString().right(2);
+        *onTime << employees - lateCount;
+        *late << lateCount;
+        totalEmployees += employees;
+        totalLate += lateCount;
+        totalArrival += query.value(3).toDouble();
+        maxEmployees = std::max(maxEmployees, employees);
+    }
+
+    QChart *chart = dailyChartView->chart();
+    resetChart(chart);
+    QStackedBarSeries *series = new QStackedBarSeries;
+    series->append(onTime);
+    series->append(late);
+    chart->addSeries(series);
+    QBarCategoryAxis *axisX = new QBarCategoryAxis;
+    axisX->append(days);
+    QValueAxis *axisY = new QValueAxis;
+    axisY->setRange(0, std::max(maxEmployees, 1));
+    axisY->setLabelFormat("%d");
+    chart->addAxis(axisX, Qt::AlignBottom);
+    chart->addAxis(axisY, Qt::AlignLeft);
+    series->attachAxis(axisX);
+    series->attachAxis(axisY);
+
+    totalsLabel->setText(QString("出勤 %1 人次    迟到 %2 人次 (%3%)    平均到岗 %4    上班时间 %5")
+                         .arg(totalEmployees)
+                         .arg(totalLate)
+                         .arg(totalEmployees > 0 ? 100.0 * totalLate / totalEmployees : 0.0, 0, 'f', 1)
+                         .arg(totalEmployees > 0 ? clockText(totalArrival / totalEmployees) : QString("-"))
+                         .arg(clockText(AttendanceSummary::workStartSeconds())));
+}
+
+void DashboardView::updateDepartmentChart(const QString &from, const QString &to) {
+    QSqlQuery query(db);
+    query.prepare("SELECT department, SUM(employees), SUM(late) FROM attendance_department_daily "
+                  "WHERE day BETWEEN ? AND ? GROUP BY department ORDER BY department");
+    query.addBindValue(from);
+    query.addBindValue(to);
+    if (!query.exec()) {
+        qDebug() << "Error querying department summary:" << query.lastError().text();
+    }
+
+    QBarSet *present = new QBarSet("出勤人次");
+    QBarSet *late = new QBarSet("迟到人次");
+    present->setColor(QColor("#2196F3"));
+    late->setColor(QColor("#f44336"));
+    QStringList departments;
+    int maxValue = 0;
+    while (query.next()) {
+        QString department = query.value(0).toString();
+        departments << (department.isEmpty() ? QString("未分配") : department);
+        *present << query.value(1).toInt();
+        *late << query.value(2).toInt();
+        maxValue = std::max(maxValue, query.value(1).toInt());
+    }
+
+    QChart *chart = departmentChartView->chart();
+    resetChart(chart);
+    QBarSeries *series = new QBarSeries;
+    series->append(present);
+    series->append(late);
+    chart->addSeries(series);
+    QBarCategoryAxis *axisX = new QBarCategoryAxis;
+    axisX->append(departments);
+    QValueAxis *axisY = new QValueAxis;
+    axisY->setRange(0, std::max(maxValue, 1));
+    axisY->setLabelFormat("%d");
+    chart->addAxis(axisX, Qt::AlignBottom);
+    chart->addAxis(axisY, Qt::AlignLeft);
+    series->attachAxis(axisX);
+    series->attachAxis(axisY);
+}
+
+void DashboardView::updateLateTable(const QString &from, const QString &to, const QString &department) {
+    // 员工日汇总按 (day, employee_id) 存放，一个月的范围扫描只读当月的行
+    QSqlQuery query(db);
+    query.prepare(QString("SELECT employee_id, name, SUM(late), AVG(first_checkin) FROM attendance_daily "
+                          "WHERE day BETWEEN ? AND ? %1 GROUP BY employee_id HAVING SUM(late) > 0 "
+                          "ORDER BY SUM(late) DESC, employee_id LIMIT %2")
+                  .arg(department.isEmpty() ? "" : "AND department = ?")
+                  .arg(kLateTableRows));
+    query.addBindValue(from);
+    query.addBindValue(to);
+    if (!department.isEmpty()) {
+        query.addBindValue(department);
+    }
+    if (!query.exec()) {
+        qDebug() << "Error querying late employees:" << query.lastError().text();
+    }
+
+    lateTable->setRowCount(0);
+    while (query.next()) {
+        int row = lateTable->rowCount();
+        lateTable->insertRow(row);
+        lateTable->setItem(row, 0, new QTableWidgetItem(query.value(0).toString()));
+        lateTable->setItem(row, 1, new QTableWidgetItem(query.value(1).toString()));
+        lateTable->setItem(row, 2, new QTableWidgetItem(query.value(2).toString()));
+        lateTable->setItem(row, 3, new QTableWidgetItem(clockText(query.value(3).toDouble())));
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef DASHBOARDVIEW_H
+#define DASHBOARDVIEW_H
+
+#include <QWidget>
+#include <QSqlDatabase>
+#include <QDateEdit>
+#include <QComboBox>
+#include <QLabel>
+#include <QTableWidget>
+#include <QtCharts/QChartView>
+
+// 考勤统计页面：按月显示每天的准时/迟到人数、各部门出勤和迟到情况以及迟到最多的员工
+// 只查询考勤汇总表(一个月最多 31×部门数 行的部门汇总)，不扫描原始考勤记录，数据量再大也能立即显示
+class DashboardView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DashboardView(const QSqlDatabase &db, QWidget *parent = nullptr);
+
+public slots:
+    void refresh();//按选择的月份和部门重新查询并更新图表
+
+private:
+    void loadDepartments();//部门下拉框的选项
+    void updateDailyChart(const QString &from, const QString &to, const QString &department);//每天的准时/迟到人数
+    void updateDepartmentChart(const QString &from, const QString &to);//各部门的出勤人次和迟到人次
+    void updateLateTable(const QString &from, const QString &to, const QString &department);//迟到次数最多的员工
+
+    QSqlDatabase db;//数据库连接(界面线程)
+    QDateEdit *monthEdit;//统计月份
+    QComboBox *departmentCombo;//部门筛选 第一项为全部部门
+    QLabel *totalsLabel;//当月出勤人次、迟到人次、平均到岗时刻和查询耗时
+    QtCharts::QChartView *dailyChartView;//每天的准时/迟到人数
+    QtCharts::QChartView *departmentChartView;//各部门出勤和迟到人次
+    QTableWidget *lateTable;//迟到最多的员工
+};
+
+#endif // DASHBOARDVIEW_H
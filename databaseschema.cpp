@@ -0,0 +1,80 @@
+#include "databaseschema.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+bool DatabaseSchema::create(QSqlDatabase &db) {
+    bool ok = true;
+    QSqlQuery query(db);
+    // WAL 模式下考勤写入线程写入时界面仍可读取
+    query.exec("PRAGMA journal_mode=WAL");
+
+    // 创建员工表，如果表不存在的话
+    if (!query.exec("CREATE TABLE IF NOT EXISTS employees ("
+                    "id INTEGER PRIMARY KEY AUTOINCREMENT, " // 自动递增的主键
+                    "employee_id TEXT UNIQUE, " // 员工编号，唯一
+                    "name TEXT, " // 姓名
+                    "department TEXT, " // 部门
+                    "face_image TEXT)")) { // 人脸图像的文件名或路径
+        qDebug() << "Error creating employees table:" << query.lastError().text(); // 如果创建表失败，输出错误信息
+        ok = false;
+    }
+
+    // 考勤记录按月分区存放(attendance_yyyymm，由 AttendanceStore 在写入时创建)，分区中只保存整数
+    // 员工快照：每条签到引用一行，员工信息不变时共用，不再每条记录重复保存字符串
+    if (!query.exec("CREATE TABLE IF NOT EXISTS attendance_people ("
+                    "id INTEGER PRIMARY KEY, " // 主键
+                    "employee_id TEXT NOT NULL, " // 员工编号
+                    "name TEXT NOT NULL, " // 姓名
+                    "department TEXT NOT NULL, " // 部门
+                    "face_image TEXT NOT NULL, " // 人脸图像的文件名或路径
+                    "UNIQUE (employee_id, name, department, face_image))")) {
+        qDebug() << "Error creating attendance_people table:" << query.lastError().text();
+        ok = false;
+    }
+    // 按部门筛选时先在快照表中查找员工，再用分区的 (person, ts) 索引
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_attendance_people_department ON attendance_people(department)")) {
+        qDebug() << "Error creating attendance_people department index:" << query.lastError().text();
+        ok = false;
+    }
+    // 分区目录：查询只打开时间范围内的分区，已归档的分区从归档文件读取
+    if (!query.exec("CREATE TABLE IF NOT EXISTS attendance_partitions ("
+                    "month INTEGER PRIMARY KEY, " // 月份 yyyymm
+                    "archive TEXT, " // 归档文件路径，仍在主数据库中时为空
+                    "rows INTEGER)")) { // 归档时的记录数
+        qDebug() << "Error creating attendance_partitions table:" << query.lastError().text();
+        ok = false;
+    }
+
+    // 考勤汇总表，由考勤写入线程增量维护，统计页面只读这两张表
+    // 签到时刻以当天秒数保存，迟到标记以首次签到为准
+    if (!query.exec("CREATE TABLE IF NOT EXISTS attendance_daily ("
+                    "day TEXT NOT NULL, " // 日期 yyyy-MM-dd
+                    "employee_id TEXT NOT NULL, " // 员工编号
+                    "name TEXT, " // 姓名
+                    "department TEXT, " // 部门
+                    "first_checkin INTEGER, " // 首次签到时刻(当天秒数)
+                    "last_checkin INTEGER, " // 末次签到时刻(当天秒数)
+                    "checkins INTEGER, " // 签到次数
+                    "late INTEGER, " // 是否迟到
+                    "PRIMARY KEY (day, employee_id)) WITHOUT ROWID")) {
+        qDebug() << "Error creating attendance_daily table:" << query.lastError().text();
+        ok = false;
+    }
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_attendance_daily_employee ON attendance_daily(employee_id, day)")) {
+        qDebug() << "Error creating attendance_daily employee index:" << query.lastError().text();
+        ok = false;
+    }
+    if (!query.exec("CREATE TABLE IF NOT EXISTS attendance_department_daily ("
+                    "day TEXT NOT NULL, " // 日期 yyyy-MM-dd
+                    "department TEXT NOT NULL, " // 部门
+                    "employees INTEGER, " // 出勤人数
+                    "checkins INTEGER, " // 签到次数
+                    "late INTEGER, " // 迟到人数
+                    "arrival_total INTEGER, " // 出勤员工首次签到时刻之和，除以人数得到平均到岗时刻
+                    "PRIMARY KEY (day, department)) WITHOUT ROWID")) {
+        qDebug() << "Error creating attendance_department_daily table:" << query.lastError().text();
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,13 @@
+#ifndef DATABASESCHEMA_H
+#define DATABASESCHEMA_H
+
+#include <QSqlDatabase>
+
+// 数据库表结构：界面和无界面回放模式共用，保证两者的表和索引一致
+class DatabaseSchema
+{
+public:
+    static bool create(QSqlDatabase &db);//创建员工表、考勤员工快照表、考勤分区目录、考勤汇总表及索引(已存在时跳过) 返回是否全部成功
+};
+
+#endif // DATABASESCHEMA_H
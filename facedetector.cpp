@@ -0,0 +1,175 @@
+#include "facedetector.h"
+#include <QDebug>
+
+FaceDetector::FaceDetector(DetectorConfig::Backend backend)
+    : backendType(backend)
+    , totalTicks(0)
+    , frames(0)
+{
+}
+
+FaceDetector::~FaceDetector()
+{
+}
+
+FaceDetector *FaceDetector::create(const DetectorConfig &config) {
+    FaceDetector *detector = nullptr;
+    if (config.backend == DetectorConfig::Ssd) {
+        detector = new SsdFaceDetector;
+    } else {
+        detector = new HaarFaceDetector;
+    }
+
+    if (!detector->load(config)) {
+        delete detector;
+        return nullptr;
+    }
+    return detector;
+}
+
+std::vector<cv::Rect> FaceDetector::detect(const cv::Mat &frame) {
+    std::vector<std::vector<cv::Rect>> faces = detectBatch(std::vector<cv::Mat>(1, frame));
+    return faces.empty() ? std::vector<cv::Rect>() : faces[0];
+}
+
+std::vector<cv::Rect> FaceDetector::detectRegions(const cv::Mat &frame, const std::vector<cv::Rect> &regions) {
+    std::vector<cv::Rect> result;
+    cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    std::vector<cv::Mat> crops;
+    std::vector<cv::Rect> offsets;
+    for (const cv::Rect &region : regions) {
+        cv::Rect clipped = region & bounds;
+        if (clipped.area() > 0) {
+            crops.push_back(frame(clipped)); // 只是引用原始帧的一部分，不复制
+            offsets.push_back(clipped);
+        }
+    }
+    if (crops.empty()) {
+        return result;
+    }
+
+    // 所有区域一起检测(SSD 合并为一个批次)，耗时统计按一帧计算
+    std::vector<std::vector<cv::Rect>> faces(crops.size());
+    int64 start = cv::getTickCount();
+    detectFrames(crops, faces);
+    totalTicks += cv::getTickCount() - start;
+    ++frames;
+
+    for (size_t i = 0; i < faces.size(); ++i) {
+        for (const cv::Rect &face : faces[i]) {
+            result.push_back(face + offsets[i].tl()); // 换算回整帧坐标
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<cv::Rect>> FaceDetector::detectBatch(const std::vector<cv::Mat> &frames) {
+    std::vector<std::vector<cv::Rect>> faces(frames.size());
+    if (frames.empty()) {
+        return faces;
+    }
+
+    int64 start = cv::getTickCount();
+    detectFrames(frames, faces);
+    totalTicks += cv::getTickCount() - start;
+    this->frames += static_cast<qint64>(frames.size());
+    return faces;
+}
+
+DetectorConfig::Backend FaceDetector::backend() const {
+    return backendType;
+}
+
+QString FaceDetector::name() const {
+    return backendType == DetectorConfig::Ssd ? "SSD" : "Haar";
+}
+
+double FaceDetector::averageLatencyMs() const {
+    if (frames == 0) {
+        return 0.0;
+    }
+    return totalTicks * 1000.0 / cv::getTickFrequency() / frames;
+}
+
+qint64 FaceDetector::frameCount() const {
+    return frames;
+}
+
+void FaceDetector::resetStats() {
+    totalTicks = 0;
+    frames = 0;
+}
+
+HaarFaceDetector::HaarFaceDetector()
+    : FaceDetector(DetectorConfig::Haar)
+    , scaleFactor(1.1)
+    , minNeighbors(3)
+    , minFaceSize(40)
+{
+}
+
+bool HaarFaceDetector::load(const DetectorConfig &config) {
+    if (!cascade.load(config.cascadePath.toStdString())) {
+        qDebug() << "Error loading face cascade from: " << config.cascadePath;
+        return false;
+    }
+    scaleFactor = qMax(1.01, config.scaleFactor); // 必须大于1
+    minNeighbors = qMax(0, config.minNeighbors);
+    minFaceSize = qMax(0, config.minFaceSize);
+    return true;
+}
+
+void HaarFaceDetector::detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &faces) {
+    for (size_t i = 0; i < frames.size(); ++i) {
+        // 将帧从 BGR 格式转换为灰度图像
+        cv::cvtColor(frames[i], gray, cv::COLOR_BGR2GRAY);
+        cascade.detectMultiScale(gray, faces[i], scaleFactor, minNeighbors, 0, cv::Size(minFaceSize, minFaceSize));
+    }
+}
+
+SsdFaceDetector::SsdFaceDetector()
+    : FaceDetector(DetectorConfig::Ssd)
+    , confidenceThreshold(0.5f)
+    , minFaceSize(0)
+{
+}
+
+bool SsdFaceDetector::load(const DetectorConfig &config) {
+    // 从 Caffe 模型和权重文件中读取深度神经网络（DNN）
+    net = cv::dnn::readNetFromCaffe(config.ssdConfigPath.toStdString(), config.ssdModelPath.toStdString());
+    if (net.empty()) {
+        qDebug() << "Error loading DNN model.";
+        return false;
+    }
+    net.setPreferableBackend(config.dnnBackend);
+    net.setPreferableTarget(config.dnnTarget);
+    confidenceThreshold = config.confidenceThreshold;
+    minFaceSize = qMax(0, config.minFaceSize);
+    return true;
+}
+
+void SsdFaceDetector::detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &faces) {
+    // 所有帧合并成一个 NCHW blob，只做一次前向计算
+    cv::dnn::blobFromImages(frames, blob, 1.0, cv::Size(300, 300), cv::Scalar(104.0, 177.0, 123.0), false, false);
+    net.setInput(blob);
+    cv::Mat output = net.forward();
+
+    // 输出形状为 [1, 1, K, 7]，每行为 [图像序号, 类别, 置信度, x1, y1, x2, y2]，坐标已归一化
+    cv::Mat detections(output.size[2], output.size[3], CV_32F, output.ptr<float>());
+    for (int i = 0; i < detections.rows; ++i) {
+        const float *row = detections.ptr<float>(i);
+        int image = static_cast<int>(row[0]);
+        float confidence = row[2];
+        if (confidence < confidenceThreshold || image < 0 || image >= static_cast<int>(frames.size())) {
+            continue;
+        }
+
+        const cv::Mat &frame = frames[image];
+        cv::Rect face(cv::Point(cvRound(row[3] * frame.cols), cvRound(row[4] * frame.rows)),
+                      cv::Point(cvRound(row[5] * frame.cols), cvRound(row[6] * frame.rows)));
+        face &= cv::Rect(0, 0, frame.cols, frame.rows); // 裁剪到图像范围内
+        if (face.area() > 0 && face.width >= minFaceSize && face.height >= minFaceSize) {
+            faces[image].push_back(face);
+        }
+    }
+}
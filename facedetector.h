@@ -0,0 +1,96 @@
+#ifndef FACEDETECTOR_H
+#define FACEDETECTOR_H
+
+#include <QString>
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#include <vector>
+
+// 人脸检测器配置，运行时可切换
+struct DetectorConfig
+{
+    enum Backend {
+        Haar,//Haar 级联分类器
+        Ssd//SSD ResNet-10 深度神经网络
+    };
+
+    Backend backend = Haar;//使用的检测后端
+    QString cascadePath;//Haar 分类器文件路径
+    QString ssdConfigPath;//SSD 网络结构文件(deploy.prototxt)路径
+    QString ssdModelPath;//SSD 权重文件(.caffemodel)路径
+    float confidenceThreshold = 0.5f;//SSD 置信度阈值
+    double scaleFactor = 1.1;//Haar 图像金字塔每层的缩放比例 越大越快但越容易漏检
+    int minNeighbors = 3;//Haar 候选框至少需要的相邻检测数 越大误检越少
+    int minFaceSize = 40;//最小人脸边长(原始帧像素) 小于该值的人脸不检测
+    double detectionScale = 1.0;//检测和跟踪所用的分辨率相对原始帧的比例 识别仍从原始帧裁剪人脸
+    std::vector<double> pyramidScales;//采集线程生成的金字塔各层比例(从大到小) 为空时只生成检测层
+    int dnnBackend = cv::dnn::DNN_BACKEND_OPENCV;//DNN 计算后端
+    int dnnTarget = cv::dnn::DNN_TARGET_CPU;//DNN 计算设备
+};
+
+// 人脸检测器基类：统一 Haar 和 SSD 两种后端，并统计每个后端的检测耗时
+// 检测器不是线程安全的，每个线程使用自己的实例
+class FaceDetector
+{
+public:
+    virtual ~FaceDetector();
+
+    static FaceDetector *create(const DetectorConfig &config);//按配置创建检测器 加载失败时返回nullptr
+
+    std::vector<cv::Rect> detect(const cv::Mat &frame);//检测一帧BGR图像中的人脸
+    std::vector<std::vector<cv::Rect>> detectBatch(const std::vector<cv::Mat> &frames);//批量检测多帧 返回每帧的人脸框
+    std::vector<cv::Rect> detectRegions(const cv::Mat &frame, const std::vector<cv::Rect> &regions);//只在一帧的若干区域内检测 返回整帧坐标的人脸框 区域应互不重叠
+
+    DetectorConfig::Backend backend() const;//检测后端
+    QString name() const;//后端名称
+    double averageLatencyMs() const;//平均每帧检测耗时(毫秒)
+    qint64 frameCount() const;//已检测的帧数
+    void resetStats();//清空耗时统计
+
+protected:
+    explicit FaceDetector(DetectorConfig::Backend backend);
+    virtual bool load(const DetectorConfig &config) = 0;//加载模型
+    virtual void detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &faces) = 0;//实际的检测实现
+
+private:
+    DetectorConfig::Backend backendType;//检测后端
+    qint64 totalTicks;//累计耗时(cv::getTickCount 计数)
+    qint64 frames;//累计检测帧数
+};
+
+// Haar 级联分类器检测器
+class HaarFaceDetector : public FaceDetector
+{
+public:
+    HaarFaceDetector();
+
+protected:
+    bool load(const DetectorConfig &config) override;
+    void detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &faces) override;
+
+private:
+    cv::CascadeClassifier cascade;//人脸检测分类器
+    cv::Mat gray;//灰度图缓冲区，重复使用
+    double scaleFactor;//图像金字塔每层的缩放比例
+    int minNeighbors;//候选框至少需要的相邻检测数
+    int minFaceSize;//最小人脸边长
+};
+
+// SSD ResNet-10 检测器：每次调用只构建一次 blob，多帧时合并成一个批次前向计算
+class SsdFaceDetector : public FaceDetector
+{
+public:
+    SsdFaceDetector();
+
+protected:
+    bool load(const DetectorConfig &config) override;
+    void detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &faces) override;
+
+private:
+    cv::dnn::Net net;//SSD 网络
+    cv::Mat blob;//输入 blob 缓冲区，重复使用
+    float confidenceThreshold;//置信度阈值
+    int minFaceSize;//最小人脸边长 更小的检测结果丢弃
+};
+
+#endif // FACEDETECTOR_H
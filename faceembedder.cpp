@@ -0,0 +1,99 @@
+#include "faceembedder.h"
+#include <QFile>
+#include <QDebug>
+
+namespace {
+const int kEmbeddingSize = 128; // OpenFace 特征维数
+const int kHistogramSize = 256; // 直方图特征维数
+const float kEmbeddingThreshold = 0.6f; // DNN 特征的余弦相似度阈值
+const float kHistogramThreshold = 0.75f; // 直方图特征阈值，对应巴氏距离 0.5
+}
+
+FaceEmbedder::FaceEmbedder()
+    : dnnLoaded(false)
+{
+}
+
+bool FaceEmbedder::load(const QString &modelPath, int dnnBackend, int dnnTarget) {
+    dnnLoaded = false;
+    if (!QFile::exists(modelPath)) {
+        qDebug() << "Face embedding model not found, using histogram features:" << modelPath;
+        return false;
+    }
+
+    try {
+        net = cv::dnn::readNetFromTorch(modelPath.toStdString());
+    } catch (const cv::Exception &e) {
+        qDebug() << "Error loading face embedding model:" << e.what();
+        return false;
+    }
+    if (net.empty()) {
+        qDebug() << "Error loading face embedding model:" << modelPath;
+        return false;
+    }
+
+    net.setPreferableBackend(dnnBackend);
+    net.setPreferableTarget(dnnTarget);
+    dnnLoaded = true;
+    return true;
+}
+
+cv::Mat FaceEmbedder::extract(const cv::Mat &face) {
+    if (face.empty()) {
+        return cv::Mat();
+    }
+    if (!dnnLoaded) {
+        return histogramTemplate(face);
+    }
+
+    // OpenFace 输入为 96x96 RGB，像素缩放到 [0, 1]
+    cv::Mat input = face;
+    if (face.channels() == 1) {
+        cv::cvtColor(face, input, cv::COLOR_GRAY2BGR);
+    }
+    cv::dnn::blobFromImage(input, blob, 1.0 / 255, cv::Size(96, 96), cv::Scalar(), true, false);
+    net.setInput(blob);
+    cv::Mat embedding = net.forward().reshape(1, 1).clone();
+
+    // L2 归一化后点积即余弦相似度
+    cv::normalize(embedding, embedding);
+    return embedding;
+}
+
+bool FaceEmbedder::usesDnn() const {
+    return dnnLoaded;
+}
+
+int FaceEmbedder::dimension() const {
+    return dnnLoaded ? kEmbeddingSize : kHistogramSize;
+}
+
+float FaceEmbedder::matchThreshold() const {
+    return dnnLoaded ? kEmbeddingThreshold : kHistogramThreshold;
+}
+
+cv::Mat FaceEmbedder::histogramTemplate(const cv::Mat &face) {
+    if (face.empty()) {
+        return cv::Mat();
+    }
+
+    // 转换为灰度图像
+    cv::Mat gray;
+    if (face.channels() == 3) {
+        cv::cvtColor(face, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = face;
+    }
+
+    // 计算256级灰度直方图
+    cv::Mat hist;
+    int histSize[1] = {kHistogramSize};
+    float range[] = {0, 256};
+    const float* histRange[] = {range};
+    cv::calcHist(&gray, 1, 0, cv::Mat(), hist, 1, histSize, histRange);
+    cv::normalize(hist, hist, 1, 0, cv::NORM_L1); // L1归一化
+
+    // 开方后为单位向量，两个模板的点积即巴氏系数
+    cv::sqrt(hist, hist);
+    return hist.reshape(1, 1).clone();
+}
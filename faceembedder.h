@@ -0,0 +1,31 @@
+#ifndef FACEEMBEDDER_H
+#define FACEEMBEDDER_H
+
+#include <QString>
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+// 人脸特征提取器：用 OpenCV DNN 模型为每张人脸提取一个定长、L2归一化的特征向量
+// 模型不可用时退回到灰度直方图模板(sqrt(L1归一化直方图)，同样是单位向量)，两种特征都用余弦相似度比较
+// 网络不是线程安全的，每个线程使用自己的实例
+class FaceEmbedder
+{
+public:
+    FaceEmbedder();
+
+    bool load(const QString &modelPath, int dnnBackend = cv::dnn::DNN_BACKEND_OPENCV, int dnnTarget = cv::dnn::DNN_TARGET_CPU);//加载特征提取模型 失败时使用直方图特征
+    cv::Mat extract(const cv::Mat &face);//提取BGR人脸图像的特征 返回1xD的CV_32F单位行向量
+
+    bool usesDnn() const;//是否使用DNN特征
+    int dimension() const;//特征维数
+    float matchThreshold() const;//余弦相似度阈值，大于该值认为是同一个人
+
+    static cv::Mat histogramTemplate(const cv::Mat &face);//计算直方图特征 返回1x256的CV_32F单位行向量
+
+private:
+    cv::dnn::Net net;//特征提取网络(OpenFace nn4.small2，输出128维)
+    cv::Mat blob;//输入 blob 缓冲区，重复使用
+    bool dnnLoaded;//网络是否加载成功
+};
+
+#endif // FACEEMBEDDER_H
@@ -0,0 +1,378 @@
+#include "facegallery.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+FaceGallery::FaceGallery()
+    : index(GalleryIndex::create(GalleryIndex::BruteForce))
+    , forcedIndexType(-1)
+    , store(new GalleryStore)
+    , templateKind(0)
+    , templatesDirty(false)
+{
+}
+
+void FaceGallery::setIndexType(GalleryIndex::Type type) {
+    QWriteLocker locker(&lock);
+    forcedIndexType = type;
+}
+
+void FaceGallery::setIndexPath(const QString &path) {
+    QWriteLocker locker(&lock);
+    indexPath = path;
+}
+
+void FaceGallery::setTemplatePath(const QString &path) {
+    QWriteLocker locker(&lock);
+    templatePath = path;
+}
+
+bool FaceGallery::loadFromDatabase(const QSqlDatabase &db, FaceEmbedder &embedder) {
+    QSqlQuery query(db);
+    if (!query.exec("SELECT id, employee_id, name, department, face_image FROM employees ORDER BY id")) {
+        qDebug() << "Error loading face gallery:" << query.lastError().text();
+        return false;
+    }
+
+    QHash<int, EmployeeRecord> loaded;
+    QHash<QString, int> loadedRowIds;
+    QHash<int, quint64> loadedKeys;
+    std::vector<int> order;
+    while (query.next()) {
+        int rowId = query.value(0).toInt(); // 主键
+        EmployeeRecord record;
+        record.employeeId = query.value(1).toString(); // 员工编号
+        record.name = query.value(2).toString(); // 姓名
+        record.department = query.value(3).toString(); // 部门
+        record.faceImage = query.value(4).toString(); // 人脸图像路径
+        loaded.insert(rowId, record);
+        loadedRowIds.insert(record.employeeId, rowId);
+        loadedKeys.insert(rowId, recordKey(rowId, record)); // 每个人脸图像只读取一次文件信息
+        order.push_back(rowId);
+    }
+
+    QString path;
+    QString templates;
+    int forced = -1;
+    {
+        QReadLocker locker(&lock);
+        forced = forcedIndexType;
+        path = indexPath;
+        templates = templatePath;
+    }
+
+    // 按员工数量选择索引类型；量化模板重排时需要模板文件中的全精度特征
+    GalleryIndex::Type type = GalleryIndex::BruteForce;
+    if (forced >= 0) {
+        type = static_cast<GalleryIndex::Type>(forced);
+    } else if (static_cast<int>(order.size()) >= kIvfThreshold) {
+        type = GalleryIndex::Ivf;
+    } else if (static_cast<int>(order.size()) >= kQuantizeThreshold && !templates.isEmpty()) {
+        type = GalleryIndex::Int8;
+    }
+    std::unique_ptr<GalleryIndex> built(GalleryIndex::create(type));
+    if (QuantizedIndex *quantized = dynamic_cast<QuantizedIndex *>(built.get())) {
+        // search 在读锁内调用，读取的成员都受同一把锁保护
+        quantized->setFeatureSource([this](int rowId) { return fullFeature(rowId); });
+    }
+
+    // 模板文件中校验值一致的员工直接使用映射的特征，其余员工才解码人脸图像
+    quint32 kind = featureKind(embedder);
+    std::unique_ptr<GalleryStore> mapped(new GalleryStore);
+    bool hasTemplates = !templates.isEmpty() && mapped->map(templates, embedder.dimension(), kind);
+    std::vector<cv::Mat> rows;
+    std::vector<int> ids;
+    std::vector<GalleryStore::Entry> entries;
+    int extracted = 0;
+    for (int rowId : order) {
+        const EmployeeRecord record = loaded.value(rowId);
+        quint64 key = loadedKeys.value(rowId);
+        int stored = hasTemplates ? mapped->find(rowId, key) : -1;
+
+        cv::Mat feature;
+        if (stored >= 0) {
+            feature = mapped->feature(stored);
+        } else {
+            // 只在模板缺失或过期时读取一次人脸图像
+            cv::Mat savedFace = cv::imread(record.faceImage.toStdString());
+            if (savedFace.empty()) {
+                qDebug() << "Skipping employee without readable face image:" << record.employeeId;
+                continue;
+            }
+            // 录入时图像以RGB顺序保存，这里还原为BGR，与摄像头帧保持一致
+            cv::cvtColor(savedFace, savedFace, cv::COLOR_RGB2BGR);
+
+            feature = embedder.extract(savedFace);
+            if (feature.empty()) {
+                continue;
+            }
+            ++extracted;
+        }
+        rows.push_back(feature);
+        ids.push_back(rowId);
+        GalleryStore::Entry entry = {rowId, 0, key};
+        entries.push_back(entry);
+    }
+
+    // 一次性拼接成连续的特征矩阵(从映射内存复制)再建索引
+    cv::Mat merged;
+    if (!rows.empty()) {
+        cv::vconcat(rows, merged);
+    }
+    rows.clear();
+
+    // 有新提取的特征或有员工被删除时重写模板文件，重写前解除映射
+    if (!templates.isEmpty() && (!hasTemplates || extracted > 0 || mapped->size() != static_cast<int>(entries.size()))) {
+        mapped->unmap();
+        if (GalleryStore::write(templates, kind, merged, entries)) {
+            mapped->map(templates, embedder.dimension(), kind);
+        }
+    }
+
+    // 员工没有变化时直接加载持久化的索引(IVF无需重新训练)
+    quint64 expected = signature(loadedKeys) ^ static_cast<quint64>(embedder.dimension());
+    bool fromFile = !path.isEmpty() && built->load(path, expected);
+    if (!fromFile) {
+        built->build(merged, ids);
+        if (!path.isEmpty()) {
+            built->save(path, expected);
+        }
+    }
+
+    QWriteLocker locker(&lock);
+    employees.swap(loaded);
+    rowIds.swap(loadedRowIds);
+    recordKeys.swap(loadedKeys);
+    index.swap(built);
+    store.swap(mapped);
+    templateKind = kind;
+    pendingTemplates.clear();
+    templatesDirty = false;
+
+    qDebug() << "Face gallery loaded" << (fromFile ? "from index file," : ",") << employees.size() << "employees,"
+             << extracted << "features extracted," << index->name();
+    return true;
+}
+
+void FaceGallery::addEmployee(int rowId, const EmployeeRecord &record, const cv::Mat &feature) {
+    if (feature.empty()) {
+        return;
+    }
+    quint64 key = recordKey(rowId, record); // 在锁外读取人脸图像的文件信息
+
+    QWriteLocker locker(&lock);
+    if (index->dimension() != 0 && feature.cols != index->dimension()) {
+        qDebug() << "Feature dimension mismatch, employee not added:" << record.employeeId;
+        return;
+    }
+
+    // 同一员工重新录入时替换旧的特征
+    auto existing = rowIds.find(record.employeeId);
+    if (existing != rowIds.end()) {
+        index->remove(existing.value());
+        employees.remove(existing.value());
+        recordKeys.remove(existing.value());
+    }
+    employees.insert(rowId, record);
+    rowIds.insert(record.employeeId, rowId);
+    recordKeys.insert(rowId, key);
+    index->add(rowId, feature);
+    pendingTemplates.insert(rowId, feature.clone());
+    templatesDirty = true;
+}
+
+void FaceGallery::addEmployees(const std::vector<int> &ids, const std::vector<EmployeeRecord> &records, const std::vector<cv::Mat> &features) {
+    // 人脸图像的文件信息在锁外读取；只加一次写锁，识别线程最多等待一次
+    std::vector<quint64> keys;
+    for (size_t i = 0; i < ids.size() && i < records.size(); ++i) {
+        keys.push_back(recordKey(ids[i], records[i]));
+    }
+    QWriteLocker locker(&lock);
+    for (size_t i = 0; i < ids.size() && i < records.size() && i < features.size(); ++i) {
+        const EmployeeRecord &record = records[i];
+        if (features[i].empty() || (index->dimension() != 0 && features[i].cols != index->dimension())) {
+            qDebug() << "Feature dimension mismatch, employee not added:" << record.employeeId;
+            continue;
+        }
+        auto existing = rowIds.find(record.employeeId);
+        if (existing != rowIds.end()) {
+            index->remove(existing.value());
+            employees.remove(existing.value());
+            recordKeys.remove(existing.value());
+        }
+        employees.insert(ids[i], record);
+        rowIds.insert(record.employeeId, ids[i]);
+        recordKeys.insert(ids[i], keys[i]);
+        index->add(ids[i], features[i]);
+        pendingTemplates.insert(ids[i], features[i].clone());
+        templatesDirty = true;
+    }
+    qDebug() << "Face gallery updated with" << ids.size() << "employees," << employees.size() << "in total";
+}
+
+bool FaceGallery::removeEmployee(const QString &employeeId) {
+    QWriteLocker locker(&lock);
+    auto it = rowIds.find(employeeId);
+    if (it == rowIds.end()) {
+        return false;
+    }
+    int rowId = it.value();
+    rowIds.erase(it);
+    employees.remove(rowId);
+    recordKeys.remove(rowId);
+    index->remove(rowId);
+    pendingTemplates.remove(rowId);
+    templatesDirty = true;
+    return true;
+}
+
+std::vector<GalleryMatch> FaceGallery::search(const cv::Mat &probe, int k) const {
+    std::vector<GalleryMatch> results;
+    if (probe.empty()) {
+        return results;
+    }
+
+    QReadLocker locker(&lock);
+    if (index->size() == 0 || probe.cols != index->dimension()) {
+        return results;
+    }
+
+    std::vector<FaceMatch> matches = index->search(probe, k);
+    for (const FaceMatch &match : matches) {
+        GalleryMatch result;
+        result.index = match.index;
+        result.score = match.score;
+        result.employee = employees.value(match.index);
+        results.push_back(result);
+    }
+    return results;
+}
+
+bool FaceGallery::saveIndex() const {
+    QReadLocker locker(&lock);
+    if (indexPath.isEmpty()) {
+        return false;
+    }
+    return index->save(indexPath, signature(recordKeys) ^ static_cast<quint64>(index->dimension()));
+}
+
+bool FaceGallery::saveTemplates() {
+    QWriteLocker locker(&lock);
+    if (templatePath.isEmpty() || !templatesDirty) {
+        return false;
+    }
+
+    // 加载后录入的员工取内存中的特征，其余员工取映射的模板
+    QList<int> keys = employees.keys();
+    std::sort(keys.begin(), keys.end());
+    std::vector<cv::Mat> rows;
+    std::vector<GalleryStore::Entry> entries;
+    for (int rowId : keys) {
+        quint64 key = recordKeys.value(rowId);
+        cv::Mat feature = pendingTemplates.value(rowId);
+        if (feature.empty()) {
+            int stored = store->find(rowId, key);
+            if (stored < 0) {
+                continue;
+            }
+            feature = store->feature(stored);
+        }
+        rows.push_back(feature);
+        GalleryStore::Entry entry = {rowId, 0, key};
+        entries.push_back(entry);
+    }
+    cv::Mat merged;
+    if (!rows.empty()) {
+        cv::vconcat(rows, merged); // 解除映射前复制出来
+    }
+    rows.clear();
+
+    int dimension = merged.empty() ? store->dimension() : merged.cols;
+    store->unmap();
+    bool ok = GalleryStore::write(templatePath, templateKind, merged, entries);
+    store->map(templatePath, dimension, templateKind);
+    if (ok) {
+        pendingTemplates.clear();
+        templatesDirty = false;
+    }
+    return ok;
+}
+
+int FaceGallery::size() const {
+    QReadLocker locker(&lock);
+    return employees.size();
+}
+
+int FaceGallery::dimension() const {
+    QReadLocker locker(&lock);
+    return index->dimension();
+}
+
+bool FaceGallery::contains(const QString &employeeId) const {
+    QReadLocker locker(&lock);
+    return rowIds.contains(employeeId);
+}
+
+QString FaceGallery::indexName() const {
+    QReadLocker locker(&lock);
+    return index->name();
+}
+
+quint64 FaceGallery::signature(const QHash<int, quint64> &keys) {
+    // FNV-1a，主键按升序参与计算，与哈希表的遍历顺序无关；每个员工取缓存的 recordKey，人脸图像变化时签名也变化
+    QList<int> rowIds = keys.keys();
+    std::sort(rowIds.begin(), rowIds.end());
+
+    quint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](quint64 value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    for (int rowId : rowIds) {
+        mix(keys.value(rowId));
+    }
+    return hash;
+}
+
+quint64 FaceGallery::recordKey(int rowId, const EmployeeRecord &record) {
+    // FNV-1a，人脸图像路径、大小或修改时间变化(重新录入会覆盖同一个文件，删除后重新插入的员工可能复用主键)时校验值随之变化
+    quint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](quint64 value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    mix(static_cast<quint64>(rowId));
+    for (QChar c : record.employeeId) {
+        mix(c.unicode());
+    }
+    mix(0);
+    for (QChar c : record.faceImage) {
+        mix(c.unicode());
+    }
+    QFileInfo image(record.faceImage);
+    mix(0);
+    mix(image.exists() ? static_cast<quint64>(image.size()) : 0);
+    mix(image.exists() ? static_cast<quint64>(image.lastModified().toMSecsSinceEpoch()) : 0);
+    return hash;
+}
+
+quint32 FaceGallery::featureKind(const FaceEmbedder &embedder) {
+    return embedder.usesDnn() ? 1 : 2;
+}
+
+cv::Mat FaceGallery::fullFeature(int rowId) const {
+    // 加载后录入的员工在内存中，其余员工从映射的模板文件读取一行
+    auto pending = pendingTemplates.find(rowId);
+    if (pending != pendingTemplates.end()) {
+        return pending.value();
+    }
+    auto key = recordKeys.find(rowId);
+    if (key == recordKeys.end() || !store->isMapped()) {
+        return cv::Mat();
+    }
+    int stored = store->find(rowId, key.value());
+    return stored >= 0 ? store->feature(stored) : cv::Mat();
+}
@@ -0,0 +1,84 @@
+#ifndef FACEGALLERY_H
+#define FACEGALLERY_H
+
+#include <QString>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QReadWriteLock>
+#include <QMetaType>
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+#include "faceembedder.h"
+#include "galleryindex.h"
+#include "gallerystore.h"
+
+// 员工信息（对应 employees 表中的一行）
+struct EmployeeRecord
+{
+    QString employeeId;//员工编号
+    QString name;//姓名
+    QString department;//部门
+    QString faceImage;//人脸图像路径
+};
+Q_DECLARE_METATYPE(EmployeeRecord)
+
+// 人脸库搜索返回的候选
+struct GalleryMatch
+{
+    int index = -1;//员工在 employees 表中的主键 id
+    float score = 0.0f;//余弦相似度
+    EmployeeRecord employee;//员工信息
+};
+
+// 人脸库：启动时从数据库加载一次，之后常驻内存
+// 员工信息按 employees 表的主键保存，特征交给可替换的索引(精确搜索、IVF近似搜索或量化模板)，识别时不再访问数据库
+// 量化模板索引只在内存中保存压缩的模板，重排少数候选时从映射的模板文件读取全精度特征
+// 特征同时保存在内存映射的模板文件中，启动时只为新增或变化的员工解码人脸图像
+// 识别线程读取、界面线程录入，内部用读写锁保护
+class FaceGallery
+{
+public:
+    FaceGallery();
+
+    void setIndexType(GalleryIndex::Type type);//指定索引类型 不调用时按员工数量自动选择
+    void setIndexPath(const QString &path);//索引持久化文件路径 为空时不持久化
+    void setTemplatePath(const QString &path);//模板文件路径 为空时每次启动都从人脸图像提取特征
+
+    bool loadFromDatabase(const QSqlDatabase &db, FaceEmbedder &embedder);//从数据库加载所有员工信息并提取特征 返回是否成功
+    void addEmployee(int rowId, const EmployeeRecord &record, const cv::Mat &feature);//录入新员工后增量更新人脸库 rowId为employees表主键 feature为1xD特征向量
+    void addEmployees(const std::vector<int> &ids, const std::vector<EmployeeRecord> &records, const std::vector<cv::Mat> &features);//批量录入后一次性更新人脸库 三个数组一一对应
+    bool removeEmployee(const QString &employeeId);//删除员工后增量更新人脸库 返回是否存在
+    std::vector<GalleryMatch> search(const cv::Mat &probe, int k) const;//查找与探针特征最相似的k个员工 按得分从高到低排序
+    bool saveIndex() const;//把索引保存到磁盘
+    bool saveTemplates();//录入/删除后重写模板文件 没有变化时不写
+
+    int size() const;//员工数量
+    int dimension() const;//特征维数 人脸库为空时为0
+    bool contains(const QString &employeeId) const;//是否已录入该员工
+    QString indexName() const;//当前索引名称
+
+    static const int kIvfThreshold = 20000;//自动选择时员工数量达到该值使用IVF索引
+    static const int kQuantizeThreshold = 5000;//自动选择时员工数量达到该值(且小于IVF阈值、有模板文件)使用int8量化模板
+
+private:
+    static quint64 signature(const QHash<int, quint64> &keys);//由每个员工缓存的 recordKey 计算的签名，用于校验持久化的索引
+    static quint64 recordKey(int rowId, const EmployeeRecord &record);//由员工主键、编号、人脸图像路径及其大小和修改时间计算的校验值，用于判断模板是否过期 读取文件信息 只在加载和录入时调用
+    static quint32 featureKind(const FaceEmbedder &embedder);//特征类型 DNN与直方图特征不能混用
+    cv::Mat fullFeature(int rowId) const;//量化索引重排用的全精度特征 调用方持有锁 取不到时返回空矩阵
+
+    mutable QReadWriteLock lock;//保护员工信息和索引
+    QHash<int, EmployeeRecord> employees;//主键 id -> 员工信息
+    QHash<QString, int> rowIds;//员工编号 -> 主键 id
+    QHash<int, quint64> recordKeys;//主键 id -> recordKey 加载和录入时计算一次 识别和保存时不再访问磁盘
+    std::unique_ptr<GalleryIndex> index;//特征索引
+    int forcedIndexType;//指定的索引类型 -1表示自动选择
+    QString indexPath;//索引持久化文件路径
+    QString templatePath;//模板文件路径
+    std::unique_ptr<GalleryStore> store;//映射的模板文件
+    quint32 templateKind;//模板文件中的特征类型
+    QHash<int, cv::Mat> pendingTemplates;//加载后录入的员工特征 主键 -> 特征 写入模板文件后清空
+    bool templatesDirty;//模板文件是否需要重写
+};
+
+#endif // FACEGALLERY_H
@@ -0,0 +1,161 @@
+#include "facematcher.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+
+void FaceMatcher::computeScores(const cv::Mat &gallery, const cv::Mat &probe, std::vector<float> &scores) {
+    const int rows = gallery.rows;
+    const int dim = gallery.cols;
+    scores.resize(rows);
+    if (rows == 0 || probe.cols != dim) {
+        return;
+    }
+    CV_Assert(gallery.type() == CV_32F && probe.type() == CV_32F && gallery.isContinuous());
+
+    const float *q = probe.ptr<float>();
+    int i = 0;
+#if CV_SIMD128
+    // 每次处理4行，探针向量只加载一次，用于4行的乘加
+    for (; i + 4 <= rows; i += 4) {
+        const float *r0 = gallery.ptr<float>(i);
+        const float *r1 = r0 + dim;
+        const float *r2 = r1 + dim;
+        const float *r3 = r2 + dim;
+        cv::v_float32x4 s0 = cv::v_setzero_f32();
+        cv::v_float32x4 s1 = cv::v_setzero_f32();
+        cv::v_float32x4 s2 = cv::v_setzero_f32();
+        cv::v_float32x4 s3 = cv::v_setzero_f32();
+        int j = 0;
+        for (; j + 4 <= dim; j += 4) {
+            cv::v_float32x4 qv = cv::v_load(q + j);
+            s0 = cv::v_muladd(cv::v_load(r0 + j), qv, s0);
+            s1 = cv::v_muladd(cv::v_load(r1 + j), qv, s1);
+            s2 = cv::v_muladd(cv::v_load(r2 + j), qv, s2);
+            s3 = cv::v_muladd(cv::v_load(r3 + j), qv, s3);
+        }
+        float d0 = cv::v_reduce_sum(s0);
+        float d1 = cv::v_reduce_sum(s1);
+        float d2 = cv::v_reduce_sum(s2);
+        float d3 = cv::v_reduce_sum(s3);
+        for (; j < dim; ++j) {
+            d0 += r0[j] * q[j];
+            d1 += r1[j] * q[j];
+            d2 += r2[j] * q[j];
+            d3 += r3[j] * q[j];
+        }
+        scores[i] = d0;
+        scores[i + 1] = d1;
+        scores[i + 2] = d2;
+        scores[i + 3] = d3;
+    }
+#endif
+    // 剩余的行
+    for (; i < rows; ++i) {
+        scores[i] = dot(gallery.ptr<float>(i), q, dim);
+    }
+}
+
+std::vector<FaceMatch> FaceMatcher::topK(const cv::Mat &gallery, const cv::Mat &probe, int k) {
+    std::vector<float> scores;
+    computeScores(gallery, probe, scores);
+    return selectTopK(scores, k);
+}
+
+std::vector<FaceMatch> FaceMatcher::selectTopK(const std::vector<float> &scores, int k) {
+    std::vector<FaceMatch> best;
+    if (k <= 0) {
+        return best;
+    }
+    best.reserve(k + 1);
+
+    // k 很小，维护一个按得分降序的短数组，比整体排序快
+    for (int i = 0; i < static_cast<int>(scores.size()); ++i) {
+        float score = scores[i];
+        if (static_cast<int>(best.size()) == k && score <= best.back().score) {
+            continue;
+        }
+        FaceMatch match;
+        match.index = i;
+        match.score = score;
+        auto pos = std::upper_bound(best.begin(), best.end(), score,
+                                    [](float value, const FaceMatch &m) { return value > m.score; });
+        best.insert(pos, match);
+        if (static_cast<int>(best.size()) > k) {
+            best.pop_back();
+        }
+    }
+    return best;
+}
+
+float FaceMatcher::dot(const float *a, const float *b, int dim) {
+    int j = 0;
+    float sum = 0.0f;
+#if CV_SIMD128
+    cv::v_float32x4 acc = cv::v_setzero_f32();
+    for (; j + 4 <= dim; j += 4) {
+        acc = cv::v_muladd(cv::v_load(a + j), cv::v_load(b + j), acc);
+    }
+    sum = cv::v_reduce_sum(acc);
+#endif
+    for (; j < dim; ++j) {
+        sum += a[j] * b[j];
+    }
+    return sum;
+}
+
+void FaceMatcher::computeScoresInt8(const cv::Mat &codes, const float *scales, const cv::Mat &probe, float probeScale, std::vector<float> &scores) {
+    const int rows = codes.rows;
+    const int dim = codes.cols;
+    scores.resize(rows);
+    if (rows == 0 || probe.cols != dim) {
+        return;
+    }
+    CV_Assert(codes.type() == CV_8S && probe.type() == CV_8S && codes.isContinuous());
+
+    // 整数点积：每行只读D个字节，是浮点特征的1/4，扫描大库时内存带宽是瓶颈
+    // int8乘积两两相加后最大为2*127*127，累加到int32不会溢出
+    const schar *q = probe.ptr<schar>();
+    int i = 0;
+#if CV_SIMD128
+    for (; i + 4 <= rows; i += 4) {
+        const schar *r0 = codes.ptr<schar>(i);
+        const schar *r1 = r0 + dim;
+        const schar *r2 = r1 + dim;
+        const schar *r3 = r2 + dim;
+        cv::v_int32x4 s0 = cv::v_setzero_s32();
+        cv::v_int32x4 s1 = cv::v_setzero_s32();
+        cv::v_int32x4 s2 = cv::v_setzero_s32();
+        cv::v_int32x4 s3 = cv::v_setzero_s32();
+        int j = 0;
+        for (; j + 8 <= dim; j += 8) {
+            cv::v_int16x8 qv = cv::v_load_expand(q + j); // 8个int8扩展为int16
+            s0 += cv::v_dotprod(cv::v_load_expand(r0 + j), qv);
+            s1 += cv::v_dotprod(cv::v_load_expand(r1 + j), qv);
+            s2 += cv::v_dotprod(cv::v_load_expand(r2 + j), qv);
+            s3 += cv::v_dotprod(cv::v_load_expand(r3 + j), qv);
+        }
+        int d0 = cv::v_reduce_sum(s0);
+        int d1 = cv::v_reduce_sum(s1);
+        int d2 = cv::v_reduce_sum(s2);
+        int d3 = cv::v_reduce_sum(s3);
+        for (; j < dim; ++j) {
+            d0 += r0[j] * q[j];
+            d1 += r1[j] * q[j];
+            d2 += r2[j] * q[j];
+            d3 += r3[j] * q[j];
+        }
+        scores[i] = d0 * scales[i] * probeScale;
+        scores[i + 1] = d1 * scales[i + 1] * probeScale;
+        scores[i + 2] = d2 * scales[i + 2] * probeScale;
+        scores[i + 3] = d3 * scales[i + 3] * probeScale;
+    }
+#endif
+    // 剩余的行
+    for (; i < rows; ++i) {
+        const schar *r = codes.ptr<schar>(i);
+        int d = 0;
+        for (int j = 0; j < dim; ++j) {
+            d += r[j] * q[j];
+        }
+        scores[i] = d * scales[i] * probeScale;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef FACEMATCHER_H
+#define FACEMATCHER_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 一个候选匹配结果
+struct FaceMatch
+{
+    int index = -1;//在人脸库矩阵中的行号
+    float score = 0.0f;//余弦相似度
+};
+
+// 人脸库精确搜索：对行优先存储的特征矩阵做一次向量化的矩阵-向量点积，返回得分最高的 k 个候选
+// 特征均已 L2 归一化，点积即余弦相似度
+class FaceMatcher
+{
+public:
+    static void computeScores(const cv::Mat &gallery, const cv::Mat &probe, std::vector<float> &scores);//计算探针与每一行的相似度 gallery为NxD CV_32F，probe为1xD CV_32F
+    static std::vector<FaceMatch> topK(const cv::Mat &gallery, const cv::Mat &probe, int k);//返回相似度最高的k个候选，按得分从高到低排序
+    static std::vector<FaceMatch> selectTopK(const std::vector<float> &scores, int k);//从得分数组中选出最高的k个
+    static float dot(const float *a, const float *b, int dim);//两个向量的点积
+    static void computeScoresInt8(const cv::Mat &codes, const float *scales, const cv::Mat &probe, float probeScale, std::vector<float> &scores);//int8量化特征的近似相似度 codes为NxD CV_8S，scales为每行的缩放系数，probe为1xD CV_8S
+};
+
+#endif // FACEMATCHER_H
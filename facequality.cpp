@@ -0,0 +1,123 @@
+#include "facequality.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const int kAnalysisSize = 64; // 评估前把人脸缩放到的边长，阈值与人脸大小无关
+const double kPi = 3.14159265358979323846;
+
+double clamp01(double value) {
+    return std::max(0.0, std::min(1.0, value));
+}
+}
+
+QString FaceQuality::reasonText() const {
+    switch (reason) {
+    case Ok: return "合格";
+    case TooSmall: return "人脸太小";
+    case Blurry: return "图像模糊";
+    case TooDark: return "光线太暗";
+    case TooBright: return "光线过亮";
+    case LowContrast: return "对比度不足";
+    case OffAngle: return "请正对摄像头";
+    }
+    return QString();
+}
+
+FaceQualityScorer::FaceQualityScorer(const QualityConfig &config)
+    : eyesLoaded(false)
+{
+    setConfig(config);
+}
+
+void FaceQualityScorer::setConfig(const QualityConfig &config) {
+    settings = config;
+    eyesLoaded = false;
+    if (settings.checkPose && !settings.eyeCascadePath.isEmpty()) {
+        eyesLoaded = eyeCascade.load(settings.eyeCascadePath.toStdString());
+        if (!eyesLoaded) {
+            qDebug() << "Error loading eye cascade, pose check disabled:" << settings.eyeCascadePath;
+        }
+    }
+}
+
+const QualityConfig &FaceQualityScorer::config() const {
+    return settings;
+}
+
+FaceQuality FaceQualityScorer::evaluate(const cv::Mat &face) {
+    FaceQuality quality;
+    if (face.empty()) {
+        quality.reason = FaceQuality::TooSmall;
+        return quality;
+    }
+    quality.size = std::min(face.cols, face.rows);
+
+    // 缩放到固定尺寸的灰度图，各项指标都在同一尺度上比较
+    cv::Mat small;
+    cv::resize(face, small, cv::Size(kAnalysisSize, kAnalysisSize), 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3) {
+        cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = small;
+    }
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(gray, mean, stddev);
+    quality.brightness = mean[0];
+    quality.contrast = stddev[0];
+
+    // 拉普拉斯响应的方差：边缘越清晰越大，运动模糊和失焦时很小
+    cv::Laplacian(gray, laplacian, CV_16S);
+    cv::Scalar lapMean, lapStddev;
+    cv::meanStdDev(laplacian, lapMean, lapStddev);
+    quality.sharpness = lapStddev[0] * lapStddev[0];
+
+    if (quality.size < settings.minFaceSize) {
+        quality.reason = FaceQuality::TooSmall;
+    } else if (quality.brightness < settings.minBrightness) {
+        quality.reason = FaceQuality::TooDark;
+    } else if (quality.brightness > settings.maxBrightness) {
+        quality.reason = FaceQuality::TooBright;
+    } else if (quality.contrast < settings.minContrast) {
+        quality.reason = FaceQuality::LowContrast;
+    } else if (quality.sharpness < settings.minSharpness) {
+        quality.reason = FaceQuality::Blurry;
+    } else if (settings.checkPose && eyesLoaded && estimatePose(quality)
+               && (std::abs(quality.roll) > settings.maxRollDegrees || std::abs(quality.yaw) > settings.maxYawOffset)) {
+        quality.reason = FaceQuality::OffAngle;
+    }
+
+    // 综合得分：清晰度为主，尺寸、曝光和正脸程度为辅
+    double sharpScore = clamp01(quality.sharpness / (settings.minSharpness * 4.0));
+    double sizeScore = clamp01(quality.size / (settings.minFaceSize * 2.0));
+    double exposureScore = 1.0 - clamp01(std::abs(quality.brightness - 128.0) / 128.0);
+    double poseScore = 1.0 - clamp01(std::abs(quality.yaw) / std::max(settings.maxYawOffset, 1e-3) * 0.5);
+    quality.score = 0.5 * sharpScore + 0.2 * sizeScore + 0.15 * exposureScore + 0.15 * poseScore;
+    return quality;
+}
+
+bool FaceQualityScorer::estimatePose(FaceQuality &quality) {
+    // 只在人脸上半部分找眼睛
+    cv::Mat upper = gray(cv::Rect(0, 0, gray.cols, gray.rows / 2));
+    std::vector<cv::Rect> eyes;
+    eyeCascade.detectMultiScale(upper, eyes, 1.1, 3, 0, cv::Size(kAnalysisSize / 8, kAnalysisSize / 8));
+    if (eyes.size() < 2) {
+        return false;
+    }
+
+    // 取面积最大的两只眼睛，按横坐标分出左右
+    std::sort(eyes.begin(), eyes.end(), [](const cv::Rect &a, const cv::Rect &b) { return a.area() > b.area(); });
+    cv::Point2d first(eyes[0].x + eyes[0].width / 2.0, eyes[0].y + eyes[0].height / 2.0);
+    cv::Point2d second(eyes[1].x + eyes[1].width / 2.0, eyes[1].y + eyes[1].height / 2.0);
+    cv::Point2d left = first.x < second.x ? first : second;
+    cv::Point2d right = first.x < second.x ? second : first;
+    if (right.x - left.x < kAnalysisSize / 8.0) {
+        return false; // 两个框落在同一只眼睛上
+    }
+
+    quality.roll = std::atan2(right.y - left.y, right.x - left.x) * 180.0 / kPi;
+    quality.yaw = ((left.x + right.x) / 2.0 - kAnalysisSize / 2.0) / kAnalysisSize;
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef FACEQUALITY_H
+#define FACEQUALITY_H
+
+#include <QString>
+#include <opencv2/opencv.hpp>
+
+// 人脸质量门限，阈值都针对缩放到固定尺寸后的灰度人脸
+struct QualityConfig
+{
+    bool enabled = true;//是否启用质量门控 关闭时所有人脸都送去识别
+    int minFaceSize = 60;//最小人脸边长(原始帧像素) 更小的人脸特征不可靠
+    double minSharpness = 40.0;//拉普拉斯响应方差下限 低于该值视为模糊
+    double minBrightness = 40.0;//平均灰度下限
+    double maxBrightness = 220.0;//平均灰度上限
+    double minContrast = 20.0;//灰度标准差下限
+    bool checkPose = false;//是否用眼睛位置估计姿态 需要 eyeCascadePath
+    QString eyeCascadePath;//眼睛检测分类器(haarcascade_eye.xml)路径
+    double maxRollDegrees = 20.0;//两眼连线的最大倾斜角
+    double maxYawOffset = 0.2;//两眼中点偏离人脸中线的最大比例(相对人脸宽度)
+};
+
+// 一张人脸的质量评估结果
+struct FaceQuality
+{
+    enum Reason {
+        Ok,//质量合格
+        TooSmall,//人脸太小
+        Blurry,//模糊
+        TooDark,//太暗
+        TooBright,//过曝
+        LowContrast,//对比度不足
+        OffAngle//侧脸或倾斜过大
+    };
+
+    Reason reason = Ok;//不合格的原因
+    double size = 0.0;//人脸边长(像素)
+    double sharpness = 0.0;//拉普拉斯响应方差
+    double brightness = 0.0;//平均灰度
+    double contrast = 0.0;//灰度标准差
+    double roll = 0.0;//两眼连线倾斜角(度) 未估计姿态时为0
+    double yaw = 0.0;//两眼中点偏离中线的比例 未估计姿态时为0
+    double score = 0.0;//综合得分 0~1 用于在多张人脸中挑选最好的一张
+
+    bool acceptable() const { return reason == Ok; }//是否合格
+    QString reasonText() const;//不合格原因的中文说明
+};
+
+// 人脸质量评估：在检测和识别之间过滤模糊、过小、过暗过亮和侧脸的人脸，省去注定失败的特征提取和搜索
+// 人脸缩放到64x64灰度图后计算，每张人脸约几十微秒；不是线程安全的(姿态估计的分类器和缓冲区)，每个线程使用自己的实例
+class FaceQualityScorer
+{
+public:
+    explicit FaceQualityScorer(const QualityConfig &config = QualityConfig());
+
+    void setConfig(const QualityConfig &config);//修改阈值 启用姿态估计时加载眼睛分类器
+    const QualityConfig &config() const;//当前阈值
+    FaceQuality evaluate(const cv::Mat &face);//评估一张BGR人脸图像(原始分辨率裁剪)
+
+private:
+    bool estimatePose(FaceQuality &quality);//用眼睛位置估计倾斜和侧转 找不到两只眼睛时返回false
+
+    QualityConfig settings;//阈值
+    cv::CascadeClassifier eyeCascade;//眼睛检测分类器
+    bool eyesLoaded;//眼睛分类器是否加载成功
+    cv::Mat gray;//缩放后的灰度人脸，重复使用
+    cv::Mat laplacian;//拉普拉斯响应，重复使用
+};
+
+#endif // FACEQUALITY_H
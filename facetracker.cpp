@@ -0,0 +1,189 @@
+#include "facetracker.h"
+#include <algorithm>
+
+namespace {
+double intersectionOverUnion(const cv::Rect &a, const cv::Rect &b) {
+    double intersection = (a & b).area();
+    double unionArea = a.area() + b.area() - intersection;
+    return unionArea > 0 ? intersection / unionArea : 0.0;
+}
+}
+
+FaceTracker::FaceTracker(const TrackerConfig &config)
+    : config(config)
+    , nextId(1)
+    , framesSinceDetection(0)
+    , lost(false)
+{
+}
+
+void FaceTracker::setConfig(const TrackerConfig &config) {
+    this->config = config;
+}
+
+bool FaceTracker::needsDetection() const {
+    // 没有轨迹时每帧检测，以便及时发现新的人脸
+    return activeTracks.empty() || lost || framesSinceDetection + 1 >= config.detectionInterval;
+}
+
+void FaceTracker::update(const cv::Mat &gray, const std::vector<cv::Rect> &detections) {
+    framesSinceDetection = 0;
+    lost = false;
+
+    // 按交并比从大到小贪心关联检测框和轨迹
+    struct Pair { double iou; int track; int detection; };
+    std::vector<Pair> pairs;
+    for (int t = 0; t < static_cast<int>(activeTracks.size()); ++t) {
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            double iou = intersectionOverUnion(activeTracks[t].rect, detections[d]);
+            if (iou >= config.iouThreshold) {
+                Pair pair = {iou, t, d};
+                pairs.push_back(pair);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b) { return a.iou > b.iou; });
+
+    std::vector<bool> trackMatched(activeTracks.size(), false);
+    std::vector<bool> detectionMatched(detections.size(), false);
+    for (const Pair &pair : pairs) {
+        if (trackMatched[pair.track] || detectionMatched[pair.detection]) {
+            continue;
+        }
+        trackMatched[pair.track] = true;
+        detectionMatched[pair.detection] = true;
+
+        FaceTrack &track = activeTracks[pair.track];
+        track.rect = detections[pair.detection];
+        track.trackScore = 1.0f;
+        track.misses = 0;
+        refreshPatch(track, gray);
+    }
+
+    // 未关联到的轨迹累计丢失次数，超过上限后删除
+    std::vector<FaceTrack> kept;
+    for (size_t t = 0; t < activeTracks.size(); ++t) {
+        FaceTrack &track = activeTracks[t];
+        if (!trackMatched[t] && ++track.misses > config.maxMisses) {
+            continue;
+        }
+        kept.push_back(track);
+    }
+    activeTracks.swap(kept);
+
+    // 未关联到的检测框开始新的轨迹
+    for (size_t d = 0; d < detections.size(); ++d) {
+        if (detectionMatched[d]) {
+            continue;
+        }
+        FaceTrack track;
+        track.id = nextId++;
+        track.rect = detections[d];
+        refreshPatch(track, gray);
+        activeTracks.push_back(track);
+    }
+}
+
+void FaceTracker::predict(const cv::Mat &gray) {
+    ++framesSinceDetection;
+    cv::Rect bounds(0, 0, gray.cols, gray.rows);
+
+    for (FaceTrack &track : activeTracks) {
+        if (track.patch.empty() || track.misses > 0) {
+            continue;
+        }
+
+        // 在轨迹周围扩大一半的窗口内搜索
+        cv::Rect window(track.rect.x - track.rect.width / 2, track.rect.y - track.rect.height / 2,
+                        track.rect.width * 2, track.rect.height * 2);
+        window &= bounds;
+
+        cv::Mat smallWindow;
+        cv::resize(gray(window), smallWindow, cv::Size(), track.patchScale, track.patchScale, cv::INTER_AREA);
+        if (smallWindow.cols < track.patch.cols || smallWindow.rows < track.patch.rows) {
+            track.trackScore = 0.0f;
+            track.recheck = true;
+            lost = true;
+            continue;
+        }
+
+        cv::Mat result;
+        double maxScore = 0;
+        cv::Point maxLoc;
+        cv::matchTemplate(smallWindow, track.patch, result, cv::TM_CCOEFF_NORMED);
+        cv::minMaxLoc(result, nullptr, &maxScore, nullptr, &maxLoc);
+
+        track.trackScore = static_cast<float>(maxScore);
+        if (maxScore < config.minTrackScore) {
+            // 置信度下降：等待下一次检测确认，并重新识别
+            track.recheck = true;
+            lost = true;
+            continue;
+        }
+
+        cv::Rect moved(window.x + cvRound(maxLoc.x / track.patchScale), window.y + cvRound(maxLoc.y / track.patchScale),
+                       track.rect.width, track.rect.height);
+        moved &= bounds;
+        if (moved.area() > 0) {
+            track.rect = moved;
+        }
+    }
+}
+
+std::vector<int> FaceTracker::pendingRecognition(qint64 now) const {
+    std::vector<int> pending;
+    for (const FaceTrack &track : activeTracks) {
+        if (track.misses > 0) {
+            continue; // 本帧未看到的轨迹不识别
+        }
+        bool never = track.lastRecognized < 0;
+        bool expired = !never && now - track.lastRecognized >= config.recheckIntervalMs;
+        if (never || expired || track.recheck) {
+            pending.push_back(track.id);
+        }
+    }
+    return pending;
+}
+
+void FaceTracker::setIdentity(int trackId, int identity, float score, qint64 now) {
+    FaceTrack *t = track(trackId);
+    if (!t) {
+        return;
+    }
+    if (t->identity != identity || t->lastRecognized < 0) {
+        t->reported = false; // 身份变化后需要重新上报
+    }
+    t->identity = identity;
+    t->identityScore = score;
+    t->lastRecognized = now;
+    t->recheck = false;
+}
+
+FaceTrack *FaceTracker::track(int trackId) {
+    for (FaceTrack &t : activeTracks) {
+        if (t.id == trackId) {
+            return &t;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<FaceTrack> &FaceTracker::tracks() const {
+    return activeTracks;
+}
+
+void FaceTracker::reset() {
+    activeTracks.clear();
+    framesSinceDetection = 0;
+    lost = false;
+}
+
+void FaceTracker::refreshPatch(FaceTrack &track, const cv::Mat &gray) {
+    cv::Rect rect = track.rect & cv::Rect(0, 0, gray.cols, gray.rows);
+    if (rect.area() == 0) {
+        track.patch.release();
+        return;
+    }
+    track.patchScale = std::min(1.0, static_cast<double>(config.templateSize) / rect.width);
+    cv::resize(gray(rect), track.patch, cv::Size(), track.patchScale, track.patchScale, cv::INTER_AREA);
+}
@@ -0,0 +1,63 @@
+#ifndef FACETRACKER_H
+#define FACETRACKER_H
+
+#include <QtGlobal>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 跟踪器参数
+struct TrackerConfig
+{
+    int detectionInterval = 5;//每隔多少帧做一次全帧检测
+    qint64 recheckIntervalMs = 3000;//已识别的轨迹每隔多久重新识别一次(毫秒)
+    float minTrackScore = 0.6f;//模板匹配得分低于该值视为跟丢或置信度下降
+    double iouThreshold = 0.3;//检测框与轨迹关联的最小交并比
+    int maxMisses = 2;//连续多少次检测未关联到时删除轨迹
+    int templateSize = 48;//跟踪模板缩放后的宽度(像素)，越小越快
+};
+
+// 一条人脸轨迹
+struct FaceTrack
+{
+    int id = 0;//轨迹编号，在跟踪器生命周期内唯一
+    cv::Rect rect;//当前位置(跟踪器输入图像的坐标，FrameAnalyzer中为检测层) 绘制和裁剪前需按检测比例换算回原始帧
+    cv::Mat patch;//缩放后的灰度模板，用于两次检测之间的跟踪
+    double patchScale = 1.0;//模板相对跟踪器输入图像的缩放比例
+    float trackScore = 1.0f;//最近一次跟踪得分
+    int misses = 0;//连续未被检测关联的次数
+    int identity = -1;//识别出的员工主键 -1表示未知
+    float identityScore = 0.0f;//识别得分
+    qint64 lastRecognized = -1;//上次识别的时间(毫秒) -1表示还未识别
+    bool recheck = false;//跟踪置信度下降，需要重新识别
+    bool reported = false;//识别结果是否已上报
+};
+
+// 轻量多目标人脸跟踪器
+// 每隔 N 帧做一次全帧检测，按交并比把检测框关联到已有轨迹；两次检测之间用灰度模板匹配在局部窗口内更新位置
+// 每条轨迹只识别一次，之后只在超过重识别间隔或跟踪置信度下降时重新识别
+class FaceTracker
+{
+public:
+    explicit FaceTracker(const TrackerConfig &config = TrackerConfig());
+
+    void setConfig(const TrackerConfig &config);//修改参数
+    bool needsDetection() const;//本帧是否需要全帧检测
+    void update(const cv::Mat &gray, const std::vector<cv::Rect> &detections);//检测帧：用检测结果更新轨迹 gray为整帧灰度图
+    void predict(const cv::Mat &gray);//非检测帧：用模板匹配更新轨迹位置
+    std::vector<int> pendingRecognition(qint64 now) const;//需要识别的轨迹编号
+    void setIdentity(int trackId, int identity, float score, qint64 now);//记录识别结果
+    FaceTrack *track(int trackId);//按编号查找轨迹 不存在时返回nullptr
+    const std::vector<FaceTrack> &tracks() const;//当前所有轨迹
+    void reset();//清空所有轨迹
+
+private:
+    void refreshPatch(FaceTrack &track, const cv::Mat &gray);//用当前位置更新跟踪模板
+
+    TrackerConfig config;//参数
+    std::vector<FaceTrack> activeTracks;//当前轨迹
+    int nextId;//下一条轨迹的编号
+    int framesSinceDetection;//距离上次全帧检测的帧数
+    bool lost;//是否有轨迹跟丢，需要立即检测
+};
+
+#endif // FACETRACKER_H
@@ -0,0 +1,129 @@
+#ifndef FAIRQUEUE_H
+#define FAIRQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <deque>
+#include <vector>
+
+// 多路公平队列：每一路(如每个摄像头)有自己的有界队列，满时只丢弃该路最旧的元素
+// 取出时在各路之间轮转，帧率高的一路不会挤掉或饿死其他路
+template <typename T>
+class FairQueue
+{
+public:
+    explicit FairQueue(int laneCount = 1, int capacityPerLane = 2)
+        : lanes(laneCount > 0 ? laneCount : 1)
+        , capacity(capacityPerLane > 0 ? capacityPerLane : 1)
+        , dropped(lanes.size(), 0)
+        , next(0)
+        , count(0)
+        , closed(false)
+    {
+    }
+
+    // 放入第lane路 该路已满时丢弃该路最旧的元素 返回是否发生了丢弃
+    bool push(int lane, const T &item) {
+        QMutexLocker locker(&mutex);
+        if (closed || lane < 0 || lane >= static_cast<int>(lanes.size())) {
+            return false;
+        }
+        std::deque<T> &queue = lanes[lane];
+        bool droppedOldest = false;
+        while (static_cast<int>(queue.size()) >= capacity) {
+            queue.pop_front();
+            --count;
+            ++dropped[lane];
+            droppedOldest = true;
+        }
+        queue.push_back(item);
+        ++count;
+        notEmpty.wakeOne();
+        return droppedOldest;
+    }
+
+    // 从下一个非空的路取出最旧的元素 全部为空时最多等待timeoutMs毫秒 超时或队列关闭时返回false
+    bool pop(T &item, int timeoutMs) {
+        QMutexLocker locker(&mutex);
+        if (count == 0 && !closed) {
+            notEmpty.wait(&mutex, static_cast<unsigned long>(timeoutMs));
+        }
+        if (count == 0) {
+            return false;
+        }
+        int n = static_cast<int>(lanes.size());
+        for (int i = 0; i < n; ++i) {
+            int lane = (next + i) % n;
+            if (!lanes[lane].empty()) {
+                item = lanes[lane].front();
+                lanes[lane].pop_front();
+                --count;
+                next = (lane + 1) % n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 每一路最多取出一个元素(从下一路开始轮转)，最多取maxItems个 全部为空时最多等待timeoutMs毫秒 返回取出的个数
+    // 用于把几路同时就绪的元素合并处理，同一路的元素仍按顺序逐个处理
+    int popBatch(std::vector<T> &items, int maxItems, int timeoutMs) {
+        items.clear();
+        QMutexLocker locker(&mutex);
+        if (count == 0 && !closed) {
+            notEmpty.wait(&mutex, static_cast<unsigned long>(timeoutMs));
+        }
+        int n = static_cast<int>(lanes.size());
+        int start = next;
+        for (int i = 0; i < n && count > 0 && static_cast<int>(items.size()) < maxItems; ++i) {
+            int lane = (start + i) % n;
+            if (!lanes[lane].empty()) {
+                items.push_back(lanes[lane].front());
+                lanes[lane].pop_front();
+                --count;
+                next = (lane + 1) % n;
+            }
+        }
+        return static_cast<int>(items.size());
+    }
+
+    // 关闭队列并唤醒所有等待者，之后push被忽略
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        for (std::deque<T> &queue : lanes) {
+            queue.clear();
+        }
+        count = 0;
+        notEmpty.wakeAll();
+    }
+
+    // 重新打开已关闭的队列
+    void reopen() {
+        QMutexLocker locker(&mutex);
+        closed = false;
+    }
+
+    int size() const {
+        QMutexLocker locker(&mutex);
+        return count;
+    }
+
+    quint64 droppedCount(int lane) const {
+        QMutexLocker locker(&mutex);
+        return lane >= 0 && lane < static_cast<int>(dropped.size()) ? dropped[lane] : 0;
+    }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    std::vector<std::deque<T>> lanes;//各路的队列
+    int capacity;//每一路的最大容量
+    std::vector<quint64> dropped;//各路累计丢弃的元素个数
+    int next;//下一次从哪一路开始查找
+    int count;//所有路的元素总数
+    bool closed;//是否已关闭
+};
+
+#endif // FAIRQUEUE_H
@@ -0,0 +1,349 @@
+#include "frameanalyzer.h"
+#include "metrics.h"
+#include <cmath>
+
+namespace {
+const int kTopK = 3; // 每张人脸返回的候选个数
+
+// 按比例缩放矩形
+cv::Rect scaleRect(const cv::Rect &rect, double scale) {
+    return cv::Rect(cvRound(rect.x * scale), cvRound(rect.y * scale), cvRound(rect.width * scale), cvRound(rect.height * scale));
+}
+}
+
+FrameAnalyzer::FrameAnalyzer(const FaceGallery *gallery)
+    : gallery(gallery)
+    , detectionScale(1.0)
+    , recognitions(0)
+    , qualityRejected(0)
+{
+}
+
+bool FrameAnalyzer::setDetectorConfig(const DetectorConfig &config) {
+    // 检测器看到的是缩小后的图像，最小人脸尺寸按同样比例换算
+    detectionScale = config.detectionScale > 0.0 && config.detectionScale < 1.0 ? config.detectionScale : 1.0;
+    DetectorConfig scaled = config;
+    scaled.minFaceSize = cvRound(config.minFaceSize * detectionScale);
+
+    faceDetector.reset(FaceDetector::create(scaled));
+    if (!faceDetector && config.backend != DetectorConfig::Haar) {
+        // 深度学习模型加载失败时退回 Haar 分类器
+        DetectorConfig fallback = scaled;
+        fallback.backend = DetectorConfig::Haar;
+        faceDetector.reset(FaceDetector::create(fallback));
+    }
+    for (auto &entry : motions) {
+        entry.second.setConfig(scaledMotionConfig());
+    }
+    reset();
+    return faceDetector != nullptr;
+}
+
+void FrameAnalyzer::loadEmbedder(const QString &modelPath, int dnnBackend, int dnnTarget) {
+    embedder.load(modelPath, dnnBackend, dnnTarget);
+}
+
+void FrameAnalyzer::setTrackerConfig(const TrackerConfig &config) {
+    trackerConfig = config;
+    for (auto &entry : trackers) {
+        entry.second.setConfig(config);
+    }
+}
+
+void FrameAnalyzer::setQualityConfig(const QualityConfig &config) {
+    qualityScorer.setConfig(config);
+}
+
+void FrameAnalyzer::setMotionConfig(const MotionConfig &config) {
+    motionConfig = config;
+    for (auto &entry : motions) {
+        entry.second.setConfig(scaledMotionConfig());
+    }
+}
+
+MotionConfig FrameAnalyzer::scaledMotionConfig() const {
+    MotionConfig scaled = motionConfig;
+    scaled.padding = cvRound(motionConfig.padding * detectionScale);
+    return scaled;
+}
+
+void FrameAnalyzer::reset() {
+    for (auto &entry : trackers) {
+        entry.second.reset();
+    }
+    for (auto &entry : motions) {
+        entry.second.reset();
+    }
+}
+
+FaceTracker &FrameAnalyzer::trackerFor(int cameraId) {
+    auto it = trackers.find(cameraId);
+    if (it == trackers.end()) {
+        it = trackers.emplace(cameraId, FaceTracker(trackerConfig)).first;
+    }
+    return it->second;
+}
+
+MotionDetector &FrameAnalyzer::motionFor(int cameraId) {
+    auto it = motions.find(cameraId);
+    if (it == motions.end()) {
+        it = motions.emplace(cameraId, MotionDetector(scaledMotionConfig())).first;
+    }
+    return it->second;
+}
+
+std::vector<RecognitionEvent> FrameAnalyzer::analyze(FramePacket &packet) {
+    Stage stage;
+    if (!prepare(packet, stage)) {
+        return std::vector<RecognitionEvent>();
+    }
+    if (stage.detect) {
+        detectOne(stage);
+    }
+    return finish(packet, stage);
+}
+
+std::vector<RecognitionEvent> FrameAnalyzer::analyzeBatch(std::vector<FramePacket> &packets) {
+    std::vector<Stage> stages(packets.size());
+    std::vector<bool> active(packets.size(), false);
+    std::vector<cv::Mat> batch;
+    std::vector<size_t> batchStages;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        active[i] = prepare(packets[i], stages[i]);
+        if (!active[i] || !stages[i].detect) {
+            continue;
+        }
+        // 整帧检测的帧攒在一起，局部检测的区域大小各异，仍逐帧检测(同一帧的区域已合并为一个批次)
+        if (stages[i].fullFrame) {
+            batch.push_back(stages[i].image);
+            batchStages.push_back(i);
+        } else {
+            detectOne(stages[i]);
+        }
+    }
+
+    if (batch.size() == 1) {
+        detectOne(stages[batchStages[0]]);
+    } else if (!batch.empty()) {
+        std::vector<std::vector<cv::Rect>> faces;
+        {
+            ScopedTimer timer(Metrics::Detect);
+            faces = faceDetector->detectBatch(batch);
+        }
+        for (size_t j = 0; j < batchStages.size(); ++j) {
+            stages[batchStages[j]].detections = faces[j];
+            Metrics::instance().add(Metrics::FacesDetected, static_cast<qint64>(faces[j].size()));
+        }
+    }
+
+    std::vector<RecognitionEvent> events;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        if (active[i]) {
+            std::vector<RecognitionEvent> frameEvents = finish(packets[i], stages[i]);
+            events.insert(events.end(), frameEvents.begin(), frameEvents.end());
+        }
+    }
+    return events;
+}
+
+bool FrameAnalyzer::prepare(FramePacket &packet, Stage &stage) {
+    if (!faceDetector || packet.frame.empty()) {
+        return false;
+    }
+
+    FaceTracker &tracker = trackerFor(packet.cameraId);
+    MotionDetector &motion = motionFor(packet.cameraId);
+
+    // 取金字塔中的检测层，采集线程没有生成时在这里生成
+    const cv::Mat *work = &packet.level(detectionScale, &stage.scale);
+    if (std::abs(stage.scale - detectionScale) > 1e-3) {
+        packet.buildPyramid(std::vector<double>(1, detectionScale));
+        work = &packet.level(detectionScale, &stage.scale);
+    }
+    stage.image = *work;
+
+    // 画面静止且没有正在跟踪的人脸时，跳过检测、跟踪和识别
+    bool moving = false;
+    {
+        ScopedTimer timer(Metrics::Motion);
+        moving = motion.update(stage.image);
+    }
+    if (!moving && tracker.tracks().empty()) {
+        packet.faces.clear();
+        Metrics::instance().add(Metrics::FramesIdle);
+        return false;
+    }
+
+    // 只在需要时做检测，其余帧用模板匹配跟踪
+    stage.detect = tracker.needsDetection();
+    if (stage.detect) {
+        // 检测区域：变化区域加上已有人脸附近，变化很大时退化为整帧
+        cv::Rect bounds(0, 0, stage.image.cols, stage.image.rows);
+        if (moving) {
+            stage.regions = motion.regions();
+        }
+        for (const FaceTrack &track : tracker.tracks()) {
+            int pad = qMax(cvRound(motionConfig.padding * detectionScale), track.rect.width / 2); // 轨迹在检测层坐标
+            cv::Rect region(track.rect.x - pad, track.rect.y - pad, track.rect.width + 2 * pad, track.rect.height + 2 * pad);
+            stage.regions.push_back(region & bounds);
+        }
+        MotionDetector::mergeOverlapping(stage.regions);
+        stage.fullFrame = stage.regions.size() == 1 && stage.regions[0] == bounds;
+    }
+    return true;
+}
+
+void FrameAnalyzer::detectOne(Stage &stage) {
+    {
+        ScopedTimer timer(Metrics::Detect);
+        stage.detections = stage.fullFrame ? faceDetector->detect(stage.image) : faceDetector->detectRegions(stage.image, stage.regions);
+    }
+    Metrics::instance().add(Metrics::FacesDetected, static_cast<qint64>(stage.detections.size()));
+}
+
+std::vector<RecognitionEvent> FrameAnalyzer::finish(FramePacket &packet, Stage &stage) {
+    std::vector<RecognitionEvent> events;
+    FaceTracker &tracker = trackerFor(packet.cameraId);
+    Metrics &metrics = Metrics::instance();
+    double scale = stage.scale;
+
+    {
+        ScopedTimer timer(Metrics::Convert);
+        cv::cvtColor(stage.image, gray, cv::COLOR_BGR2GRAY);
+    }
+    if (stage.detect) {
+        tracker.update(gray, stage.detections);
+    } else {
+        ScopedTimer timer(Metrics::Track);
+        tracker.predict(gray);
+    }
+
+    // 人脸框换算回原始帧坐标
+    cv::Rect frameBounds(0, 0, packet.frame.cols, packet.frame.rows);
+    packet.faces.clear();
+    for (const FaceTrack &track : tracker.tracks()) {
+        if (track.misses == 0) {
+            packet.faces.push_back(scaleRect(track.rect, 1.0 / scale) & frameBounds);
+        }
+    }
+
+    // 每条轨迹只识别一次，到期或置信度下降时才重新识别
+    for (int trackId : tracker.pendingRecognition(packet.captureTime)) {
+        FaceTrack *track = tracker.track(trackId);
+        // 识别用的人脸从原始分辨率的帧中裁剪
+        cv::Rect face = scaleRect(track->rect, 1.0 / scale) & frameBounds;
+
+        // 模糊、过小、曝光不当的人脸不提取特征，留在待识别列表中等质量合格的帧
+        if (!checkQuality(packet.frame(face), nullptr)) {
+            continue;
+        }
+
+        std::vector<GalleryMatch> matches = identify(packet.frame(face));
+        bool recognized = !matches.empty() && matches[0].score >= embedder.matchThreshold();
+        tracker.setIdentity(trackId, recognized ? matches[0].index : -1,
+                            matches.empty() ? 0.0f : matches[0].score, packet.captureTime);
+
+        // 身份首次确定或发生变化时才上报
+        if (!track->reported) {
+            track->reported = true;
+            RecognitionEvent event;
+            event.cameraId = packet.cameraId;
+            event.trackId = trackId;
+            event.recognized = recognized;
+            if (recognized) {
+                event.score = matches[0].score;
+                event.employee = matches[0].employee;
+            }
+            metrics.add(recognized ? Metrics::Matches : Metrics::Unrecognized);
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+std::vector<RecognitionEvent> FrameAnalyzer::recognizeImage(const cv::Mat &frame) {
+    std::vector<RecognitionEvent> events;
+    if (!faceDetector || frame.empty()) {
+        return events;
+    }
+
+    // 与视频帧一样在缩小的图像上检测，从原始图像裁剪人脸识别
+    cv::Mat small = frame;
+    if (detectionScale < 1.0) {
+        cv::resize(frame, small, cv::Size(), detectionScale, detectionScale, cv::INTER_AREA);
+    }
+    std::vector<cv::Rect> detections;
+    {
+        ScopedTimer timer(Metrics::Detect);
+        detections = faceDetector->detect(small);
+    }
+    Metrics::instance().add(Metrics::FacesDetected, static_cast<qint64>(detections.size()));
+
+    cv::Rect frameBounds(0, 0, frame.cols, frame.rows);
+    for (const cv::Rect &detection : detections) {
+        RecognitionEvent event;
+        event.face = scaleRect(detection, 1.0 / detectionScale) & frameBounds;
+        if (event.face.empty() || !checkQuality(frame(event.face), &event.quality)) {
+            events.push_back(event);
+            continue;
+        }
+
+        std::vector<GalleryMatch> matches = identify(frame(event.face));
+        event.recognized = !matches.empty() && matches[0].score >= embedder.matchThreshold();
+        event.score = matches.empty() ? 0.0f : matches[0].score;
+        if (event.recognized) {
+            event.employee = matches[0].employee;
+        }
+        Metrics::instance().add(event.recognized ? Metrics::Matches : Metrics::Unrecognized);
+        events.push_back(event);
+    }
+    return events;
+}
+
+bool FrameAnalyzer::checkQuality(const cv::Mat &face, FaceQuality::Reason *reason) {
+    if (!qualityScorer.config().enabled) {
+        return true;
+    }
+    FaceQuality quality;
+    {
+        ScopedTimer timer(Metrics::Quality);
+        quality = qualityScorer.evaluate(face);
+    }
+    if (reason) {
+        *reason = quality.reason;
+    }
+    if (!quality.acceptable()) {
+        ++qualityRejected;
+        Metrics::instance().add(Metrics::QualityRejected);
+        return false;
+    }
+    return true;
+}
+
+std::vector<GalleryMatch> FrameAnalyzer::identify(const cv::Mat &face) {
+    cv::Mat probe;
+    {
+        ScopedTimer timer(Metrics::Embed);
+        probe = embedder.extract(face);
+    }
+    std::vector<GalleryMatch> matches;
+    {
+        ScopedTimer timer(Metrics::Match);
+        matches = gallery->search(probe, kTopK);
+    }
+    ++recognitions;
+    Metrics::instance().add(Metrics::Recognitions);
+    return matches;
+}
+
+FaceDetector *FrameAnalyzer::detector() const {
+    return faceDetector.get();
+}
+
+qint64 FrameAnalyzer::recognitionCount() const {
+    return recognitions;
+}
+
+qint64 FrameAnalyzer::qualityRejectedCount() const {
+    return qualityRejected;
+}
@@ -0,0 +1,88 @@
+#ifndef FRAMEANALYZER_H
+#define FRAMEANALYZER_H
+
+#include <QString>
+#include <map>
+#include <memory>
+#include <vector>
+#include "capturethread.h"
+#include "facedetector.h"
+#include "faceembedder.h"
+#include "facegallery.h"
+#include "facequality.h"
+#include "facetracker.h"
+#include "motiondetector.h"
+
+// 一次识别结果：每条轨迹的身份确定(或变化)时产生一次
+struct RecognitionEvent
+{
+    int cameraId = 0;//摄像头编号
+    int trackId = 0;//轨迹编号(在同一摄像头内唯一)
+    bool recognized = false;//是否识别为已录入员工
+    float score = 0.0f;//余弦相似度
+    EmployeeRecord employee;//识别出的员工
+    cv::Rect face;//人脸框(原始帧坐标) 只在单张图像识别中填写
+    FaceQuality::Reason quality = FaceQuality::Ok;//质量不合格时的原因 此时未做识别
+};
+
+// 单帧分析：运动门控 -> 检测 -> 跟踪 -> 质量评估 -> 识别
+// 画面静止且没有人脸时整帧跳过，有运动时只在变化区域和已有人脸附近检测
+// 运动检测、人脸检测和跟踪在金字塔的检测层上进行，识别用的人脸从原始分辨率的帧中裁剪
+// 不依赖线程和界面，识别线程和无界面回放模式共用；不是线程安全的，每个线程使用自己的实例
+// 每个摄像头有自己的跟踪器，同一个实例可以轮流处理多个摄像头的帧
+class FrameAnalyzer
+{
+public:
+    explicit FrameAnalyzer(const FaceGallery *gallery);
+
+    bool setDetectorConfig(const DetectorConfig &config);//按配置创建检测器 加载失败时退回Haar 返回是否有可用的检测器
+    void loadEmbedder(const QString &modelPath, int dnnBackend, int dnnTarget);//加载人脸特征提取模型
+    void setTrackerConfig(const TrackerConfig &config);//设置跟踪参数
+    void setMotionConfig(const MotionConfig &config);//设置运动检测参数 padding为原始帧像素 按检测比例换算
+    void setQualityConfig(const QualityConfig &config);//设置人脸质量门限
+    void reset();//清空所有摄像头的跟踪状态(切换视频源时使用)
+
+    std::vector<RecognitionEvent> analyze(FramePacket &packet);//分析一帧 使用packet.cameraId对应的跟踪器 填写packet.faces 返回本帧产生的识别结果
+    std::vector<RecognitionEvent> analyzeBatch(std::vector<FramePacket> &packets);//分析几个摄像头各一帧 需要整帧检测的帧合并为一次批量检测(SSD一次前向计算) 每个摄像头最多一帧
+    std::vector<RecognitionEvent> recognizeImage(const cv::Mat &frame);//识别一张独立的BGR图像中的所有人脸 不使用运动门控和跟踪 每张人脸一个结果
+
+    FaceDetector *detector() const;//当前检测器
+    qint64 recognitionCount() const;//累计识别(特征提取+搜索)次数
+    qint64 qualityRejectedCount() const;//累计因质量不合格跳过识别的次数
+
+private:
+    // 一帧在检测前后的中间状态：批量分析时各帧先分别准备，合并检测后再分别跟踪和识别
+    struct Stage
+    {
+        double scale = 1.0;//检测层相对原始帧的比例
+        cv::Mat image;//检测层(引用帧中的图像，不复制)
+        bool detect = false;//本帧是否需要检测
+        bool fullFrame = false;//是否整帧检测
+        std::vector<cv::Rect> regions;//局部检测的区域
+        std::vector<cv::Rect> detections;//检测结果(检测层坐标)
+    };
+
+    bool prepare(FramePacket &packet, Stage &stage);//运动门控并决定检测区域 画面静止且没有人脸时返回false
+    void detectOne(Stage &stage);//单独检测一帧(整帧或局部区域)
+    std::vector<RecognitionEvent> finish(FramePacket &packet, Stage &stage);//跟踪、质量评估和识别
+    FaceTracker &trackerFor(int cameraId);//摄像头对应的跟踪器 不存在时创建
+    MotionDetector &motionFor(int cameraId);//摄像头对应的运动检测器 不存在时创建
+    MotionConfig scaledMotionConfig() const;//运动检测器看到的是检测层，扩展像素按检测比例换算
+    bool checkQuality(const cv::Mat &face, FaceQuality::Reason *reason);//质量门控 不合格时计数并返回false
+    std::vector<GalleryMatch> identify(const cv::Mat &face);//提取特征并在人脸库中搜索
+
+    const FaceGallery *gallery;//共享的内存人脸库
+    std::unique_ptr<FaceDetector> faceDetector;//人脸检测器
+    FaceEmbedder embedder;//人脸特征提取器
+    TrackerConfig trackerConfig;//跟踪参数
+    std::map<int, FaceTracker> trackers;//摄像头编号 -> 人脸跟踪器
+    MotionConfig motionConfig;//运动检测参数(原始帧像素)
+    std::map<int, MotionDetector> motions;//摄像头编号 -> 运动检测器
+    FaceQualityScorer qualityScorer;//人脸质量评估
+    cv::Mat gray;//检测层的灰度图缓冲区，重复使用
+    double detectionScale;//检测和跟踪所用的分辨率比例
+    qint64 recognitions;//累计识别次数
+    qint64 qualityRejected;//累计质量不合格次数
+};
+
+#endif // FRAMEANALYZER_H
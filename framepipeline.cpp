@@ -0,0 +1,157 @@
+#include "framepipeline.h"
+#include <algorithm>
+#include <functional>
+
+FramePipeline::FramePipeline(const QStringList &sources, const DetectorConfig &config, const QString &embeddingModelPath, const FaceGallery *gallery,
+                             AttendanceWriter *writer, int workerCount, QObject *parent)
+    : QObject(parent)
+    , sources(sources)
+{
+    int cameras = sources.size();
+    if (workerCount <= 0) {
+        workerCount = defaultWorkerCount(cameras);
+    }
+    workerCount = qBound(1, workerCount, qMax(1, cameras));
+
+    QVector<BoundedQueue<FramePacket> *> previews;
+    for (int i = 0; i < cameras; ++i) {
+        previewQueues.emplace_back(new BoundedQueue<FramePacket>(2));
+        previews.append(previewQueues.back().get());
+    }
+
+    for (int w = 0; w < workerCount; ++w) {
+        // 每个识别线程一个公平队列，每个摄像头占一路
+        analysisQueues.emplace_back(new FairQueue<FramePacket>(cameras, 2));
+        RecognitionWorker *worker = new RecognitionWorker(config, embeddingModelPath, gallery, this);
+        worker->setQueues(analysisQueues.back().get(), previews);
+        worker->setAttendanceWriter(writer);
+
+        // 信号从工作线程发出，自动以排队方式转发到界面线程
+        connect(worker, &RecognitionWorker::faceRecognized, this, &FramePipeline::faceRecognized);
+        connect(worker, &RecognitionWorker::detectorStats, this, &FramePipeline::detectorStats);
+        connect(worker, &RecognitionWorker::detectorFailed, this, &FramePipeline::detectorFailed);
+        workers.append(worker);
+    }
+
+    // 采集线程生成的分辨率金字塔，至少包含检测所用的一层
+    std::vector<double> scales = config.pyramidScales;
+    if (config.detectionScale < 1.0 && std::find(scales.begin(), scales.end(), config.detectionScale) == scales.end()) {
+        scales.push_back(config.detectionScale);
+    }
+    std::sort(scales.begin(), scales.end(), std::greater<double>());
+
+    for (int i = 0; i < cameras; ++i) {
+        CaptureThread *capture = new CaptureThread(i, sources[i], this);
+        capture->setQueues(analysisQueues[i % workerCount].get(), previews[i]);
+        capture->setPyramidScales(scales);
+        connect(capture, &CaptureThread::opened, this, &FramePipeline::cameraOpened);
+        connect(capture, &CaptureThread::openFailed, this, &FramePipeline::cameraOpenFailed);
+        captures.append(capture);
+    }
+}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+int FramePipeline::defaultWorkerCount(int cameraCount) {
+    return qBound(1, QThread::idealThreadCount() / 2, qMax(1, cameraCount));
+}
+
+void FramePipeline::start() {
+    for (int i = 0; i < captures.size(); ++i) {
+        if (!captures[i]->isRunning()) {
+            previewQueues[i]->reopen();
+            captures[i]->start();
+        }
+    }
+}
+
+void FramePipeline::stop() {
+    stopAnalysis();
+    for (CaptureThread *capture : captures) {
+        capture->requestInterruption();
+    }
+    for (auto &queue : previewQueues) {
+        queue->close();
+    }
+    for (CaptureThread *capture : captures) {
+        capture->wait();
+    }
+}
+
+void FramePipeline::startAnalysis() {
+    if (isAnalyzing()) {
+        return;
+    }
+    for (size_t w = 0; w < analysisQueues.size(); ++w) {
+        analysisQueues[w]->reopen();
+        workers[static_cast<int>(w)]->start();
+    }
+    for (CaptureThread *capture : captures) {
+        capture->setAnalysisEnabled(true);
+    }
+}
+
+void FramePipeline::stopAnalysis() {
+    // 先让采集线程改为直接送预览，再停止识别线程
+    for (CaptureThread *capture : captures) {
+        capture->setAnalysisEnabled(false);
+    }
+    for (RecognitionWorker *worker : workers) {
+        worker->requestInterruption();
+    }
+    for (auto &queue : analysisQueues) {
+        queue->close();
+    }
+    for (RecognitionWorker *worker : workers) {
+        worker->wait();
+    }
+}
+
+bool FramePipeline::isAnalyzing() const {
+    for (RecognitionWorker *worker : workers) {
+        if (worker->isRunning()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FramePipeline::setDetectorConfig(const DetectorConfig &config) {
+    for (RecognitionWorker *worker : workers) {
+        worker->setDetectorConfig(config);
+    }
+}
+
+void FramePipeline::setNotificationQueue(NotificationQueue *queue) {
+    for (RecognitionWorker *worker : workers) {
+        worker->setNotificationQueue(queue);
+    }
+}
+
+int FramePipeline::cameraCount() const {
+    return sources.size();
+}
+
+int FramePipeline::workerCount() const {
+    return workers.size();
+}
+
+QString FramePipeline::source(int cameraId) const {
+    return sources.value(cameraId);
+}
+
+bool FramePipeline::takePreview(int cameraId, FramePacket &packet) {
+    if (cameraId < 0 || cameraId >= static_cast<int>(previewQueues.size())) {
+        return false;
+    }
+    return previewQueues[cameraId]->takeLatest(packet);
+}
+
+cv::Mat FramePipeline::latestFrame(int cameraId) const {
+    if (cameraId < 0 || cameraId >= captures.size()) {
+        return cv::Mat();
+    }
+    return captures[cameraId]->latestFrame();
+}
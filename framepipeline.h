@@ -0,0 +1,58 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "boundedqueue.h"
+#include "capturethread.h"
+#include "fairqueue.h"
+#include "recognitionworker.h"
+
+// 采集 -> 检测/识别 -> 界面显示 三级流水线
+// 各级之间用有界队列连接，满时丢弃最旧的帧；界面线程只负责绘制
+// 每个视频源一个采集线程，所有摄像头共用一组检测/识别线程、一个人脸库和一个考勤写入线程
+// 摄像头固定分配给识别线程(跟踪状态留在同一线程)，线程内在各摄像头之间轮转取帧，任何摄像头都不会被饿死
+class FramePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    FramePipeline(const QStringList &sources, const DetectorConfig &config, const QString &embeddingModelPath, const FaceGallery *gallery,
+                  AttendanceWriter *writer, int workerCount = 0, QObject *parent = nullptr);
+    ~FramePipeline();
+
+    static int defaultWorkerCount(int cameraCount);//默认的识别线程数：不超过摄像头数和CPU核数的一半
+
+    void start();//启动所有采集线程
+    void stop();//停止所有线程
+    void startAnalysis();//启动检测/识别线程
+    void stopAnalysis();//停止检测/识别线程
+    bool isAnalyzing() const;//是否正在检测
+    void setDetectorConfig(const DetectorConfig &config);//运行时切换检测器
+    void setNotificationQueue(NotificationQueue *queue);//设置识别线程发布通知的队列 在start之前调用
+
+    int cameraCount() const;//摄像头数量
+    int workerCount() const;//识别线程数量
+    QString source(int cameraId) const;//摄像头的视频源
+    bool takePreview(int cameraId, FramePacket &packet);//取出该摄像头最新的待显示帧 没有新帧时返回false
+    cv::Mat latestFrame(int cameraId = 0) const;//该摄像头最近采集到的原始帧
+
+signals:
+    void faceRecognized(const EmployeeRecord &employee, double score);//识别到员工
+    void cameraOpened(int cameraId);//摄像头已打开
+    void cameraOpenFailed(int cameraId);//摄像头打开失败
+    void detectorStats(const QString &backend, double averageMs, qint64 frames);//检测器耗时统计
+    void detectorFailed();//识别线程无法创建检测器 已退出
+
+private:
+    QStringList sources;//各摄像头的视频源
+    std::vector<std::unique_ptr<FairQueue<FramePacket>>> analysisQueues;//采集 -> 识别，每个识别线程一个
+    std::vector<std::unique_ptr<BoundedQueue<FramePacket>>> previewQueues;//采集/识别 -> 界面，每个摄像头一个
+    QVector<CaptureThread *> captures;//采集线程
+    QVector<RecognitionWorker *> workers;//检测/识别线程
+};
+
+#endif // FRAMEPIPELINE_H
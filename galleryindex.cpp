@@ -0,0 +1,880 @@
+#include "galleryindex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const quint32 kIndexMagic = 0x46474958; // "FGIX"
+const quint32 kIndexVersion = 1;
+const int kMinTrainSize = 1024; // 特征少于该数量时IVF不聚类，退化为单个列表
+const int kTrainPointsPerList = 32; // 每个聚类用于训练的采样点数
+const int kMaxLists = 4096; // 聚类个数上限
+const int kFp16Block = 256; // fp16模板每次解码的行数，解码缓冲区留在缓存中
+
+// 把多个聚类的候选合并为全局前k个
+void mergeTopK(std::vector<FaceMatch> &best, const FaceMatch &candidate, int k) {
+    if (static_cast<int>(best.size()) == k && candidate.score <= best.back().score) {
+        return;
+    }
+    auto pos = std::upper_bound(best.begin(), best.end(), candidate.score,
+                                [](float value, const FaceMatch &m) { return value > m.score; });
+    best.insert(pos, candidate);
+    if (static_cast<int>(best.size()) > k) {
+        best.pop_back();
+    }
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(std::ceil(p * values.size())) - 1;
+    return values[std::min(index, values.size() - 1)];
+}
+
+double mean(const std::vector<double> &values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    return sum / values.size();
+}
+
+double elapsedMs(int64 start) {
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+double megabytes(qint64 bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+// 随机单位向量，模拟员工特征
+cv::Mat randomUnitRows(cv::RNG &rng, int rows, int dimension) {
+    cv::Mat features(rows, dimension, CV_32F);
+    rng.fill(features, cv::RNG::NORMAL, 0, 1);
+    for (int i = 0; i < features.rows; ++i) {
+        cv::Mat row = features.row(i);
+        cv::normalize(row, row);
+    }
+    return features;
+}
+
+// 匹配结论：超过阈值时为第一名的id，否则为-1(未识别)
+int decision(const std::vector<FaceMatch> &matches, float threshold) {
+    return (!matches.empty() && matches[0].score >= threshold) ? matches[0].index : -1;
+}
+}
+
+GalleryIndex::~GalleryIndex()
+{
+}
+
+GalleryIndex *GalleryIndex::create(Type type) {
+    if (type == Ivf) {
+        return new IvfIndex;
+    }
+    if (type == Int8 || type == Fp16) {
+        return new QuantizedIndex(type);
+    }
+    return new BruteForceIndex;
+}
+
+bool GalleryIndex::save(const QString &path, quint64 signature) const {
+    // 先写临时文件再替换，避免中途退出留下损坏的索引
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error saving gallery index:" << path;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << kIndexMagic << kIndexVersion << static_cast<qint32>(type()) << signature;
+    write(out);
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool GalleryIndex::load(const QString &path, quint64 signature) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 storedType = -1;
+    quint64 storedSignature = 0;
+    in >> magic >> version >> storedType >> storedSignature;
+    if (magic != kIndexMagic || version != kIndexVersion || storedType != type() || storedSignature != signature) {
+        return false; // 文件与当前人脸库不一致，需要重建
+    }
+    return read(in) && in.status() == QDataStream::Ok;
+}
+
+void GalleryIndex::writeMat(QDataStream &out, const cv::Mat &mat) {
+    out << static_cast<qint32>(mat.rows) << static_cast<qint32>(mat.cols);
+    if (!mat.empty()) {
+        cv::Mat continuous = mat.isContinuous() ? mat : mat.clone();
+        out.writeRawData(reinterpret_cast<const char *>(continuous.data), static_cast<int>(continuous.total() * continuous.elemSize()));
+    }
+}
+
+bool GalleryIndex::readMat(QDataStream &in, cv::Mat &mat) {
+    qint32 rows = 0;
+    qint32 cols = 0;
+    in >> rows >> cols;
+    if (in.status() != QDataStream::Ok || rows < 0 || cols < 0) {
+        return false;
+    }
+    if (rows == 0) {
+        mat = cv::Mat(0, cols, CV_32F);
+        return true;
+    }
+    mat.create(rows, cols, CV_32F);
+    int bytes = static_cast<int>(mat.total() * mat.elemSize());
+    return in.readRawData(reinterpret_cast<char *>(mat.data), bytes) == bytes;
+}
+
+QString GalleryIndex::compare(GalleryIndex &exact, GalleryIndex &approximate, const cv::Mat &queries, int k) {
+    std::vector<double> exactTimes;
+    std::vector<double> approxTimes;
+    double recallSum = 0.0;
+    int top1Agree = 0;
+
+    for (int i = 0; i < queries.rows; ++i) {
+        cv::Mat probe = queries.row(i);
+
+        int64 start = cv::getTickCount();
+        std::vector<FaceMatch> truth = exact.search(probe, k);
+        exactTimes.push_back(elapsedMs(start));
+
+        start = cv::getTickCount();
+        std::vector<FaceMatch> found = approximate.search(probe, k);
+        approxTimes.push_back(elapsedMs(start));
+
+        // 召回率：近似结果中命中精确前k个的比例
+        int hits = 0;
+        for (const FaceMatch &t : truth) {
+            for (const FaceMatch &f : found) {
+                if (f.index == t.index) {
+                    ++hits;
+                    break;
+                }
+            }
+        }
+        if (!truth.empty()) {
+            recallSum += static_cast<double>(hits) / truth.size();
+        }
+        if (!truth.empty() && !found.empty() && truth[0].index == found[0].index) {
+            ++top1Agree;
+        }
+    }
+
+    int n = std::max(1, queries.rows);
+    double exactMean = mean(exactTimes);
+    double approxMean = mean(approxTimes);
+    QString report;
+    QTextStream stream(&report);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(4);
+    stream << approximate.name()
+           << "  recall@" << k << "=" << recallSum / n
+           << "  top1=" << static_cast<double>(top1Agree) / n
+           << "  avg=" << approxMean << "ms p99=" << percentile(approxTimes, 0.99) << "ms"
+           << "  exact avg=" << exactMean << "ms p99=" << percentile(exactTimes, 0.99) << "ms"
+           << "  speedup=x" << (approxMean > 0 ? exactMean / approxMean : 0.0);
+    return report;
+}
+
+QString GalleryIndex::syntheticReport(int gallerySize, int dimension, int queryCount, int k) {
+    cv::RNG rng(20230713);
+    cv::Mat features = randomUnitRows(rng, gallerySize, dimension);
+    std::vector<int> ids(gallerySize);
+    for (int i = 0; i < gallerySize; ++i) {
+        ids[i] = i;
+    }
+
+    // 查询为库中随机员工加噪声，模拟同一个人的另一张照片
+    cv::Mat queries(queryCount, dimension, CV_32F);
+    for (int i = 0; i < queryCount; ++i) {
+        cv::Mat noise(1, dimension, CV_32F);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 0.05);
+        cv::Mat q = features.row(rng.uniform(0, gallerySize)) + noise;
+        cv::normalize(q, q);
+        q.copyTo(queries.row(i));
+    }
+
+    QString report;
+    QTextStream stream(&report);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(1);
+
+    int64 start = cv::getTickCount();
+    BruteForceIndex exact;
+    exact.build(features, ids);
+    stream << "gallery=" << gallerySize << " dim=" << dimension << " queries=" << queryCount << " k=" << k << "\n";
+    stream << "build " << exact.name() << ": " << elapsedMs(start) << "ms\n";
+
+    start = cv::getTickCount();
+    IvfIndex ivf;
+    ivf.build(features, ids);
+    stream << "build " << ivf.name() << ": " << elapsedMs(start) << "ms\n";
+
+    // 不同 nprobe 下的召回率与延迟，用于调参
+    for (int nprobe = 1; nprobe <= ivf.listCount(); nprobe *= 2) {
+        ivf.setProbeCount(nprobe);
+        stream << compare(exact, ivf, queries, k) << "\n";
+        if (nprobe >= 64) {
+            break;
+        }
+    }
+    return report;
+}
+
+QString GalleryIndex::quantizationReport(int gallerySize, int dimension, int queryCount, int k, float threshold) {
+    cv::RNG rng(20230713);
+    cv::Mat features = randomUnitRows(rng, gallerySize, dimension);
+    std::vector<int> ids(gallerySize);
+    for (int i = 0; i < gallerySize; ++i) {
+        ids[i] = i;
+    }
+
+    // 一半查询为库中员工加不同强度的噪声，相似度分布在阈值两侧；另一半为库外的人
+    cv::Mat queries(queryCount, dimension, CV_32F);
+    for (int i = 0; i < queryCount; ++i) {
+        cv::Mat q;
+        if (i % 2 == 0) {
+            cv::Mat noise(1, dimension, CV_32F);
+            rng.fill(noise, cv::RNG::NORMAL, 0, rng.uniform(0.03, 0.15));
+            q = features.row(rng.uniform(0, gallerySize)) + noise;
+            cv::normalize(q, q);
+        } else {
+            q = randomUnitRows(rng, 1, dimension);
+        }
+        q.copyTo(queries.row(i));
+    }
+
+    QString report;
+    QTextStream stream(&report);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(4);
+    stream << "gallery=" << gallerySize << " dim=" << dimension << " queries=" << queryCount
+           << " k=" << k << " threshold=" << threshold << "\n";
+
+    BruteForceIndex exact;
+    exact.build(features, ids);
+    std::vector<std::vector<FaceMatch>> truth;
+    std::vector<double> exactTimes;
+    for (int i = 0; i < queries.rows; ++i) {
+        int64 start = cv::getTickCount();
+        truth.push_back(exact.search(queries.row(i), k));
+        exactTimes.push_back(elapsedMs(start));
+    }
+    double exactMean = mean(exactTimes);
+    stream << exact.name() << "  memory=" << megabytes(exact.memoryBytes()) << "MB"
+           << "  avg=" << exactMean << "ms p99=" << percentile(exactTimes, 0.99) << "ms\n";
+
+    // 重排直接从全精度矩阵取特征，界面运行时取自内存映射的模板文件
+    QuantizedIndex::FeatureSource source = [&features](int id) { return features.row(id); };
+    const Type precisions[] = {Int8, Fp16};
+    const int rerankCounts[] = {0, 16};
+    for (Type precision : precisions) {
+        for (int rerank : rerankCounts) {
+            QuantizedIndex quantized(precision, rerank);
+            quantized.setFeatureSource(source);
+            quantized.build(features, ids);
+
+            std::vector<double> times;
+            double recallSum = 0.0;
+            int top1Agree = 0;
+            int changed = 0;
+            double maxError = 0.0;
+            for (int i = 0; i < queries.rows; ++i) {
+                int64 start = cv::getTickCount();
+                std::vector<FaceMatch> found = quantized.search(queries.row(i), k);
+                times.push_back(elapsedMs(start));
+
+                const std::vector<FaceMatch> &expected = truth[i];
+                int hits = 0;
+                for (const FaceMatch &t : expected) {
+                    for (const FaceMatch &f : found) {
+                        if (f.index == t.index) {
+                            ++hits;
+                            break;
+                        }
+                    }
+                }
+                if (!expected.empty()) {
+                    recallSum += static_cast<double>(hits) / expected.size();
+                }
+                if (!expected.empty() && !found.empty() && expected[0].index == found[0].index) {
+                    ++top1Agree;
+                    maxError = std::max(maxError, static_cast<double>(std::abs(expected[0].score - found[0].score)));
+                }
+                // 签到关心的是结论：识别为谁、是否超过阈值
+                if (decision(expected, threshold) != decision(found, threshold)) {
+                    ++changed;
+                }
+            }
+
+            int n = std::max(1, queries.rows);
+            double avg = mean(times);
+            stream << quantized.name()
+                   << "  memory=" << megabytes(quantized.memoryBytes()) << "MB"
+                   << " (x" << static_cast<double>(exact.memoryBytes()) / std::max<qint64>(1, quantized.memoryBytes()) << " smaller)"
+                   << "  avg=" << avg << "ms p99=" << percentile(times, 0.99) << "ms"
+                   << "  speedup=x" << (avg > 0 ? exactMean / avg : 0.0)
+                   << "  recall@" << k << "=" << recallSum / n
+                   << "  top1=" << static_cast<double>(top1Agree) / n
+                   << "  decisions changed=" << changed << "/" << queries.rows
+                   << "  max score error=" << maxError << "\n";
+        }
+    }
+    return report;
+}
+
+GalleryIndex::Type BruteForceIndex::type() const {
+    return BruteForce;
+}
+
+QString BruteForceIndex::name() const {
+    return "BruteForce";
+}
+
+void BruteForceIndex::build(const cv::Mat &features, const std::vector<int> &ids) {
+    this->features = features.clone();
+    this->ids = ids;
+    rowOf.clear();
+    for (int i = 0; i < static_cast<int>(ids.size()); ++i) {
+        rowOf.insert(ids[i], i);
+    }
+}
+
+void BruteForceIndex::add(int id, const cv::Mat &feature) {
+    if (rowOf.contains(id)) {
+        remove(id);
+    }
+    rowOf.insert(id, features.rows);
+    ids.push_back(id);
+    features.push_back(feature.reshape(1, 1)); // 追加一行，矩阵仍然保持连续
+}
+
+bool BruteForceIndex::remove(int id) {
+    auto it = rowOf.find(id);
+    if (it == rowOf.end()) {
+        return false;
+    }
+    int row = it.value();
+    int last = features.rows - 1;
+    rowOf.erase(it);
+
+    // 用最后一行填补被删除的行
+    if (row != last) {
+        features.row(last).copyTo(features.row(row));
+        ids[row] = ids[last];
+        rowOf[ids[row]] = row;
+    }
+    features.pop_back();
+    ids.pop_back();
+    return true;
+}
+
+std::vector<FaceMatch> BruteForceIndex::search(const cv::Mat &probe, int k) const {
+    std::vector<FaceMatch> matches = FaceMatcher::topK(features, probe, k);
+    for (FaceMatch &match : matches) {
+        match.index = ids[match.index]; // 行号转换为id
+    }
+    return matches;
+}
+
+int BruteForceIndex::size() const {
+    return features.rows;
+}
+
+int BruteForceIndex::dimension() const {
+    return features.cols;
+}
+
+qint64 BruteForceIndex::memoryBytes() const {
+    return static_cast<qint64>(features.total() * features.elemSize()) + static_cast<qint64>(ids.size() * sizeof(int));
+}
+
+void BruteForceIndex::write(QDataStream &out) const {
+    writeMat(out, features);
+    out << static_cast<qint32>(ids.size());
+    for (int id : ids) {
+        out << static_cast<qint32>(id);
+    }
+}
+
+bool BruteForceIndex::read(QDataStream &in) {
+    cv::Mat loaded;
+    qint32 count = 0;
+    if (!readMat(in, loaded)) {
+        return false;
+    }
+    in >> count;
+    if (count != loaded.rows) {
+        return false;
+    }
+    std::vector<int> loadedIds(count);
+    for (qint32 i = 0; i < count; ++i) {
+        qint32 id = 0;
+        in >> id;
+        loadedIds[i] = id;
+    }
+    build(loaded, loadedIds);
+    return true;
+}
+
+IvfIndex::IvfIndex(int nprobe)
+    : nprobe(std::max(1, nprobe))
+    , dim(0)
+{
+}
+
+GalleryIndex::Type IvfIndex::type() const {
+    return Ivf;
+}
+
+QString IvfIndex::name() const {
+    return QString("IVF(nlist=%1,nprobe=%2)").arg(listCount()).arg(nprobe);
+}
+
+void IvfIndex::build(const cv::Mat &features, const std::vector<int> &ids) {
+    dim = features.cols;
+    centroids.release();
+    listFeatures.clear();
+    listIds.clear();
+    locations.clear();
+
+    if (features.rows >= kMinTrainSize) {
+        train(features);
+    }
+    int lists = centroids.empty() ? 1 : centroids.rows;
+    for (int l = 0; l < lists; ++l) {
+        listFeatures.push_back(cv::Mat(0, dim, CV_32F)); // 每个聚类单独分配
+    }
+    listIds.assign(lists, std::vector<int>());
+
+    // 一次矩阵乘法求出每个特征与所有聚类中心的相似度，再分配到最近的聚类
+    cv::Mat assignment;
+    if (!centroids.empty()) {
+        cv::gemm(features, centroids, 1.0, cv::noArray(), 0.0, assignment, cv::GEMM_2_T);
+    }
+    for (int i = 0; i < features.rows; ++i) {
+        int list = 0;
+        if (!assignment.empty()) {
+            cv::Point maxLoc;
+            cv::minMaxLoc(assignment.row(i), nullptr, nullptr, nullptr, &maxLoc);
+            list = maxLoc.x;
+        }
+        Location location;
+        location.list = list;
+        location.row = listFeatures[list].rows;
+        locations.insert(ids[i], location);
+        listIds[list].push_back(ids[i]);
+        listFeatures[list].push_back(features.row(i));
+    }
+}
+
+void IvfIndex::train(const cv::Mat &features) {
+    int lists = std::min(kMaxLists, std::max(1, static_cast<int>(std::sqrt(static_cast<double>(features.rows)))));
+
+    // 等间隔采样一部分特征训练，避免在大库上k-means过慢
+    int samples = std::min(features.rows, lists * kTrainPointsPerList);
+    cv::Mat sample(samples, features.cols, CV_32F);
+    double step = static_cast<double>(features.rows) / samples;
+    for (int i = 0; i < samples; ++i) {
+        features.row(static_cast<int>(i * step)).copyTo(sample.row(i));
+    }
+
+    cv::Mat labels;
+    cv::kmeans(sample, lists, labels,
+               cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 10, 1e-4),
+               1, cv::KMEANS_PP_CENTERS, centroids);
+
+    // 特征是单位向量，聚类中心也归一化后用点积比较
+    for (int i = 0; i < centroids.rows; ++i) {
+        cv::Mat row = centroids.row(i);
+        cv::normalize(row, row);
+    }
+}
+
+int IvfIndex::nearestList(const cv::Mat &feature) const {
+    if (centroids.empty()) {
+        return 0;
+    }
+    std::vector<float> scores;
+    FaceMatcher::computeScores(centroids, feature, scores);
+    return static_cast<int>(std::max_element(scores.begin(), scores.end()) - scores.begin());
+}
+
+void IvfIndex::add(int id, const cv::Mat &feature) {
+    if (locations.contains(id)) {
+        remove(id);
+    }
+    cv::Mat row = feature.reshape(1, 1);
+    if (listFeatures.empty()) {
+        dim = row.cols;
+        listFeatures.push_back(cv::Mat(0, dim, CV_32F));
+        listIds.push_back(std::vector<int>());
+    }
+
+    int list = nearestList(row);
+    Location location;
+    location.list = list;
+    location.row = listFeatures[list].rows;
+    locations.insert(id, location);
+    listIds[list].push_back(id);
+    listFeatures[list].push_back(row);
+
+    // 未聚类的索引增长到足够大时训练一次
+    if (centroids.empty() && size() >= kMinTrainSize) {
+        cv::Mat all = listFeatures[0].clone();
+        std::vector<int> allIds = listIds[0];
+        build(all, allIds);
+    }
+}
+
+bool IvfIndex::remove(int id) {
+    auto it = locations.find(id);
+    if (it == locations.end()) {
+        return false;
+    }
+    Location location = it.value();
+    locations.erase(it);
+
+    // 用聚类中最后一行填补被删除的行
+    cv::Mat &list = listFeatures[location.list];
+    std::vector<int> &ids = listIds[location.list];
+    int last = list.rows - 1;
+    if (location.row != last) {
+        list.row(last).copyTo(list.row(location.row));
+        ids[location.row] = ids[last];
+        locations[ids[location.row]].row = location.row;
+    }
+    list.pop_back();
+    ids.pop_back();
+    return true;
+}
+
+std::vector<FaceMatch> IvfIndex::search(const cv::Mat &probe, int k) const {
+    std::vector<FaceMatch> best;
+    if (listFeatures.empty() || probe.cols != dim) {
+        return best;
+    }
+
+    // 先选出与探针最接近的 nprobe 个聚类
+    std::vector<FaceMatch> lists;
+    if (centroids.empty()) {
+        FaceMatch only;
+        only.index = 0;
+        lists.push_back(only);
+    } else {
+        std::vector<float> centroidScores;
+        FaceMatcher::computeScores(centroids, probe, centroidScores);
+        lists = FaceMatcher::selectTopK(centroidScores, nprobe);
+    }
+
+    // 只扫描这些聚类中的特征
+    std::vector<float> scores;
+    for (const FaceMatch &list : lists) {
+        const cv::Mat &features = listFeatures[list.index];
+        if (features.rows == 0) {
+            continue;
+        }
+        FaceMatcher::computeScores(features, probe, scores);
+        std::vector<FaceMatch> local = FaceMatcher::selectTopK(scores, k);
+        for (FaceMatch match : local) {
+            match.index = listIds[list.index][match.index];
+            mergeTopK(best, match, k);
+        }
+    }
+    return best;
+}
+
+int IvfIndex::size() const {
+    return locations.size();
+}
+
+int IvfIndex::dimension() const {
+    return size() > 0 ? dim : 0;
+}
+
+qint64 IvfIndex::memoryBytes() const {
+    qint64 bytes = static_cast<qint64>(centroids.total() * centroids.elemSize());
+    for (size_t l = 0; l < listFeatures.size(); ++l) {
+        bytes += static_cast<qint64>(listFeatures[l].total() * listFeatures[l].elemSize());
+        bytes += static_cast<qint64>(listIds[l].size() * sizeof(int));
+    }
+    return bytes;
+}
+
+void IvfIndex::setProbeCount(int nprobe) {
+    this->nprobe = std::max(1, nprobe);
+}
+
+int IvfIndex::listCount() const {
+    return static_cast<int>(listFeatures.size());
+}
+
+void IvfIndex::write(QDataStream &out) const {
+    out << static_cast<qint32>(dim);
+    writeMat(out, centroids);
+    out << static_cast<qint32>(listFeatures.size());
+    for (size_t l = 0; l < listFeatures.size(); ++l) {
+        writeMat(out, listFeatures[l]);
+        for (int id : listIds[l]) {
+            out << static_cast<qint32>(id);
+        }
+    }
+}
+
+bool IvfIndex::read(QDataStream &in) {
+    qint32 storedDim = 0;
+    qint32 lists = 0;
+    in >> storedDim;
+    if (!readMat(in, centroids)) {
+        return false;
+    }
+    in >> lists;
+    if (in.status() != QDataStream::Ok || lists < 0 || lists > kMaxLists) {
+        return false;
+    }
+
+    dim = storedDim;
+    listFeatures.assign(lists, cv::Mat());
+    listIds.assign(lists, std::vector<int>());
+    locations.clear();
+    for (qint32 l = 0; l < lists; ++l) {
+        if (!readMat(in, listFeatures[l])) {
+            return false;
+        }
+        for (int row = 0; row < listFeatures[l].rows; ++row) {
+            qint32 id = 0;
+            in >> id;
+            listIds[l].push_back(id);
+            Location location;
+            location.list = l;
+            location.row = row;
+            locations.insert(id, location);
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+QuantizedIndex::QuantizedIndex(Type precision, int rerankCount)
+    : precision(precision == Fp16 ? Fp16 : Int8)
+    , rerankCount(std::max(0, rerankCount))
+    , dim(0)
+{
+}
+
+GalleryIndex::Type QuantizedIndex::type() const {
+    return precision;
+}
+
+QString QuantizedIndex::name() const {
+    return QString("%1(rerank=%2)").arg(precision == Int8 ? "Int8" : "Fp16").arg(source ? rerankCount : 0);
+}
+
+float QuantizedIndex::quantize(const cv::Mat &feature, cv::Mat &code) {
+    // 对称量化：每个向量按自己的最大绝对值缩放到[-127, 127]
+    double maxAbs = cv::norm(feature, cv::NORM_INF);
+    float scale = maxAbs > 0 ? static_cast<float>(maxAbs / 127.0) : 1.0f;
+    feature.convertTo(code, CV_8S, 1.0 / scale); // 四舍五入并饱和
+    return scale;
+}
+
+void QuantizedIndex::append(const cv::Mat &feature) {
+    cv::Mat row = feature.reshape(1, 1);
+    cv::Mat code;
+    if (precision == Int8) {
+        scales.push_back(quantize(row, code));
+    } else {
+        cv::convertFp16(row, code);
+    }
+    codes.push_back(code); // 追加一行，矩阵仍然保持连续
+}
+
+void QuantizedIndex::build(const cv::Mat &features, const std::vector<int> &ids) {
+    dim = features.cols;
+    codes = cv::Mat(0, dim, precision == Int8 ? CV_8S : CV_16S);
+    codes.reserve(features.rows);
+    scales.clear();
+    scales.reserve(features.rows);
+    this->ids = ids;
+    rowOf.clear();
+    for (int i = 0; i < features.rows; ++i) {
+        append(features.row(i));
+        rowOf.insert(ids[i], i);
+    }
+}
+
+void QuantizedIndex::add(int id, const cv::Mat &feature) {
+    if (rowOf.contains(id)) {
+        remove(id);
+    }
+    if (codes.rows == 0) {
+        dim = static_cast<int>(feature.total());
+        codes = cv::Mat(0, dim, precision == Int8 ? CV_8S : CV_16S);
+    }
+    rowOf.insert(id, codes.rows);
+    ids.push_back(id);
+    append(feature);
+}
+
+bool QuantizedIndex::remove(int id) {
+    auto it = rowOf.find(id);
+    if (it == rowOf.end()) {
+        return false;
+    }
+    int row = it.value();
+    int last = codes.rows - 1;
+    rowOf.erase(it);
+
+    // 用最后一行填补被删除的行
+    if (row != last) {
+        codes.row(last).copyTo(codes.row(row));
+        if (precision == Int8) {
+            scales[row] = scales[last];
+        }
+        ids[row] = ids[last];
+        rowOf[ids[row]] = row;
+    }
+    codes.pop_back();
+    if (precision == Int8) {
+        scales.pop_back();
+    }
+    ids.pop_back();
+    return true;
+}
+
+void QuantizedIndex::coarseScores(const cv::Mat &probe, std::vector<float> &scores) const {
+    if (precision == Int8) {
+        cv::Mat probeCode;
+        float probeScale = quantize(probe, probeCode);
+        FaceMatcher::computeScoresInt8(codes, scales.data(), probeCode, probeScale, scores);
+        return;
+    }
+
+    // fp16逐块解码为float后复用浮点点积，解码缓冲区只有几十KB
+    scores.resize(codes.rows);
+    cv::Mat block;
+    std::vector<float> blockScores;
+    for (int begin = 0; begin < codes.rows; begin += kFp16Block) {
+        int end = std::min(codes.rows, begin + kFp16Block);
+        cv::convertFp16(codes.rowRange(begin, end), block);
+        FaceMatcher::computeScores(block, probe, blockScores);
+        std::copy(blockScores.begin(), blockScores.end(), scores.begin() + begin);
+    }
+}
+
+std::vector<FaceMatch> QuantizedIndex::search(const cv::Mat &probe, int k) const {
+    std::vector<FaceMatch> best;
+    if (codes.rows == 0 || probe.cols != dim) {
+        return best;
+    }
+
+    std::vector<float> scores;
+    coarseScores(probe, scores);
+
+    // 近似得分只用来缩小范围：多取一些候选，量化误差不会把真正的第一名挤出去
+    bool rerank = source && rerankCount > 0;
+    best = FaceMatcher::selectTopK(scores, rerank ? std::max(k, rerankCount) : k);
+    for (FaceMatch &match : best) {
+        match.index = ids[match.index]; // 行号转换为id
+        if (rerank) {
+            cv::Mat full = source(match.index);
+            if (!full.empty() && full.type() == CV_32F && static_cast<int>(full.total()) == dim) {
+                match.score = FaceMatcher::dot(full.ptr<float>(), probe.ptr<float>(), dim);
+            }
+        }
+    }
+    if (rerank) {
+        std::sort(best.begin(), best.end(), [](const FaceMatch &a, const FaceMatch &b) { return a.score > b.score; });
+        if (static_cast<int>(best.size()) > k) {
+            best.resize(k);
+        }
+    }
+    return best;
+}
+
+int QuantizedIndex::size() const {
+    return codes.rows;
+}
+
+int QuantizedIndex::dimension() const {
+    return codes.rows > 0 ? dim : 0;
+}
+
+qint64 QuantizedIndex::memoryBytes() const {
+    return static_cast<qint64>(codes.total() * codes.elemSize())
+            + static_cast<qint64>(scales.size() * sizeof(float))
+            + static_cast<qint64>(ids.size() * sizeof(int));
+}
+
+void QuantizedIndex::setFeatureSource(const FeatureSource &source) {
+    this->source = source;
+}
+
+void QuantizedIndex::setRerankCount(int count) {
+    rerankCount = std::max(0, count);
+}
+
+void QuantizedIndex::write(QDataStream &out) const {
+    out << static_cast<qint32>(dim) << static_cast<qint32>(codes.rows);
+    if (codes.rows > 0) {
+        out.writeRawData(reinterpret_cast<const char *>(codes.data), static_cast<int>(codes.total() * codes.elemSize()));
+    }
+    if (!scales.empty()) {
+        out.writeRawData(reinterpret_cast<const char *>(scales.data()), static_cast<int>(scales.size() * sizeof(float)));
+    }
+    for (int id : ids) {
+        out << static_cast<qint32>(id);
+    }
+}
+
+bool QuantizedIndex::read(QDataStream &in) {
+    qint32 storedDim = 0;
+    qint32 rows = 0;
+    in >> storedDim >> rows;
+    if (in.status() != QDataStream::Ok || storedDim < 0 || rows < 0) {
+        return false;
+    }
+
+    dim = storedDim;
+    codes.create(rows, dim, precision == Int8 ? CV_8S : CV_16S);
+    int bytes = static_cast<int>(codes.total() * codes.elemSize());
+    if (bytes > 0 && in.readRawData(reinterpret_cast<char *>(codes.data), bytes) != bytes) {
+        return false;
+    }
+    scales.assign(precision == Int8 ? rows : 0, 0.0f);
+    bytes = static_cast<int>(scales.size() * sizeof(float));
+    if (bytes > 0 && in.readRawData(reinterpret_cast<char *>(scales.data()), bytes) != bytes) {
+        return false;
+    }
+    ids.assign(rows, 0);
+    rowOf.clear();
+    for (qint32 row = 0; row < rows; ++row) {
+        qint32 id = 0;
+        in >> id;
+        ids[row] = id;
+        rowOf.insert(id, row);
+    }
+    return in.status() == QDataStream::Ok;
+}
@@ -0,0 +1,160 @@
+#ifndef GALLERYINDEX_H
+#define GALLERYINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <QDataStream>
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <vector>
+#include "facematcher.h"
+
+// 人脸库索引接口：保存特征并按余弦相似度搜索
+// id 由人脸库分配(员工槽位号)，支持增量插入和删除，可以持久化到磁盘
+class GalleryIndex
+{
+public:
+    enum Type {
+        BruteForce,//精确搜索，逐行比较
+        Ivf,//倒排文件近似搜索，只比较最近的几个聚类
+        Int8,//int8量化模板(每个向量一个缩放系数)，近似扫描后全精度重排
+        Fp16//半精度模板，近似扫描后全精度重排
+    };
+
+    virtual ~GalleryIndex();
+
+    static GalleryIndex *create(Type type);//创建指定类型的索引
+
+    virtual Type type() const = 0;//索引类型
+    virtual QString name() const = 0;//索引名称
+    virtual void build(const cv::Mat &features, const std::vector<int> &ids) = 0;//用全部特征重建索引 features为NxD CV_32F
+    virtual void add(int id, const cv::Mat &feature) = 0;//插入一个特征
+    virtual bool remove(int id) = 0;//删除一个特征 返回是否存在
+    virtual std::vector<FaceMatch> search(const cv::Mat &probe, int k) const = 0;//搜索最相似的k个 FaceMatch::index为id
+    virtual int size() const = 0;//特征个数
+    virtual int dimension() const = 0;//特征维数 为空时为0
+    virtual qint64 memoryBytes() const = 0;//常驻内存的特征数据字节数
+
+    bool save(const QString &path, quint64 signature) const;//保存到文件 signature用于校验是否与人脸库一致
+    bool load(const QString &path, quint64 signature);//从文件加载 类型、签名不一致或文件损坏时返回false
+
+    static QString compare(GalleryIndex &exact, GalleryIndex &approximate, const cv::Mat &queries, int k);//比较两个索引的召回率和延迟 返回文本报告
+    static QString syntheticReport(int gallerySize, int dimension, int queryCount, int k);//用随机特征生成精确搜索与IVF的对比报告
+    static QString quantizationReport(int gallerySize, int dimension, int queryCount, int k, float threshold);//用随机特征比较量化模板与全精度模板的内存、延迟和匹配结论
+
+protected:
+    virtual void write(QDataStream &out) const = 0;//写入索引数据
+    virtual bool read(QDataStream &in) = 0;//读取索引数据
+
+    static void writeMat(QDataStream &out, const cv::Mat &mat);//写入CV_32F矩阵
+    static bool readMat(QDataStream &in, cv::Mat &mat);//读取CV_32F矩阵
+};
+
+// 精确搜索索引：所有特征连续存放在一个行优先矩阵中，删除时用最后一行填补空位
+class BruteForceIndex : public GalleryIndex
+{
+public:
+    Type type() const override;
+    QString name() const override;
+    void build(const cv::Mat &features, const std::vector<int> &ids) override;
+    void add(int id, const cv::Mat &feature) override;
+    bool remove(int id) override;
+    std::vector<FaceMatch> search(const cv::Mat &probe, int k) const override;
+    int size() const override;
+    int dimension() const override;
+    qint64 memoryBytes() const override;
+
+protected:
+    void write(QDataStream &out) const override;
+    bool read(QDataStream &in) override;
+
+private:
+    cv::Mat features;//特征矩阵 N x D
+    std::vector<int> ids;//每一行对应的id
+    QHash<int, int> rowOf;//id -> 行号
+};
+
+// 倒排文件(IVF)近似搜索索引：用k-means把特征分成若干聚类，搜索时只扫描与探针最接近的nprobe个聚类
+class IvfIndex : public GalleryIndex
+{
+public:
+    explicit IvfIndex(int nprobe = 8);
+
+    Type type() const override;
+    QString name() const override;
+    void build(const cv::Mat &features, const std::vector<int> &ids) override;
+    void add(int id, const cv::Mat &feature) override;
+    bool remove(int id) override;
+    std::vector<FaceMatch> search(const cv::Mat &probe, int k) const override;
+    int size() const override;
+    int dimension() const override;
+    qint64 memoryBytes() const override;
+
+    void setProbeCount(int nprobe);//设置搜索的聚类个数，越大召回率越高、越慢
+    int listCount() const;//聚类个数
+
+protected:
+    void write(QDataStream &out) const override;
+    bool read(QDataStream &in) override;
+
+private:
+    struct Location
+    {
+        int list;//所在聚类
+        int row;//在聚类中的行号
+    };
+
+    void train(const cv::Mat &features);//用k-means训练聚类中心
+    int nearestList(const cv::Mat &feature) const;//特征所属的聚类
+
+    int nprobe;//搜索的聚类个数
+    int dim;//特征维数
+    cv::Mat centroids;//聚类中心 nlist x D，已L2归一化
+    std::vector<cv::Mat> listFeatures;//每个聚类的特征矩阵
+    std::vector<std::vector<int>> listIds;//每个聚类中每一行对应的id
+    QHash<int, Location> locations;//id -> 位置
+};
+
+// 量化模板索引：内存中只保存压缩后的模板(int8为全精度的1/4，fp16为1/2)，逐行扫描求近似相似度
+// 近似得分最高的若干候选再用全精度特征重新打分，最终得分和排序与精确搜索一致
+// 全精度特征由调用方按id提供(人脸库从内存映射的模板文件中读取，只访问少数几行)，取不到时保留近似得分
+class QuantizedIndex : public GalleryIndex
+{
+public:
+    typedef std::function<cv::Mat(int id)> FeatureSource;//按id取全精度特征(1xD CV_32F) 取不到时返回空矩阵 在search中调用
+
+    explicit QuantizedIndex(Type precision = Int8, int rerankCount = 16);
+
+    Type type() const override;
+    QString name() const override;
+    void build(const cv::Mat &features, const std::vector<int> &ids) override;
+    void add(int id, const cv::Mat &feature) override;
+    bool remove(int id) override;
+    std::vector<FaceMatch> search(const cv::Mat &probe, int k) const override;
+    int size() const override;
+    int dimension() const override;
+    qint64 memoryBytes() const override;
+
+    void setFeatureSource(const FeatureSource &source);//设置重排使用的全精度特征来源
+    void setRerankCount(int count);//重排的候选个数 为0时只用近似得分
+
+protected:
+    void write(QDataStream &out) const override;
+    bool read(QDataStream &in) override;
+
+private:
+    void append(const cv::Mat &feature);//量化一个特征并追加一行
+    void coarseScores(const cv::Mat &probe, std::vector<float> &scores) const;//所有行的近似相似度
+    static float quantize(const cv::Mat &feature, cv::Mat &code);//int8量化 返回缩放系数
+
+    Type precision;//Int8 或 Fp16
+    int rerankCount;//重排的候选个数
+    int dim;//特征维数
+    cv::Mat codes;//量化模板 N x D int8为CV_8S，fp16为CV_16S(半精度位模式)
+    std::vector<float> scales;//int8每一行的缩放系数 fp16时为空
+    std::vector<int> ids;//每一行对应的id
+    QHash<int, int> rowOf;//id -> 行号
+    FeatureSource source;//全精度特征来源
+};
+
+#endif // GALLERYINDEX_H
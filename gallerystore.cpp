@@ -0,0 +1,177 @@
+#include "gallerystore.h"
+#include <QSaveFile>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+const quint32 kStoreMagic = 0x4c414746; // "FGAL"
+const quint32 kStoreVersion = 1;
+const int kHeaderSize = 64; // 文件头长度，模板区从这里开始
+const int kRecordAlignment = 64; // 模板记录按缓存行对齐
+
+// 文件头，按小端序直接写入
+struct Header
+{
+    quint32 magic;//文件标识
+    quint32 version;//格式版本
+    quint32 featureKind;//特征类型(DNN/直方图) 与特征维数一起决定模板能否复用
+    quint32 dimension;//特征维数
+    quint32 count;//模板个数
+    quint32 stride;//模板记录长度(字节)
+    quint64 tableOffset;//员工表在文件中的偏移
+    quint8 reserved[32];//保留
+};
+static_assert(sizeof(Header) == kHeaderSize, "gallery store header must be 64 bytes");
+static_assert(sizeof(GalleryStore::Entry) == 16, "gallery store entry must be 16 bytes");
+}
+
+GalleryStore::GalleryStore()
+    : data(nullptr)
+    , count(0)
+    , dim(0)
+    , recordStride(0)
+    , table(nullptr)
+{
+}
+
+GalleryStore::~GalleryStore() {
+    unmap();
+}
+
+int GalleryStore::stride(int dimension) {
+    int bytes = dimension * static_cast<int>(sizeof(float));
+    return (bytes + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+bool GalleryStore::map(const QString &path, int dimension, quint32 featureKind) {
+    unmap();
+    file.setFileName(path);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 fileSize = file.size();
+    if (fileSize < kHeaderSize) {
+        unmap();
+        return false;
+    }
+    data = file.map(0, fileSize);
+    if (!data) {
+        qDebug() << "Error mapping gallery templates:" << path;
+        unmap();
+        return false;
+    }
+
+    // 校验文件头和各区域的边界，任何不一致都当作没有模板文件
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    qint64 templateBytes = static_cast<qint64>(header.count) * header.stride;
+    bool valid = header.magic == kStoreMagic
+            && header.version == kStoreVersion
+            && header.featureKind == featureKind
+            && static_cast<int>(header.dimension) == dimension
+            && static_cast<int>(header.stride) == stride(dimension)
+            && header.tableOffset >= static_cast<quint64>(kHeaderSize + templateBytes)
+            && header.tableOffset + static_cast<quint64>(header.count) * sizeof(Entry) <= static_cast<quint64>(fileSize);
+    if (!valid) {
+        unmap();
+        return false;
+    }
+
+    count = static_cast<int>(header.count);
+    dim = dimension;
+    recordStride = static_cast<int>(header.stride);
+    table = reinterpret_cast<const Entry *>(data + header.tableOffset);
+    recordOf.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        recordOf.insert(table[i].rowId, i);
+    }
+    return true;
+}
+
+void GalleryStore::unmap() {
+    if (data) {
+        file.unmap(data);
+        data = nullptr;
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    count = 0;
+    dim = 0;
+    recordStride = 0;
+    table = nullptr;
+    recordOf.clear();
+}
+
+bool GalleryStore::isMapped() const {
+    return data != nullptr;
+}
+
+int GalleryStore::size() const {
+    return count;
+}
+
+int GalleryStore::dimension() const {
+    return dim;
+}
+
+int GalleryStore::find(int rowId, quint64 key) const {
+    auto it = recordOf.find(rowId);
+    if (it == recordOf.end() || table[it.value()].key != key) {
+        return -1;
+    }
+    return it.value();
+}
+
+cv::Mat GalleryStore::feature(int record) const {
+    return cv::Mat(1, dim, CV_32F, data + kHeaderSize + static_cast<size_t>(record) * recordStride);
+}
+
+cv::Mat GalleryStore::features() const {
+    if (count == 0) {
+        return cv::Mat();
+    }
+    return cv::Mat(count, dim, CV_32F, data + kHeaderSize, static_cast<size_t>(recordStride));
+}
+
+const GalleryStore::Entry &GalleryStore::entry(int record) const {
+    return table[record];
+}
+
+bool GalleryStore::write(const QString &path, quint32 featureKind, const cv::Mat &features, const std::vector<Entry> &entries) {
+    if (features.rows != static_cast<int>(entries.size()) || (!features.empty() && features.type() != CV_32F)) {
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kStoreMagic;
+    header.version = kStoreVersion;
+    header.featureKind = featureKind;
+    header.dimension = static_cast<quint32>(features.cols);
+    header.count = static_cast<quint32>(features.rows);
+    header.stride = static_cast<quint32>(stride(features.cols));
+    header.tableOffset = kHeaderSize + static_cast<quint64>(header.count) * header.stride;
+
+    // 先写临时文件再替换，避免中途退出留下损坏的模板文件
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error saving gallery templates:" << path;
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    QByteArray record(static_cast<int>(header.stride), '\0');
+    int rowBytes = features.cols * static_cast<int>(sizeof(float));
+    for (int i = 0; i < features.rows; ++i) {
+        std::memcpy(record.data(), features.ptr<float>(i), rowBytes);
+        out.write(record);
+    }
+    if (!entries.empty()) {
+        out.write(reinterpret_cast<const char *>(entries.data()), static_cast<qint64>(entries.size() * sizeof(Entry)));
+    }
+    if (!out.commit()) {
+        qDebug() << "Error saving gallery templates:" << out.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef GALLERYSTORE_H
+#define GALLERYSTORE_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 人脸模板文件：启动时内存映射，不解码人脸图像、不提取特征
+// 布局：64字节文件头 | N条定长模板记录(D个float，按64字节对齐) | N条员工表记录(主键 + 校验值)
+// 校验值由员工主键、编号和人脸图像路径计算，与数据库不一致的记录视为过期
+// 文件只整体重写(先写临时文件再替换)，重写前必须先解除映射
+class GalleryStore
+{
+public:
+    // 员工表中的一条记录
+    struct Entry
+    {
+        qint32 rowId;//employees 表主键
+        qint32 reserved;//保留 对齐到8字节
+        quint64 key;//员工信息校验值
+    };
+
+    GalleryStore();
+    ~GalleryStore();
+
+    bool map(const QString &path, int dimension, quint32 featureKind);//映射文件 不存在、损坏或特征类型不符时返回false
+    void unmap();//解除映射并关闭文件
+    bool isMapped() const;//是否已映射
+
+    int size() const;//模板个数
+    int dimension() const;//特征维数
+    int find(int rowId, quint64 key) const;//按主键查找校验值一致的模板 返回记录下标 不存在或过期时返回-1
+    cv::Mat feature(int record) const;//第record个模板 1xD 直接指向映射内存 解除映射后失效
+    cv::Mat features() const;//全部模板 NxD 直接指向映射内存(行间距为记录长度)
+    const Entry &entry(int record) const;//第record条员工表记录
+
+    static bool write(const QString &path, quint32 featureKind, const cv::Mat &features, const std::vector<Entry> &entries);//写入文件 features为NxD CV_32F 与entries一一对应
+    static int stride(int dimension);//一条模板记录的字节数
+
+private:
+    QFile file;//映射的文件
+    uchar *data;//映射的内存 未映射时为nullptr
+    int count;//模板个数
+    int dim;//特征维数
+    int recordStride;//模板记录长度(字节)
+    const Entry *table;//员工表
+    QHash<int, int> recordOf;//主键 -> 记录下标
+};
+
+#endif // GALLERYSTORE_H
@@ -0,0 +1,477 @@
+#include "httpserver.h"
+#include "attendancestore.h"
+#include "frameanalyzer.h"
+#include "metrics.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QUrl>
+#include <QDebug>
+#include <memory>
+
+namespace {
+const char *kConnectionName = "http_server"; // 服务线程专用的数据库连接名
+const int kMaxHeaderBytes = 16 * 1024; // 请求行和请求头的大小上限
+const int kDefaultPageSize = 100; // 考勤查询默认每页行数
+const int kMaxPageSize = 1000; // 考勤查询每页行数上限
+const int kIdleCheckMs = 5000; // 检查空闲连接的间隔
+const int kJobWaitMs = 200; // 识别线程等待请求的超时，用于及时响应停止
+
+QByteArray statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    }
+    return "Unknown";
+}
+
+QByteArray toJson(const QJsonObject &object) {
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+}
+
+HttpServer::HttpServer(const HttpServerConfig &config, const FaceGallery *gallery, AttendanceWriter *writer, QObject *parent)
+    : QThread(parent)
+    , config(config)
+    , gallery(gallery)
+    , attendanceWriter(writer)
+    , server(nullptr)
+    , nextConnectionId(1)
+    , recognitionJobs(qMax(1, config.maxPendingRecognitions))
+    , pendingRecognitions(0)
+{
+}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+void HttpServer::stop() {
+    // run() 尚未进入事件循环时 quit() 不起作用，用中断标志让它在进入前或空闲检查时退出
+    requestInterruption();
+    quit();
+    wait();
+}
+
+void HttpServer::run() {
+    if (isInterruptionRequested()) {
+        return;
+    }
+    {
+        // 查询使用服务线程自己的连接，WAL 模式下与考勤写入线程互不阻塞
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", kConnectionName);
+        db.setDatabaseName(config.databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (!db.open()) {
+            qDebug() << "Error opening database for HTTP server:" << db.lastError().text();
+        }
+
+        QTcpServer tcpServer;
+        server = &tcpServer;
+        if (!tcpServer.listen(config.address, config.port)) {
+            qDebug() << "Error starting HTTP server:" << tcpServer.errorString();
+            emit listenFailed(tcpServer.errorString());
+        } else {
+            connect(&tcpServer, &QTcpServer::newConnection, &tcpServer, [this]() { accept(); });
+            QTimer idleTimer;
+            connect(&idleTimer, &QTimer::timeout, &tcpServer, [this]() {
+                if (isInterruptionRequested()) {
+                    quit(); // stop() 在检查之后、进入事件循环之前调用时，由这里退出
+                    return;
+                }
+                closeIdle();
+            });
+            idleTimer.start(kIdleCheckMs);
+
+            recognitionJobs.reopen();
+            for (int i = 0; i < qMax(1, config.recognitionThreads); ++i) {
+                QThread *thread = QThread::create([this]() { recognitionLoop(); });
+                thread->start();
+                recognizers.append(thread);
+            }
+
+            emit listening(tcpServer.serverPort());
+            if (!isInterruptionRequested()) {
+                exec();
+            }
+
+            // 先停止识别线程，它们把结果投递给监听套接字
+            recognitionJobs.close();
+            for (QThread *thread : recognizers) {
+                thread->wait();
+                delete thread;
+            }
+            recognizers.clear();
+            tcpServer.close();
+        }
+
+        for (Connection *connection : connections) {
+            connection->socket->abort();
+            delete connection->socket;
+            delete connection;
+        }
+        connections.clear();
+        server = nullptr;
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(kConnectionName);
+}
+
+void HttpServer::accept() {
+    while (server->hasPendingConnections()) {
+        QTcpSocket *socket = server->nextPendingConnection();
+        if (connections.size() >= config.maxConnections) {
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        Connection *connection = new Connection;
+        connection->id = nextConnectionId++;
+        connection->socket = socket;
+        connection->busy = false;
+        connection->keepAlive = true;
+        connection->closed = false;
+        connection->lastActivity = QDateTime::currentMSecsSinceEpoch();
+        connection->requestTimer.start();
+        connections.insert(connection->id, connection);
+
+        connect(socket, &QTcpSocket::readyRead, socket, [this, connection]() {
+            if (connection->closed || !connection->keepAlive) {
+                connection->socket->readAll(); // 连接即将关闭，后续数据不会再处理
+                return;
+            }
+            connection->buffer += connection->socket->readAll();
+            connection->lastActivity = QDateTime::currentMSecsSinceEpoch();
+            // 等待识别结果时客户端仍可能持续发送，缓冲区超过一个最大请求时断开连接
+            if (connection->buffer.size() > kMaxHeaderBytes + static_cast<qint64>(config.maxBodyBytes)) {
+                connection->buffer.clear();
+                connection->socket->abort();
+                dropConnection(connection);
+                return;
+            }
+            process(connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, [this, connection]() { dropConnection(connection); });
+    }
+}
+
+void HttpServer::process(Connection *connection) {
+    // 流水线请求按顺序处理；等待识别结果时不处理后续请求
+    while (!connection->busy && !connection->closed && connection->keepAlive) {
+        int headerEnd = connection->buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            if (connection->buffer.size() > kMaxHeaderBytes) {
+                connection->keepAlive = false;
+                respondError(connection, 431, "request header too large");
+            }
+            return;
+        }
+
+        QList<QByteArray> lines = connection->buffer.left(headerEnd).split('\n');
+        QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() != 3 || !requestLine[2].startsWith("HTTP/1.")) {
+            connection->keepAlive = false;
+            respondError(connection, 400, "malformed request line");
+            return;
+        }
+
+        // HTTP/1.1 默认保持连接，HTTP/1.0 默认关闭
+        Request request;
+        request.method = requestLine[0];
+        bool keepAlive = requestLine[2] == "HTTP/1.1";
+        qint64 contentLength = 0;
+        bool chunked = false;
+        for (int i = 1; i < lines.size(); ++i) {
+            int colon = lines[i].indexOf(':');
+            if (colon <= 0) {
+                continue;
+            }
+            QByteArray name = lines[i].left(colon).trimmed().toLower();
+            QByteArray value = lines[i].mid(colon + 1).trimmed();
+            if (name == "content-length") {
+                contentLength = value.toLongLong();
+            } else if (name == "connection") {
+                keepAlive = value.toLower() == "keep-alive" || (keepAlive && value.toLower() != "close");
+            } else if (name == "transfer-encoding") {
+                chunked = value.toLower() != "identity";
+            }
+        }
+        connection->keepAlive = keepAlive;
+        if (chunked) {
+            connection->keepAlive = false;
+            respondError(connection, 411, "chunked request bodies are not supported, send Content-Length");
+            return;
+        }
+        if (contentLength < 0 || contentLength > config.maxBodyBytes) {
+            connection->keepAlive = false;
+            respondError(connection, 413, "request body too large");
+            return;
+        }
+
+        // 请求体还没收完时等下一次 readyRead
+        int bodyStart = headerEnd + 4;
+        if (connection->buffer.size() - bodyStart < contentLength) {
+            return;
+        }
+        request.body = connection->buffer.mid(bodyStart, static_cast<int>(contentLength));
+        QUrl url(QString::fromLatin1(requestLine[1]));
+        request.path = url.path();
+        request.query = QUrlQuery(url);
+        connection->buffer.remove(0, bodyStart + static_cast<int>(contentLength));
+
+        connection->requestTimer.start();
+        Metrics::instance().add(Metrics::HttpRequests);
+        handle(connection, request);
+    }
+}
+
+void HttpServer::handle(Connection *connection, const Request &request) {
+    if (request.path == "/api/recognize") {
+        if (request.method != "POST") {
+            respondError(connection, 405, "use POST");
+            return;
+        }
+        handleRecognize(connection, request);
+        return;
+    }
+
+    // 其余接口都是只读查询
+    if (request.method != "GET") {
+        respondError(connection, 405, "use GET");
+    } else if (request.path == "/api/attendance") {
+        handleAttendance(connection, request);
+    } else if (request.path.startsWith("/api/employees/")) {
+        handleEmployee(connection, request.path.mid(15));
+    } else if (request.path == "/api/stats") {
+        handleStats(connection);
+    } else if (request.path == "/metrics") {
+        respond(connection, 200, Metrics::instance().toPrometheus().toUtf8(), "text/plain; version=0.0.4");
+    } else {
+        respondError(connection, 404, "not found");
+    }
+}
+
+void HttpServer::handleAttendance(Connection *connection, const Request &request) {
+    // 与考勤记录页面相同的筛选条件和按主键倒序的 keyset 分页，每页代价与历史记录总量无关
+    AttendanceFilter filter;
+    QDate from = QDate::fromString(request.query.queryItemValue("from"), "yyyy-MM-dd");
+    QDate to = QDate::fromString(request.query.queryItemValue("to"), "yyyy-MM-dd");
+    if (from.isValid()) {
+        filter.from = QDateTime(from, QTime(0, 0, 0));
+    }
+    if (to.isValid()) {
+        filter.to = QDateTime(to, QTime(23, 59, 59));
+    }
+    filter.department = request.query.queryItemValue("department", QUrl::FullyDecoded);
+    filter.employeeId = request.query.queryItemValue("employee", QUrl::FullyDecoded);
+    qint64 before = request.query.queryItemValue("before").toLongLong();
+    int limit = request.query.queryItemValue("limit").toInt();
+    limit = limit > 0 ? qMin(limit, kMaxPageSize) : kDefaultPageSize;
+
+    AttendanceStore store(QSqlDatabase::database(kConnectionName, false));
+    QVector<AttendanceRecord> page;
+    if (!store.page(filter, before, limit, page)) {
+        respondError(connection, 500, store.errorString());
+        return;
+    }
+
+    QJsonArray records;
+    qint64 lastId = 0;
+    for (const AttendanceRecord &row : page) {
+        QJsonObject record;
+        lastId = row.id;
+        record["id"] = lastId;
+        record["employee_id"] = row.employeeId;
+        record["name"] = row.name;
+        record["department"] = row.department;
+        record["timestamp"] = row.timestamp();
+        records.append(record);
+    }
+
+    QJsonObject root;
+    root["records"] = records;
+    root["next"] = records.size() == limit ? QJsonValue(lastId) : QJsonValue();
+    respond(connection, 200, toJson(root));
+}
+
+void HttpServer::handleEmployee(Connection *connection, const QString &employeeId) {
+    QSqlQuery query(QSqlDatabase::database(kConnectionName, false));
+    query.prepare("SELECT employee_id, name, department FROM employees WHERE employee_id = ?");
+    query.addBindValue(employeeId); // 路径已解码
+    if (!query.exec()) {
+        respondError(connection, 500, query.lastError().text());
+        return;
+    }
+    if (!query.next()) {
+        respondError(connection, 404, "employee not found");
+        return;
+    }
+
+    QJsonObject employee;
+    employee["employee_id"] = query.value(0).toString();
+    employee["name"] = query.value(1).toString();
+    employee["department"] = query.value(2).toString();
+    employee["enrolled"] = gallery->contains(query.value(0).toString());
+    respond(connection, 200, toJson(employee));
+}
+
+void HttpServer::handleStats(Connection *connection) {
+    // 与导出的指标文件内容相同，另外附上人脸库和接口自身的状态
+    QJsonObject root = QJsonDocument::fromJson(Metrics::instance().toJson().toUtf8()).object();
+    QJsonObject galleryObject;
+    galleryObject["size"] = gallery->size();
+    galleryObject["index"] = gallery->indexName();
+    root["gallery"] = galleryObject;
+    QJsonObject httpObject;
+    httpObject["connections"] = connections.size();
+    httpObject["pending_recognitions"] = pendingRecognitions.load();
+    root["http"] = httpObject;
+    respond(connection, 200, toJson(root));
+}
+
+void HttpServer::handleRecognize(Connection *connection, const Request &request) {
+    if (request.body.isEmpty()) {
+        respondError(connection, 400, "request body must be an image");
+        return;
+    }
+    // 排队的识别请求有上限，超出时立即拒绝，不让请求在队列中无限等待
+    if (pendingRecognitions.load() >= config.maxPendingRecognitions) {
+        Metrics::instance().add(Metrics::HttpRejected);
+        respondError(connection, 503, "too many pending recognitions");
+        return;
+    }
+
+    RecognitionJob job;
+    job.connectionId = connection->id;
+    job.image = request.body;
+    job.checkin = request.query.queryItemValue("checkin") == "1";
+    ++pendingRecognitions;
+    connection->busy = true;
+    recognitionJobs.push(job);
+}
+
+void HttpServer::finishRecognition(quint64 connectionId, const QByteArray &body, int status) {
+    Connection *connection = connections.value(connectionId);
+    if (!connection || connection->closed) {
+        return; // 客户端已断开
+    }
+    connection->busy = false;
+    respond(connection, status, body);
+    process(connection); // 继续处理等待期间收到的请求
+}
+
+void HttpServer::recognitionLoop() {
+    // 每个识别线程自己的检测器、质量评估和特征提取器，人脸库共享
+    std::unique_ptr<FrameAnalyzer> analyzer(new FrameAnalyzer(gallery));
+    analyzer->setDetectorConfig(config.detectorConfig);
+    analyzer->loadEmbedder(config.embeddingModelPath, config.detectorConfig.dnnBackend, config.detectorConfig.dnnTarget);
+    analyzer->setQualityConfig(config.qualityConfig);
+
+    RecognitionJob job;
+    while (!recognitionJobs.isClosed()) {
+        if (!recognitionJobs.pop(job, kJobWaitMs)) {
+            continue;
+        }
+
+        int status = 200;
+        QJsonObject root;
+        std::vector<uchar> data(job.image.constBegin(), job.image.constEnd());
+        cv::Mat frame = cv::imdecode(data, cv::IMREAD_COLOR);
+        if (frame.empty()) {
+            status = 400;
+            root["error"] = "cannot decode image";
+        } else {
+            QJsonArray faces;
+            for (const RecognitionEvent &event : analyzer->recognizeImage(frame)) {
+                QJsonObject face;
+                face["x"] = event.face.x;
+                face["y"] = event.face.y;
+                face["width"] = event.face.width;
+                face["height"] = event.face.height;
+                face["recognized"] = event.recognized;
+                face["score"] = event.score;
+                if (event.quality != FaceQuality::Ok) {
+                    FaceQuality quality;
+                    quality.reason = event.quality;
+                    face["quality"] = quality.reasonText();
+                }
+                if (event.recognized) {
+                    face["employee_id"] = event.employee.employeeId;
+                    face["name"] = event.employee.name;
+                    face["department"] = event.employee.department;
+                    // 与摄像头签到走同一个写入线程，重复签到同样按员工去重
+                    if (job.checkin && attendanceWriter) {
+                        face["checked_in"] = attendanceWriter->submit(event.employee);
+                    }
+                }
+                faces.append(face);
+            }
+            root["faces"] = faces;
+        }
+
+        // 结果交回服务线程写出；服务器已停止时投递的调用随监听套接字一起丢弃
+        QByteArray body = toJson(root);
+        quint64 connectionId = job.connectionId;
+        --pendingRecognitions;
+        QMetaObject::invokeMethod(server, [this, connectionId, body, status]() { finishRecognition(connectionId, body, status); },
+                                  Qt::QueuedConnection);
+    }
+}
+
+void HttpServer::respond(Connection *connection, int status, const QByteArray &body, const QByteArray &contentType) {
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += connection->keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    response += body;
+    connection->socket->write(response);
+    connection->lastActivity = QDateTime::currentMSecsSinceEpoch();
+    Metrics::instance().record(Metrics::HttpRequest, connection->requestTimer.nsecsElapsed());
+    if (!connection->keepAlive) {
+        connection->socket->disconnectFromHost(); // 写完缓冲区中的响应后关闭
+    }
+}
+
+void HttpServer::respondError(Connection *connection, int status, const QString &message) {
+    QJsonObject root;
+    root["error"] = message;
+    respond(connection, status, toJson(root));
+}
+
+void HttpServer::dropConnection(Connection *connection) {
+    // 断开可能发生在处理请求的调用栈中，延迟到事件循环再删除
+    if (connection->closed) {
+        return;
+    }
+    connection->closed = true;
+    QTimer::singleShot(0, server, [this, connection]() {
+        connections.remove(connection->id);
+        connection->socket->deleteLater();
+        delete connection;
+    });
+}
+
+void HttpServer::closeIdle() {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (Connection *connection : connections) {
+        if (!connection->busy && !connection->closed && now - connection->lastActivity > config.idleTimeoutMs) {
+            connection->socket->disconnectFromHost();
+        }
+    }
+}
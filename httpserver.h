@@ -0,0 +1,118 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <QThread>
+#include <QHostAddress>
+#include <QHash>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QUrlQuery>
+#include <QVector>
+#include <atomic>
+#include "attendancewriter.h"
+#include "boundedqueue.h"
+#include "facedetector.h"
+#include "facegallery.h"
+#include "facequality.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+// HTTP 接口参数
+struct HttpServerConfig
+{
+    QHostAddress address = QHostAddress::LocalHost;//监听地址 默认只接受本机连接
+    quint16 port = 8080;//监听端口 0表示由系统分配
+    QString databasePath;//数据库文件路径 查询使用服务线程自己的连接
+    DetectorConfig detectorConfig;//远程识别的检测器配置
+    QualityConfig qualityConfig;//远程识别的人脸质量门限
+    QString embeddingModelPath;//人脸特征提取模型路径
+    int recognitionThreads = 1;//远程识别线程数
+    int maxPendingRecognitions = 16;//排队中的识别请求上限 超出时返回503
+    int maxConnections = 1024;//同时保持的连接数上限
+    int idleTimeoutMs = 30000;//空闲连接的超时时间
+    int maxBodyBytes = 8 * 1024 * 1024;//请求体大小上限
+};
+
+// 内嵌的 HTTP/1.1 接口：其他系统通过它查询考勤和员工、读取运行指标、提交图片识别，不再直接打开数据库文件
+// 所有连接在一个服务线程中以事件驱动方式处理，支持keep-alive和流水线请求(同一连接按顺序响应)，不经过界面线程
+// 识别请求交给独立的识别线程(每个线程自己的检测器和特征提取器，与视频识别使用同一个人脸库和相同的判定)，服务线程不会被识别阻塞
+//
+// GET  /api/attendance?from=yyyy-MM-dd&to=yyyy-MM-dd&department=&employee=&before=<id>&limit=<n>  按主键倒序分页，响应中的next作为下一页的before
+// GET  /api/employees/<员工编号>  员工信息及是否已在人脸库中
+// GET  /api/stats  运行指标(JSON)  GET /metrics  运行指标(Prometheus文本)
+// POST /api/recognize[?checkin=1]  请求体为JPEG/PNG图片 返回每张人脸的识别结果 checkin=1时为识别出的员工签到
+class HttpServer : public QThread
+{
+    Q_OBJECT
+
+public:
+    HttpServer(const HttpServerConfig &config, const FaceGallery *gallery, AttendanceWriter *writer, QObject *parent = nullptr);
+    ~HttpServer();
+
+    void stop();//关闭所有连接并停止服务线程和识别线程
+
+signals:
+    void listening(quint16 port);//开始监听 port为实际端口
+    void listenFailed(const QString &error);//无法监听
+
+protected:
+    void run() override;
+
+private:
+    // 一个客户端连接 只在服务线程中访问
+    struct Connection
+    {
+        quint64 id;//连接编号
+        QTcpSocket *socket;//套接字
+        QByteArray buffer;//已收到、尚未处理的数据
+        bool busy;//正在等待识别结果 之后的请求暂不处理，保证响应顺序
+        bool keepAlive;//当前请求之后是否保持连接
+        bool closed;//已断开 等待删除
+        qint64 lastActivity;//最后一次收发数据的时间(毫秒)
+        QElapsedTimer requestTimer;//当前请求的计时
+    };
+
+    // 一个解析完的请求
+    struct Request
+    {
+        QByteArray method;//请求方法
+        QString path;//路径
+        QUrlQuery query;//查询参数
+        QByteArray body;//请求体
+    };
+
+    // 一个排队中的识别请求
+    struct RecognitionJob
+    {
+        quint64 connectionId = 0;//发起请求的连接
+        QByteArray image;//图片数据
+        bool checkin = false;//识别出员工时是否签到
+    };
+
+    void accept();//接受新连接
+    void process(Connection *connection);//解析并处理缓冲区中的完整请求
+    void handle(Connection *connection, const Request &request);//按路径分发请求
+    void handleAttendance(Connection *connection, const Request &request);//分页查询考勤记录
+    void handleEmployee(Connection *connection, const QString &employeeId);//查询员工
+    void handleStats(Connection *connection);//运行指标
+    void handleRecognize(Connection *connection, const Request &request);//提交识别请求
+    void finishRecognition(quint64 connectionId, const QByteArray &body, int status);//识别线程完成后在服务线程中写出响应
+    void respond(Connection *connection, int status, const QByteArray &body, const QByteArray &contentType = "application/json");//写出响应
+    void respondError(Connection *connection, int status, const QString &message);//写出JSON格式的错误
+    void dropConnection(Connection *connection);//连接断开后延迟删除
+    void closeIdle();//关闭空闲超时的连接
+    void recognitionLoop();//识别线程：取出识别请求，检测和识别后把结果交回服务线程
+
+    HttpServerConfig config;//接口参数
+    const FaceGallery *gallery;//共享的内存人脸库
+    AttendanceWriter *attendanceWriter;//考勤写入线程 远程签到时使用
+    QTcpServer *server;//监听套接字 只在服务线程中访问
+    QHash<quint64, Connection *> connections;//连接编号 -> 连接 只在服务线程中访问
+    quint64 nextConnectionId;//下一个连接编号
+    BoundedQueue<RecognitionJob> recognitionJobs;//服务线程 -> 识别线程
+    std::atomic<int> pendingRecognitions;//已提交、尚未完成的识别请求数
+    QVector<QThread *> recognizers;//识别线程
+};
+
+#endif // HTTPSERVER_H
@@ -0,0 +1,107 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 无锁有界队列(多生产者多消费者，基于每个槽位的序号)
+// 放入和取出都不会阻塞，也不会等待其他线程；队列满时新元素被丢弃并计数，生产者从不因消费者变慢而停顿
+// 容量向上取整为2的幂
+template <typename T>
+class LockFreeQueue
+{
+public:
+    explicit LockFreeQueue(int capacity = 256)
+        : slots(roundUp(capacity))
+        , mask(slots.size() - 1)
+        , head(0)
+        , tail(0)
+        , dropped(0)
+    {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    // 放入一个元素 队列已满时丢弃该元素并返回false
+    bool push(const T &item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0) {
+                // 槽位空闲，抢占成功后写入
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.item = item;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 取出最旧的元素 队列为空时立即返回false
+    bool pop(T &item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    item = slot.item;
+                    slot.item = T(); // 释放元素持有的资源
+                    slot.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 队列满时丢弃的元素个数
+    long long droppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    // 容量
+    int capacity() const {
+        return static_cast<int>(slots.size());
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;//槽位序号 等于写入位置时可写 等于写入位置+1时可读
+        T item;//元素
+    };
+
+    static size_t roundUp(int capacity) {
+        size_t size = 2;
+        while (size < static_cast<size_t>(capacity)) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    std::vector<Slot> slots;//环形缓冲区
+    const size_t mask;//下标掩码
+    alignas(64) std::atomic<size_t> head;//下一个读取位置 与写入位置分开放在不同缓存行
+    alignas(64) std::atomic<size_t> tail;//下一个写入位置
+    std::atomic<long long> dropped;//丢弃计数
+};
+
+#endif // LOCKFREEQUEUE_H
@@ -1,7 +1,415 @@
 #include <QApplication>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QSqlDatabase>
+#include <QSqlError>
 #include "mainwindow.h"
+#include "attendanceexporter.h"
+#include "attendancestore.h"
+#include "attendancesummary.h"
+#include "bulkenroller.h"
+#include "databaseschema.h"
+#include "galleryindex.h"
+#include "httpserver.h"
+#include "metrics.h"
+#include "replayrunner.h"
+
+namespace {
+const char *kDatabasePath = "D:/code/qt_project/OpenCV_Face/attendance.db"; // 与界面使用同一个数据库
+const char *kEmbeddingModelPath = "D:/code/qt_project/OpenCV_Face/models/nn4.small2.v1.t7"; // 人脸特征提取模型
+const char *kFaceDir = "D:/code/qt_project/OpenCV_Face/faces"; // 录入的人脸图像目录
+const char *kIndexPath = "D:/code/qt_project/OpenCV_Face/gallery.index"; // 人脸库索引
+const char *kTemplatePath = "D:/code/qt_project/OpenCV_Face/gallery.bin"; // 人脸模板文件
+const char *kArchiveDir = "D:/code/qt_project/OpenCV_Face/archive"; // 考勤归档文件目录，与界面相同
+const int kKeepMonths = 12; // 主数据库中保留的考勤月数(含当月)，与界面相同
+}
+
+// 查找 "--name 值" 形式的参数，不存在时返回空字符串
+static QString optionValue(int argc, char *argv[], const char *name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (qstrcmp(argv[i], name) == 0) {
+            return QString::fromLocal8Bit(argv[i + 1]);
+        }
+    }
+    return QString();
+}
+
+// 命令行工具共用的检测器配置：模型路径与界面相同，检测参数可由命令行覆盖
+static DetectorConfig detectorConfig(int argc, char *argv[]) {
+    DetectorConfig config;
+    config.cascadePath = "D:/code/qt_project/OpenCV_Face/haarcascade_frontalface_default.xml";
+    config.ssdConfigPath = "D:/code/qt_project/OpenCV_Face/models/deploy.prototxt";
+    config.ssdModelPath = "D:/code/qt_project/OpenCV_Face/models/res10_300x300_ssd_iter_140000.caffemodel";
+    if (optionValue(argc, argv, "--detector") == "ssd") {
+        config.backend = DetectorConfig::Ssd;
+    }
+    if (!optionValue(argc, argv, "--scale-factor").isEmpty()) {
+        config.scaleFactor = optionValue(argc, argv, "--scale-factor").toDouble();
+    }
+    if (!optionValue(argc, argv, "--min-neighbors").isEmpty()) {
+        config.minNeighbors = optionValue(argc, argv, "--min-neighbors").toInt();
+    }
+    if (!optionValue(argc, argv, "--min-size").isEmpty()) {
+        config.minFaceSize = optionValue(argc, argv, "--min-size").toInt();
+    }
+    if (!optionValue(argc, argv, "--detect-scale").isEmpty()) {
+        config.detectionScale = optionValue(argc, argv, "--detect-scale").toDouble();
+    }
+    return config;
+}
+
+// 回放类工具共用的配置
+static ReplayConfig replayConfig(int argc, char *argv[], const QString &source) {
+    ReplayConfig config;
+    config.source = source;
+    config.fps = optionValue(argc, argv, "--fps").toDouble();
+    config.maxFrames = optionValue(argc, argv, "--frames").toInt();
+    config.galleryDatabasePath = optionValue(argc, argv, "--gallery-db");
+    if (config.galleryDatabasePath.isEmpty()) {
+        config.galleryDatabasePath = kDatabasePath;
+    }
+    config.embeddingModelPath = kEmbeddingModelPath;
+    config.detectorConfig = detectorConfig(argc, argv);
+    return config;
+}
+
+// 命令行工具模式：不创建窗口，结果输出到标准输出
+static int runCommandLine(int argc, char *argv[], bool *handled) {
+    *handled = false;
+    for (int i = 1; i < argc; ++i) {
+        // --index-report [员工数量]：比较精确搜索与IVF近似搜索的召回率和延迟
+        if (qstrcmp(argv[i], "--index-report") == 0) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            int gallerySize = (i + 1 < argc) ? QString(argv[i + 1]).toInt() : 0;
+            if (gallerySize <= 0) {
+                gallerySize = 50000;
+            }
+            QTextStream(stdout) << GalleryIndex::syntheticReport(gallerySize, 128, 1000, 5);
+            return 0;
+        }
+        // --quant-report [员工数量]：比较int8/fp16量化模板与全精度模板的内存、延迟和匹配结论(阈值与DNN特征相同)
+        if (qstrcmp(argv[i], "--quant-report") == 0) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            int gallerySize = (i + 1 < argc) ? QString(argv[i + 1]).toInt() : 0;
+            if (gallerySize <= 0) {
+                gallerySize = 50000;
+            }
+            QTextStream(stdout) << GalleryIndex::quantizationReport(gallerySize, 128, 1000, 5, 0.6f);
+            return 0;
+        }
+        // --replay <视频文件|图片目录> [--fps N] [--frames N] [--detector haar|ssd] [--gallery-db 路径] [--metrics 指标文件]
+        //          [--no-motion] [--scale-factor F] [--min-neighbors N] [--min-size 像素] [--detect-scale S]
+        //          [--no-quality] [--min-sharpness F]
+        // 无界面回放，签到写入临时数据库，输出吞吐量、每帧耗时分位数和识别统计
+        if (qstrcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            ReplayConfig config = replayConfig(argc, argv, QString::fromLocal8Bit(argv[i + 1]));
+            for (int j = 1; j < argc; ++j) {
+                if (qstrcmp(argv[j], "--no-motion") == 0) {
+                    config.motionConfig.enabled = false; // 每帧检测整帧，用于对比运动门控的效果
+                }
+                if (qstrcmp(argv[j], "--no-quality") == 0) {
+                    config.qualityConfig.enabled = false; // 所有人脸都送去识别，用于对比质量门控的效果
+                }
+            }
+
+            if (!optionValue(argc, argv, "--min-sharpness").isEmpty()) {
+                config.qualityConfig.minSharpness = optionValue(argc, argv, "--min-sharpness").toDouble();
+            }
+
+            ReplayRunner runner(config);
+            if (!runner.run()) {
+                QTextStream(stderr) << "replay failed: " << runner.errorString() << "\n";
+                return 1;
+            }
+            QTextStream(stdout) << runner.report().toString();
+            // 各阶段耗时分布与界面运行时导出的格式相同
+            QString metricsPath = optionValue(argc, argv, "--metrics");
+            if (!metricsPath.isEmpty()) {
+                Metrics::instance().writeFile(metricsPath);
+            }
+            return 0;
+        }
+        // --scale-report <视频文件|图片目录> [--frames N] [--detector haar|ssd] [--scales 1,0.75,0.5]
+        // 在不同检测分辨率下检测同一批帧，输出每帧耗时和相对原始分辨率的召回率
+        if (qstrcmp(argv[i], "--scale-report") == 0 && i + 1 < argc) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            ReplayConfig config = replayConfig(argc, argv, QString::fromLocal8Bit(argv[i + 1]));
+            std::vector<double> scales = {1.0, 0.75, 0.5, 0.35, 0.25};
+            QString scaleList = optionValue(argc, argv, "--scales");
+            if (!scaleList.isEmpty()) {
+                scales.clear();
+                for (const QString &scale : scaleList.split(',', QString::SkipEmptyParts)) {
+                    scales.push_back(scale.toDouble());
+                }
+            }
+
+            ReplayRunner runner(config);
+            QString report = runner.scaleReport(scales);
+            if (report.isEmpty()) {
+                QTextStream(stderr) << "scale report failed: " << runner.errorString() << "\n";
+                return 1;
+            }
+            QTextStream(stdout) << report;
+            return 0;
+        }
+        // --backfill-summary [--db 数据库]
+        // 从考勤表重建按天/员工/部门的考勤汇总表，用于升级前已有的签到记录
+        if (qstrcmp(argv[i], "--backfill-summary") == 0) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            QString databasePath = optionValue(argc, argv, "--db");
+            if (databasePath.isEmpty()) {
+                databasePath = kDatabasePath;
+            }
+
+            bool ok = false;
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "backfill");
+                db.setDatabaseName(databasePath);
+                if (!db.open() || !DatabaseSchema::create(db)) {
+                    QTextStream(stderr) << "cannot open database: " << db.lastError().text() << "\n";
+                } else {
+                    QElapsedTimer timer;
+                    timer.start();
+                    int days = 0;
+                    QString error;
+                    AttendanceStore store(db);
+                    ok = store.migrateLegacy(nullptr);
+                    if (!ok) {
+                        error = store.errorString();
+                    } else {
+                        ok = AttendanceSummary::backfill(db, &days, &error);
+                    }
+                    if (ok) {
+                        QTextStream(stdout) << "summarized " << days << " employee-days in " << timer.elapsed() << " ms\n";
+                    } else {
+                        QTextStream(stderr) << "backfill failed: " << error << "\n";
+                    }
+                }
+                db.close();
+            }
+            QSqlDatabase::removeDatabase("backfill");
+            return ok ? 0 : 1;
+        }
+        // --compact-attendance [--keep-months N] [--archive-dir 目录] [--db 数据库]
+        // 把旧版考勤表搬进按月分区，保留期之前的分区归档为只读文件，然后回收主数据库的空间；应在程序没有运行时执行
+        if (qstrcmp(argv[i], "--compact-attendance") == 0) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            QString databasePath = optionValue(argc, argv, "--db");
+            if (databasePath.isEmpty()) {
+                databasePath = kDatabasePath;
+            }
+            QString archiveDir = optionValue(argc, argv, "--archive-dir");
+            if (archiveDir.isEmpty()) {
+                archiveDir = kArchiveDir;
+            }
+            int keepMonths = optionValue(argc, argv, "--keep-months").isEmpty()
+                    ? kKeepMonths : optionValue(argc, argv, "--keep-months").toInt();
+
+            bool ok = false;
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "compact");
+                db.setDatabaseName(databasePath);
+                if (!db.open() || !DatabaseSchema::create(db)) {
+                    QTextStream(stderr) << "cannot open database: " << db.lastError().text() << "\n";
+                } else {
+                    QElapsedTimer timer;
+                    timer.start();
+                    qint64 before = QFileInfo(databasePath).size();
+                    qint64 migrated = 0;
+                    QStringList archived;
+                    AttendanceStore store(db);
+                    ok = store.migrateLegacy(&migrated)
+                            && store.archive(archiveDir, keepMonths, &archived)
+                            && store.compact();
+                    if (ok) {
+                        QTextStream(stdout) << "migrated " << migrated << " records, archived " << archived.size()
+                                            << " months, database " << before / 1024 << " KB -> "
+                                            << QFileInfo(databasePath).size() / 1024 << " KB in " << timer.elapsed() << " ms\n";
+                        for (const QString &path : archived) {
+                            QTextStream(stdout) << "  " << path << " (" << QFileInfo(path).size() / 1024 << " KB)\n";
+                        }
+                    } else {
+                        QTextStream(stderr) << "compaction failed: " << store.errorString() << "\n";
+                    }
+                }
+                db.close();
+            }
+            QSqlDatabase::removeDatabase("compact");
+            return ok ? 0 : 1;
+        }
+        // --export <输出文件.csv|.fatc> [--from yyyy-MM-dd] [--to yyyy-MM-dd] [--department 部门] [--employee 员工编号] [--db 数据库] [--chunk 行数]
+        // 流式导出考勤记录，按扩展名选择CSV或列式格式，进度输出到标准错误
+        if (qstrcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            ExportConfig config;
+            config.outputPath = QString::fromLocal8Bit(argv[i + 1]);
+            config.format = ExportConfig::formatForPath(config.outputPath);
+            config.databasePath = optionValue(argc, argv, "--db");
+            if (config.databasePath.isEmpty()) {
+                config.databasePath = kDatabasePath;
+            }
+            QDate from = QDate::fromString(optionValue(argc, argv, "--from"), "yyyy-MM-dd");
+            QDate to = QDate::fromString(optionValue(argc, argv, "--to"), "yyyy-MM-dd");
+            if (from.isValid()) {
+                config.filter.from = QDateTime(from, QTime(0, 0, 0));
+            }
+            if (to.isValid()) {
+                config.filter.to = QDateTime(to, QTime(23, 59, 59));
+            }
+            config.filter.department = optionValue(argc, argv, "--department");
+            config.filter.employeeId = optionValue(argc, argv, "--employee");
+            if (!optionValue(argc, argv, "--chunk").isEmpty()) {
+                config.chunkRows = optionValue(argc, argv, "--chunk").toInt();
+            }
+
+            // 导出在工作线程中进行，主线程每秒输出一次进度
+            AttendanceExporter exporter(config);
+            bool ok = false;
+            QThread *thread = QThread::create([&exporter, &ok]() { ok = exporter.run(); });
+            thread->start();
+            while (!thread->wait(1000)) {
+                QTextStream(stderr) << "exported " << exporter.progress() << "/" << exporter.total() << "\n";
+            }
+            delete thread;
+
+            if (!ok) {
+                QTextStream(stderr) << "export failed: " << exporter.errorString() << "\n";
+                return 1;
+            }
+            QTextStream(stdout) << exporter.report().toString();
+            return 0;
+        }
+        // --serve [--port N] [--listen 地址] [--db 数据库] [--detector haar|ssd] [--threads N]
+        // 无界面运行 HTTP 接口：考勤查询、员工查询、运行指标和图片识别，按 Ctrl+C 退出
+        if (qstrcmp(argv[i], "--serve") == 0) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            HttpServerConfig config;
+            config.databasePath = optionValue(argc, argv, "--db");
+            if (config.databasePath.isEmpty()) {
+                config.databasePath = kDatabasePath;
+            }
+            if (!optionValue(argc, argv, "--port").isEmpty()) {
+                config.port = static_cast<quint16>(optionValue(argc, argv, "--port").toUInt());
+            }
+            if (!optionValue(argc, argv, "--listen").isEmpty()) {
+                config.address = QHostAddress(optionValue(argc, argv, "--listen"));
+            }
+            if (!optionValue(argc, argv, "--threads").isEmpty()) {
+                config.recognitionThreads = optionValue(argc, argv, "--threads").toInt();
+            }
+            config.detectorConfig = detectorConfig(argc, argv);
+            config.embeddingModelPath = kEmbeddingModelPath;
+
+            int code = 0;
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "serve");
+                db.setDatabaseName(config.databasePath);
+                if (!db.open() || !DatabaseSchema::create(db)) {
+                    QTextStream(stderr) << "cannot open database: " << db.lastError().text() << "\n";
+                    code = 1;
+                } else if (!AttendanceStore(db).migrateLegacy(nullptr)) {
+                    QTextStream(stderr) << "cannot migrate attendance records\n";
+                    code = 1;
+                } else {
+                    FaceEmbedder embedder;
+                    embedder.load(config.embeddingModelPath);
+                    FaceGallery gallery;
+                    gallery.setIndexPath(kIndexPath);
+                    gallery.setTemplatePath(kTemplatePath);
+                    gallery.loadFromDatabase(db, embedder);
+
+                    AttendanceWriter writer(config.databasePath);
+                    writer.start();
+                    HttpServer server(config, &gallery, &writer);
+                    QObject::connect(&server, &HttpServer::listening, [](quint16 port) {
+                        QTextStream(stdout) << "listening on port " << port << "\n";
+                    });
+                    QObject::connect(&server, &HttpServer::listenFailed, &app, [&app](const QString &error) {
+                        QTextStream(stderr) << "cannot listen: " << error << "\n";
+                        app.exit(1);
+                    });
+                    server.start();
+                    code = app.exec();
+                    server.stop();
+                    writer.stop();
+                }
+                db.close();
+            }
+            QSqlDatabase::removeDatabase("serve");
+            return code;
+        }
+        // --enroll <照片目录> <员工名单.csv> [--threads N] [--db 数据库] [--detector haar|ssd]
+        // 批量录入：并行检测人脸和提取特征，一个事务写入员工表，输出吞吐量和失败原因
+        if (qstrcmp(argv[i], "--enroll") == 0 && i + 2 < argc) {
+            *handled = true;
+            QCoreApplication app(argc, argv);
+            BulkEnrollConfig config;
+            config.photoDir = QString::fromLocal8Bit(argv[i + 1]);
+            config.csvPath = QString::fromLocal8Bit(argv[i + 2]);
+            config.faceDir = kFaceDir;
+            config.embeddingModelPath = kEmbeddingModelPath;
+            config.detectorConfig = detectorConfig(argc, argv);
+            config.threadCount = optionValue(argc, argv, "--threads").toInt();
+            QString databasePath = optionValue(argc, argv, "--db");
+            if (databasePath.isEmpty()) {
+                databasePath = kDatabasePath;
+            }
+
+            bool ok = false;
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "enroll");
+                db.setDatabaseName(databasePath);
+                QDir().mkpath(config.faceDir);
+                if (!db.open() || !DatabaseSchema::create(db)) {
+                    QTextStream(stderr) << "cannot open database: " << db.lastError().text() << "\n";
+                } else {
+                    // 录入后的人脸库写回模板文件和索引，界面下次启动不必重新提取特征
+                    FaceEmbedder embedder;
+                    embedder.load(config.embeddingModelPath);
+                    FaceGallery gallery;
+                    gallery.setIndexPath(kIndexPath);
+                    gallery.setTemplatePath(kTemplatePath);
+                    gallery.loadFromDatabase(db, embedder);
+
+                    BulkEnroller enroller(config);
+                    ok = enroller.run(db, &gallery);
+                    if (ok) {
+                        gallery.saveTemplates();
+                        gallery.saveIndex();
+                        QTextStream(stdout) << enroller.report().toString();
+                    } else {
+                        QTextStream(stderr) << "enroll failed: " << enroller.errorString() << "\n";
+                    }
+                }
+                db.close();
+            }
+            QSqlDatabase::removeDatabase("enroll");
+            return ok ? 0 : 1;
+        }
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
+    bool handled = false;
+    int code = runCommandLine(argc, argv, &handled);
+    if (handled) {
+        return code;
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
 
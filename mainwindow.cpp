@@ -1,5 +1,12 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "attendancestore.h"
+#include "bulkenroller.h"
+#include "databaseschema.h"
+#include "metrics.h"
+#include "previewview.h"
+#include "startupsequence.h"
+#include "toastoverlay.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp> // 引入 DNN 模块
 #include <QDateTime>
@@ -9,69 +16,221 @@
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QTabWidget>
-#include <QTableWidget>
+#include <QTableView>
 #include <QHeaderView>
+#include <QDateEdit>
+#include <QCheckBox>
 #include <QLabel>
 #include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QStandardItemModel>
+#include <QFileDialog>
+#include <QThread>
 #include <QDebug>
+#include <algorithm>
+
+namespace {
+const int kPreviewFps = 30; // 预览刷新率上限，与采集和分析的帧率无关
+const int kMetricsIntervalMs = 1000; // 状态栏指标刷新间隔
+const int kMetricsExportTicks = 10; // 每刷新多少次导出一次指标文件
+const char *kDatabasePath = "D:/code/qt_project/OpenCV_Face/attendance.db"; // 员工和考勤数据库
+const char *kFaceCascadePath = "D:/code/qt_project/OpenCV_Face/haarcascade_frontalface_default.xml"; // 录入时使用的人脸检测分类器
+const char *kGalleryConnectionName = "startup_gallery"; // 后台加载人脸库时使用的数据库连接名
+const char *kArchiveConnectionName = "startup_archive"; // 后台归档考勤分区时使用的数据库连接名
+const char *kArchiveDir = "D:/code/qt_project/OpenCV_Face/archive"; // 考勤归档文件目录，每个月份一个只读数据库
+const int kKeepMonths = 12; // 主数据库中保留的考勤月数(含当月)
+const char *kStartupReportPath = "D:/code/qt_project/OpenCV_Face/startup.txt"; // 最近一次启动的各阶段耗时
+const quint16 kHttpPort = 8080; // HTTP 接口端口，只监听本机地址
+const char *kMetricsPath = "D:/code/qt_project/OpenCV_Face/metrics.prom"; // 指标文件，扩展名改为.json时导出JSON
+const int kEnrollCandidates = 8; // 录入时保留的候选帧数
+const int kEnrollSampleMs = 200; // 录入时候选帧的采样间隔
+const char *kCameraListPath = "D:/code/qt_project/OpenCV_Face/cameras.txt"; // 视频源列表，每行一个摄像头编号、视频文件或网络地址
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , cap(0) // Initialize VideoCapture last
+    , pipeline(nullptr)
+    , attendanceWriter(nullptr)
+    , httpServer(nullptr)
+    , startup(new StartupSequence(this))
+    , startupProgress(nullptr)
+    , lastCandidateTime(0)
     , timer(new QTimer(this))
-    , videoLabel(new QLabel(this))
-    , detectLabel(new QLabel(this))
+    , videoLabel(nullptr)
+    , detectLabel(nullptr)
     , employeeIDEdit(new QLineEdit(this))
     , employeeNameEdit(new QLineEdit(this))
     , departmentEdit(new QLineEdit(this))
     , captureButton(new QPushButton("录入", this))
+    , deleteButton(nullptr)
+    , bulkEnrollButton(nullptr)
+    , bulkEnroller(nullptr)
+    , bulkEnrollThread(nullptr)
     , startDetectButton(new QPushButton("开始检测", this))
     , stopDetectButton(new QPushButton("停止检测", this))
+    , detectorCombo(nullptr)
+    , detectorStatsLabel(nullptr)
+    , metricsLabel(nullptr)
+    , toast(nullptr)
+    , metricsTimer(new QTimer(this))
+    , metricsTicks(0)
+    , recordTable(nullptr)
+    , attendanceModel(nullptr)
+    , dateFilterCheck(nullptr)
+    , fromDateEdit(nullptr)
+    , toDateEdit(nullptr)
+    , departmentFilterEdit(nullptr)
+    , employeeFilterEdit(nullptr)
+    , exportButton(nullptr)
+    , exporter(nullptr)
+    , exportThread(nullptr)
+    , dashboard(nullptr)
     , isRecording(false)
     , isOnRecordPage(true)
     , isDetecting(false) // Initialize detection flag
-    , detecting(false)
 {
+    // 界面线程只做必须同步完成的工作：打开数据库和创建控件；模型、分类器和人脸库在后台并行加载，摄像头在采集线程中打开
+    startup->addExternalPhase("database");
     ui->setupUi(this);
     initializeDatabase();
+    startup->finishPhase("database", db.isOpen());
+    startup->addExternalPhase("window");
     initializeDirectories();
+    cameraSources = loadCameraSources();
     setupUI();
+    toast = new ToastOverlay(centralWidget()); // 覆盖在所有页面之上
     setWindowTitle("人事考勤系统"); // 设置窗口标题
-    initializeDNN(); // 初始化 DNN 模型
-
-    QString faceCascadePath = "D:/code/qt_project/OpenCV_Face/haarcascade_frontalface_default.xml";
-    if (!faceCascade.load(faceCascadePath.toStdString())) {
-        qDebug() << "Error loading face cascade from: " << faceCascadePath;
-        return;
-    }
-
-    if (!cap.isOpened()) {
-        qDebug() << "Error opening video stream or file";
-        return;
+    initializeDNN(); // 检测器配置和模型路径
+    gallery.setIndexPath("D:/code/qt_project/OpenCV_Face/gallery.index"); // 索引持久化文件，员工不变时启动直接加载
+    gallery.setTemplatePath("D:/code/qt_project/OpenCV_Face/gallery.bin"); // 内存映射的模板文件，只为新增或变化的员工提取特征
+
+    // 注册跨线程信号中使用的类型
+    qRegisterMetaType<EmployeeRecord>("EmployeeRecord");
+
+    // 签到记录由独立的写入线程批量提交
+    attendanceWriter = new AttendanceWriter(db.databaseName(), this);
+    attendanceWriter->setNotificationQueue(&notifications);
+    attendanceWriter->start();
+
+    // 采集和识别在后台线程中进行，界面线程只负责绘制
+    // 摄像头在各自的采集线程中打开，与模型加载同时进行；识别线程在开始检测时才启动
+    detectorConfig.cascadePath = kFaceCascadePath;
+    pipeline = new FramePipeline(cameraSources, detectorConfig, embeddingModelPath, &gallery, attendanceWriter, 0, this);
+    pipeline->setNotificationQueue(&notifications);
+    connect(pipeline, &FramePipeline::detectorStats, this, &MainWindow::onDetectorStats);
+    connect(pipeline, &FramePipeline::detectorFailed, this, &MainWindow::onDetectorFailed);
+    for (int i = 0; i < cameraSources.size(); ++i) {
+        startup->addExternalPhase(QString("camera %1").arg(i));
     }
+    connect(pipeline, &FramePipeline::cameraOpened, this, [this](int cameraId) {
+        startup->finishPhase(QString("camera %1").arg(cameraId), true);
+    });
+    connect(pipeline, &FramePipeline::cameraOpenFailed, this, [this](int cameraId) {
+        startup->finishPhase(QString("camera %1").arg(cameraId), false);
+    });
+    pipeline->start();
+
+    // 特征提取模型和分类器互不依赖，并行加载；人脸库需要模型为变化的员工提取特征
+    startup->addPhase("model", QStringList(), [this]() {
+        return embedder.load(embeddingModelPath, detectorConfig.dnnBackend, detectorConfig.dnnTarget); // 失败时已退回直方图特征
+    });
+    startup->addPhase("cascade", QStringList(), [this]() {
+        bool ok = faceCascade.load(kFaceCascadePath);
+        if (!ok) {
+            qDebug() << "Error loading face cascade from: " << kFaceCascadePath;
+        }
+        return ok;
+    });
+    startup->addPhase("gallery", QStringList() << "model", [this]() { return loadGallery(); });
+    startup->addPhase("archive", QStringList(), [this]() { return archiveAttendance(); });
+    connect(startup, &StartupSequence::phaseFinished, this, &MainWindow::onStartupPhaseFinished);
+    connect(startup, &StartupSequence::allFinished, this, &MainWindow::onStartupFinished);
+
+    // 依赖的阶段完成前禁用对应的功能
+    captureButton->setEnabled(false);
+    deleteButton->setEnabled(false);
+    bulkEnrollButton->setEnabled(false);
+    startDetectButton->setEnabled(false);
 
     connect(timer, &QTimer::timeout, this, &MainWindow::processFrameAndUpdateGUI);
     connect(captureButton, &QPushButton::clicked, this, &MainWindow::captureFaceAndRecord);
+    connect(deleteButton, &QPushButton::clicked, this, &MainWindow::deleteEmployee);
+    connect(bulkEnrollButton, &QPushButton::clicked, this, &MainWindow::bulkEnroll);
     connect(startDetectButton, &QPushButton::clicked, this, &MainWindow::startDetection);
     connect(stopDetectButton, &QPushButton::clicked, this, &MainWindow::stopDetection);
     connect(tabWidget, &QTabWidget::currentChanged, this, &MainWindow::onTabChanged);
+    connect(detectorCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onDetectorChanged);
 
-    timer->start(30);
+    timer->start(1000 / kPreviewFps); // 只取预览队列中最新的一帧，刷新率封顶，超出的帧在队列中被丢弃
+
+    connect(metricsTimer, &QTimer::timeout, this, &MainWindow::updateMetrics);
+    metricsTimer->start(kMetricsIntervalMs);
 
     // 设置默认的标签页为检测页面
     tabWidget->setCurrentIndex(1);
 
+    startup->finishPhase("window", true);
+    startup->start();
+
 
 }
 
 MainWindow::~MainWindow() {
+    delete startup; // 等待仍在进行的加载，它们引用了人脸库和特征提取器
+    startup = nullptr;
+    if (bulkEnrollThread) {
+        bulkEnrollThread->wait(); // 特征提取线程引用了批量录入对象
+    }
+    if (exportThread) {
+        exporter->cancel(); // 未完成的导出不保留文件
+        exportThread->wait();
+        delete exporter;
+    }
+    // 先停止后台线程，它们引用了人脸库等成员
+    if (httpServer) {
+        httpServer->stop();
+    }
+    if (pipeline) {
+        pipeline->stop();
+    }
+    if (attendanceWriter) {
+        attendanceWriter->stop(); // 写完队列中剩余的签到记录
+    }
+    gallery.saveIndex(); // 保存录入/删除后的索引，下次启动直接加载
+    gallery.saveTemplates(); // 录入/删除后重写模板文件
+    Metrics::instance().writeFile(kMetricsPath);
     delete ui;
 }
 
+QStringList MainWindow::loadCameraSources() {
+    // 每行一个视频源，#开头为注释；文件不存在时只使用0号摄像头
+    QStringList sources;
+    QFile file(kCameraListPath);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QString line = in.readLine().trimmed();
+            if (!line.isEmpty() && !line.startsWith('#')) {
+                sources.append(line);
+            }
+        }
+    }
+    if (sources.isEmpty()) {
+        sources.append("0");
+    }
+    if (sources.size() > Metrics::kMaxCameras) {
+        qDebug() << "Too many cameras, using the first" << Metrics::kMaxCameras;
+        sources = sources.mid(0, Metrics::kMaxCameras);
+    }
+    return sources;
+}
+
 void MainWindow::initializeDirectories() {
     // 创建存储人脸图像的目录，如果目录不存在的话
     QDir dir("D:/code/qt_project/OpenCV_Face/faces");
@@ -83,7 +242,9 @@ void MainWindow::initializeDirectories() {
 void MainWindow::initializeDatabase() {
     // 初始化SQLite数据库
     db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName("D:/code/qt_project/OpenCV_Face/attendance.db");
+    db.setDatabaseName(kDatabasePath);
+
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000"); // 与写入线程的连接并发访问时等待而不是立即失败
 
     // 打开数据库连接
     if (!db.open()) {
@@ -91,26 +252,16 @@ void MainWindow::initializeDatabase() {
         return;
     }
 
-    QSqlQuery query;
-    // 创建员工表，如果表不存在的话
-    if (!query.exec("CREATE TABLE IF NOT EXISTS employees ("
-                    "id INTEGER PRIMARY KEY AUTOINCREMENT, " // 自动递增的主键
-                    "employee_id TEXT UNIQUE, " // 员工编号，唯一
-                    "name TEXT, " // 姓名
-                    "department TEXT, " // 部门
-                    "face_image TEXT)")) { // 人脸图像的文件名或路径
-        qDebug() << "Error creating employees table:" << query.lastError().text(); // 如果创建表失败，输出错误信息
-    }
-
-    // 创建考勤记录表，如果表不存在的话
-    if (!query.exec("CREATE TABLE IF NOT EXISTS attendance ("
-                    "id INTEGER PRIMARY KEY AUTOINCREMENT, " // 自动递增的主键
-                    "employee_id TEXT, " // 员工编号
-                    "name TEXT, " // 姓名
-                    "department TEXT, " // 部门
-                    "timestamp TEXT, " // 签到时间
-                    "face_image TEXT)")) { // 人脸图像的文件名或路径
-        qDebug() << "Error creating attendance table:" << query.lastError().text(); // 如果创建表失败，输出错误信息
+    // 建表和索引与无界面回放模式共用
+    DatabaseSchema::create(db);
+
+    // 旧版考勤表搬进按月分区后才能查询和写入，只在升级后第一次启动时有数据要搬
+    qint64 migrated = 0;
+    AttendanceStore store(db);
+    if (!store.migrateLegacy(&migrated)) {
+        QMessageBox::warning(this, "数据库错误", "旧考勤记录迁移失败：" + store.errorString());
+    } else if (migrated > 0) {
+        qDebug() << "Migrated" << migrated << "attendance records to monthly partitions";
     }
 }
 
@@ -132,10 +283,9 @@ void MainWindow::setupUI() {
     QVBoxLayout *leftRecordLayout = new QVBoxLayout;
     QFormLayout *formLayout = new QFormLayout;
 
-    // 创建视频显示标签
-    videoLabel = new QLabel(this);
+    // 创建视频显示控件
+    videoLabel = new PreviewView(this);
     videoLabel->setFixedSize(640, 480);
-    videoLabel->setStyleSheet("border: 2px solid #ddd; border-radius: 5px;"); // 添加边框和圆角
     leftRecordLayout->addWidget(videoLabel);
 
     // 创建表单输入字段和按钮
@@ -143,6 +293,8 @@ void MainWindow::setupUI() {
     employeeIDEdit = new QLineEdit(this);
     employeeNameEdit = new QLineEdit(this);
     captureButton = new QPushButton("录入", this);
+    deleteButton = new QPushButton("删除", this);
+    bulkEnrollButton = new QPushButton("批量录入", this);
 
     QLabel *departmentLabel = new QLabel("部门:", this);
     QLabel *employeeIDLabel = new QLabel("员工编号:", this);
@@ -157,14 +309,20 @@ void MainWindow::setupUI() {
     employeeIDEdit->setFont(font);
     employeeNameEdit->setFont(font);
     captureButton->setFont(font);
+    deleteButton->setFont(font);
+    bulkEnrollButton->setFont(font);
 
     captureButton->setStyleSheet("background-color: #4CAF50; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
+    deleteButton->setStyleSheet("background-color: #f44336; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
+    bulkEnrollButton->setStyleSheet("background-color: #2196F3; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
 
     // 使用 QFormLayout 布局输入字段
     formLayout->addRow(departmentLabel, departmentEdit);
     formLayout->addRow(employeeIDLabel, employeeIDEdit);
     formLayout->addRow(employeeNameLabel, employeeNameEdit);
     formLayout->addRow(captureButton);
+    formLayout->addRow(deleteButton);
+    formLayout->addRow(bulkEnrollButton);
 
     formLayout->setLabelAlignment(Qt::AlignRight); // 标签右对齐
     formLayout->setSpacing(15); // 增加行间距
@@ -196,14 +354,25 @@ void MainWindow::setupUI() {
     QWidget *detectPage = new QWidget(this);
     QVBoxLayout *detectLayout = new QVBoxLayout;
 
-    // 创建视频显示容器
+    // 创建视频显示容器：每个摄像头一个画面，多路时按两列网格排列并缩小显示
     QWidget *videoContainer = new QWidget(this);
-    QVBoxLayout *videoLayout = new QVBoxLayout;
-    detectLabel = new QLabel(this);
-    detectLabel->setFixedSize(640, 480);
-    detectLabel->setStyleSheet("border: 2px solid #ddd; border-radius: 5px;"); // 添加边框和圆角
-    videoLayout->addWidget(detectLabel);
-    videoLayout->setAlignment(Qt::AlignCenter); // 使 detectLabel 居中
+    QGridLayout *videoLayout = new QGridLayout;
+    bool multiCamera = cameraSources.size() > 1;
+    for (int i = 0; i < cameraSources.size(); ++i) {
+        PreviewView *view = new PreviewView(this);
+        view->setFixedSize(multiCamera ? QSize(320, 240) : QSize(640, 480)); // 画面按控件大小缩放绘制
+        QLabel *caption = new QLabel(QString("摄像头 %1: %2").arg(i).arg(cameraSources[i]), this);
+        caption->setAlignment(Qt::AlignCenter);
+
+        QVBoxLayout *cell = new QVBoxLayout;
+        cell->addWidget(view);
+        cell->addWidget(caption);
+        videoLayout->addLayout(cell, i / 2, i % 2);
+        cameraViews.append(view);
+        cameraCaptions.append(caption);
+    }
+    detectLabel = cameraViews.first();
+    videoLayout->setAlignment(Qt::AlignCenter); // 使画面居中
     videoContainer->setLayout(videoLayout);
 
     // 添加开始和停止按钮
@@ -217,6 +386,13 @@ void MainWindow::setupUI() {
     startDetectButton->setFont(font);
     stopDetectButton->setFont(font);
 
+    // 人脸检测后端选择
+    detectorCombo = new QComboBox(this);
+    detectorCombo->addItem("Haar 级联", DetectorConfig::Haar);
+    detectorCombo->addItem("SSD ResNet-10", DetectorConfig::Ssd);
+    detectorCombo->setFont(font);
+
+    buttonLayout->addWidget(detectorCombo);
     buttonLayout->addWidget(startDetectButton);
     buttonLayout->addWidget(stopDetectButton);
     buttonLayout->setAlignment(Qt::AlignCenter); // 使按钮居中
@@ -228,28 +404,69 @@ void MainWindow::setupUI() {
     // 设置记录表格页面
     QWidget *recordPage2 = new QWidget(this);
     QVBoxLayout *recordLayout2 = new QVBoxLayout;
-    QTableWidget *recordTable = new QTableWidget(this);
+
+    // 筛选条件：日期范围、部门、员工编号
+    QHBoxLayout *filterLayout = new QHBoxLayout;
+    dateFilterCheck = new QCheckBox("日期", this);
+    dateFilterCheck->setFont(font);
+    fromDateEdit = new QDateEdit(QDate::currentDate().addDays(-7), this);
+    fromDateEdit->setCalendarPopup(true);
+    fromDateEdit->setDisplayFormat("yyyy-MM-dd");
+    toDateEdit = new QDateEdit(QDate::currentDate(), this);
+    toDateEdit->setCalendarPopup(true);
+    toDateEdit->setDisplayFormat("yyyy-MM-dd");
+    departmentFilterEdit = new QLineEdit(this);
+    departmentFilterEdit->setPlaceholderText("部门");
+    employeeFilterEdit = new QLineEdit(this);
+    employeeFilterEdit->setPlaceholderText("员工编号");
+    filterLayout->addWidget(dateFilterCheck);
+    filterLayout->addWidget(fromDateEdit);
+    filterLayout->addWidget(new QLabel("至", this));
+    filterLayout->addWidget(toDateEdit);
+    filterLayout->addWidget(departmentFilterEdit);
+    filterLayout->addWidget(employeeFilterEdit);
+    recordLayout2->addLayout(filterLayout);
+
+    // 表格只显示已加载的页，滚动到底部时自动加载下一页
+    attendanceModel = new AttendanceTableModel(db, this);
+    recordTable = new QTableView(this);
     recordTable->setObjectName("recordTable");
-    recordTable->setColumnCount(5);
-    recordTable->setHorizontalHeaderLabels({"员工编号", "姓名", "部门", "签到时间", "人脸图像"});
+    recordTable->setModel(attendanceModel);
+    recordTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    recordTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    recordTable->verticalHeader()->setDefaultSectionSize(24); // 固定行高，滚动时不需要逐行计算
+    recordTable->horizontalHeader()->setStretchLastSection(true);
 
-    recordTable->setStyleSheet("QTableWidget { border: 1px solid #ddd; padding: 5px; }"
+    recordTable->setStyleSheet("QTableView { border: 1px solid #ddd; padding: 5px; }"
                                "QHeaderView::section { background-color: #f4f4f4; font-weight: bold; }");
 
     recordLayout2->addWidget(recordTable);
 
-    QPushButton *refreshButton = new QPushButton("刷新", this);
+    QPushButton *refreshButton = new QPushButton("查询", this);
     refreshButton->setFont(font);
     refreshButton->setStyleSheet("background-color: #4CAF50; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
 
-    recordLayout2->addWidget(refreshButton);
+    // 导出按当前筛选条件在后台线程中进行，记录再多也不占用界面线程和内存
+    exportButton = new QPushButton("导出", this);
+    exportButton->setFont(font);
+    exportButton->setStyleSheet("background-color: #2196F3; color: white; font-weight: bold; padding: 5px; border-radius: 5px;");
+
+    QHBoxLayout *recordButtonLayout = new QHBoxLayout;
+    recordButtonLayout->addWidget(refreshButton);
+    recordButtonLayout->addWidget(exportButton);
+    recordLayout2->addLayout(recordButtonLayout);
     connect(refreshButton, &QPushButton::clicked, this, &MainWindow::updateRecordTable);
+    connect(exportButton, &QPushButton::clicked, this, &MainWindow::exportAttendance);
 
     recordPage2->setLayout(recordLayout2);
 
+    // 考勤统计页面，图表数据来自考勤写入线程增量维护的汇总表
+    dashboard = new DashboardView(db, this);
+
     tabWidget->addTab(recordPage, "人脸录入");
     tabWidget->addTab(detectPage, "考勤签到");
     tabWidget->addTab(recordPage2, "考勤记录");
+    tabWidget->addTab(dashboard, "考勤统计");
 
     setCentralWidget(tabWidget);
 
@@ -257,6 +474,14 @@ void MainWindow::setupUI() {
     QStatusBar *statusBar = new QStatusBar(this);
     QLabel *copyrightLabel = new QLabel("版权所有 © 13", this);
     statusBar->addWidget(copyrightLabel);
+    startupProgress = new QProgressBar(this);
+    startupProgress->setMaximumWidth(200);
+    startupProgress->setFormat("启动中 %v/%m");
+    statusBar->addPermanentWidget(startupProgress);
+    detectorStatsLabel = new QLabel(this);
+    statusBar->addPermanentWidget(detectorStatsLabel);
+    metricsLabel = new QLabel(this);
+    statusBar->addPermanentWidget(metricsLabel);
     setStatusBar(statusBar);
 }
 
@@ -264,69 +489,188 @@ void MainWindow::setupUI() {
 
 void MainWindow::initializeDNN() {
     // 模型文件路径
-    std::string modelFile = "D:/code/qt_project/OpenCV_Face/models/deploy.prototxt";
+    detectorConfig.ssdConfigPath = "D:/code/qt_project/OpenCV_Face/models/deploy.prototxt";
     // 权重文件路径
-    std::string weightFile = "D:/code/qt_project/OpenCV_Face/models/res10_300x300_ssd_iter_140000.caffemodel";
+    detectorConfig.ssdModelPath = "D:/code/qt_project/OpenCV_Face/models/res10_300x300_ssd_iter_140000.caffemodel";
+    detectorConfig.confidenceThreshold = 0.5f; // 置信度阈值
+    detectorConfig.scaleFactor = 1.1; // Haar 金字塔缩放比例
+    detectorConfig.minNeighbors = 4; // Haar 相邻检测数，略高于默认值以减少误检
+    detectorConfig.minFaceSize = 60; // 门口摄像头拍到的人脸通常不小于60像素，更小的不检测
+    detectorConfig.detectionScale = 0.5; // 在半分辨率上检测和跟踪，提高摄像头分辨率时检测耗时基本不变
+    detectorConfig.dnnBackend = cv::dnn::DNN_BACKEND_OPENCV; // 使用 OpenCV 自带的计算后端
+    detectorConfig.dnnTarget = cv::dnn::DNN_TARGET_CPU; // 在 CPU 上运行
+
+    // 人脸特征提取模型(OpenFace)，在启动阶段中后台加载，不存在时使用直方图特征
+    embeddingModelPath = "D:/code/qt_project/OpenCV_Face/models/nn4.small2.v1.t7";
+
+    // 网络在识别线程中加载，这里只检查模型文件是否存在
+    if (!QFile::exists(detectorConfig.ssdConfigPath) || !QFile::exists(detectorConfig.ssdModelPath)) {
+        qDebug() << "Error loading DNN model.";
+        // 模型不存在时禁用 SSD 选项
+        QStandardItemModel *model = qobject_cast<QStandardItemModel *>(detectorCombo->model());
+        if (model) {
+            model->item(1)->setEnabled(false);
+        }
+    }
+}
 
-    // 从 Caffe 模型和权重文件中读取深度神经网络（DNN）
-    net = cv::dnn::readNetFromCaffe(modelFile, weightFile);
 
-    // 检查网络是否成功加载
-    if (net.empty()) {
-        // 如果网络为空，则输出错误信息
-        qDebug() << "Error loading DNN model.";
+bool MainWindow::loadGallery() {
+    // 在加载线程中使用自己的数据库连接，界面线程的连接不能跨线程使用
+    bool ok = false;
+    {
+        QSqlDatabase connection = QSqlDatabase::addDatabase("QSQLITE", kGalleryConnectionName);
+        connection.setDatabaseName(kDatabasePath);
+        connection.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        ok = connection.open() && gallery.loadFromDatabase(connection, embedder);
+        connection.close();
     }
+    QSqlDatabase::removeDatabase(kGalleryConnectionName);
+    return ok;
 }
 
+bool MainWindow::archiveAttendance() {
+    // 保留期之前的月份写成只读归档文件，主数据库和它的索引只保留最近的记录；归档后的记录仍可查询和导出
+    bool ok = false;
+    {
+        QSqlDatabase connection = QSqlDatabase::addDatabase("QSQLITE", kArchiveConnectionName);
+        connection.setDatabaseName(kDatabasePath);
+        connection.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (connection.open()) {
+            AttendanceStore store(connection);
+            ok = store.archive(kArchiveDir, kKeepMonths, nullptr);
+            if (!ok) {
+                qDebug() << "Error archiving attendance:" << store.errorString();
+            }
+        }
+        connection.close();
+    }
+    QSqlDatabase::removeDatabase(kArchiveConnectionName);
+    return ok;
+}
+
+void MainWindow::onStartupPhaseFinished(const QString &phase, bool ok) {
+    startupProgress->setMaximum(startup->phaseCount());
+    startupProgress->setValue(startup->finishedCount());
+    if (!ok) {
+        toast->post("startup:" + phase, ToastOverlay::Warning, "启动错误", QString("%1 加载失败").arg(phase));
+    }
+
+    // 人脸库加载成功后才能识别、删除和批量录入；界面录入还需要人脸检测分类器
+    // 加载失败时保持禁用，否则会用空人脸库把所有人判为陌生人，或录入到不完整的人脸库
+    if (phase == "gallery") {
+        startDetectButton->setEnabled(ok && !isDetecting);
+        deleteButton->setEnabled(ok);
+        bulkEnrollButton->setEnabled(ok);
+
+        // 其他系统通过 HTTP 接口查询和提交识别，不再直接打开数据库文件，也不经过界面线程
+        if (ok) {
+            HttpServerConfig httpConfig;
+            httpConfig.port = kHttpPort;
+            httpConfig.databasePath = kDatabasePath;
+            httpConfig.detectorConfig = detectorConfig;
+            httpConfig.embeddingModelPath = embeddingModelPath;
+            httpServer = new HttpServer(httpConfig, &gallery, attendanceWriter, this);
+            httpServer->start();
+        } else {
+            qDebug() << "HTTP server not started: face gallery failed to load";
+        }
+    }
+    if ((phase == "gallery" || phase == "cascade") && startup->succeeded("gallery") && startup->succeeded("cascade")) {
+        captureButton->setEnabled(true);
+    }
+}
+
+void MainWindow::onStartupFinished() {
+    QString report = startup->report();
+    qDebug().noquote() << report;
+    startupProgress->hide();
+    metricsLabel->setToolTip(report);
+
+    QFile file(kStartupReportPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream(&file) << report;
+    }
+}
 
 void MainWindow::processFrameAndUpdateGUI() {
-    // 创建一个 OpenCV 的 Mat 对象来存储从摄像头捕获的图像
-    cv::Mat frame;
-    cap >> frame; // 从摄像头捕获一帧图像
+    // 识别结果在所有页面都显示
+    drainNotifications();
 
-    // 如果帧为空，直接返回，不进行后续处理
-    if (frame.empty()) {
+    // 只刷新当前可见的页面：录入页面显示0号摄像头，检测页面显示所有摄像头，记录页面不取帧
+    int page = tabWidget->currentIndex();
+    if (page != 0 && page != 1) {
         return;
     }
 
-    // 如果正在进行检测，才进行人脸检测
-    if (detecting) {
-        cv::Mat gray;
-        // 将帧从 BGR 格式转换为灰度图像
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-
-        std::vector<cv::Rect> faces;
-        // 使用人脸检测级联分类器检测图像中的人脸
-        faceCascade.detectMultiScale(gray, faces);
+    for (int camera = 0; camera < cameraViews.size(); ++camera) {
+        PreviewView *view = page == 0 ? (camera == 0 ? videoLabel : nullptr) : cameraViews[camera];
+        if (!view) {
+            continue;
+        }
 
-        // 遍历检测到的人脸区域
-        for (const auto &face : faces) {
-            // 在帧中绘制人脸矩形框
-            cv::rectangle(frame, face, cv::Scalar(255, 0, 0), 2);
+        // 从该摄像头的预览队列取出最新的一帧，没有新帧时跳过
+        FramePacket packet;
+        if (!pipeline->takePreview(camera, packet)) {
+            continue;
+        }
 
-            // 提取人脸区域
-            cv::Mat faceROI = frame(face);
+        // 控件直接绘制队列中的原始帧，人脸框在绘制时叠加，不复制也不修改帧
+        view->setFrame(packet.frame, packet.faces);
 
-            // 如果人脸区域是灰度图像，转换为 BGR 格式以便进行后续处理
-            if (faceROI.channels() == 1) {
-                cv::cvtColor(faceROI, faceROI, cv::COLOR_GRAY2BGR);
+        // 录入期间按间隔保留最近几帧(只保存引用)，停止时从中挑选人脸质量最好的一帧
+        if (isRecording && camera == 0 && packet.captureTime - lastCandidateTime >= kEnrollSampleMs) {
+            lastCandidateTime = packet.captureTime;
+            enrollCandidates.push_back(packet.frame);
+            if (static_cast<int>(enrollCandidates.size()) > kEnrollCandidates) {
+                enrollCandidates.erase(enrollCandidates.begin());
             }
-
-            // 进行面部检测和记录考勤
-            detectAndRecordAttendance(faceROI);
         }
+
+        // 从采集到显示的总延迟
+        Metrics::instance().record(Metrics::EndToEnd, (QDateTime::currentMSecsSinceEpoch() - packet.captureTime) * 1000000);
     }
+}
 
-    // 将 BGR 格式的图像转换为 RGB 格式以便于 Qt 使用
-    cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
-    // 将 OpenCV 的 Mat 图像转换为 QImage
-    QImage img = QImage((const unsigned char*)(frame.data), frame.cols, frame.rows, frame.step, QImage::Format_RGB888);
+void MainWindow::updateMetrics() {
+    const Metrics &metrics = Metrics::instance();
+    const LatencyHistogram &detect = metrics.histogram(Metrics::Detect);
+    const LatencyHistogram &endToEnd = metrics.histogram(Metrics::EndToEnd);
+    const LatencyHistogram &paint = metrics.histogram(Metrics::Paint);
+    metricsLabel->setText(QString("检测 p50/p99: %1/%2 ms  显示 p50/p99: %3/%4 ms  端到端 p50/p99: %5/%6 ms  丢帧: %7  待写入: %8")
+                          .arg(detect.percentileMs(0.5), 0, 'f', 1).arg(detect.percentileMs(0.99), 0, 'f', 1)
+                          .arg(paint.percentileMs(0.5), 0, 'f', 1).arg(paint.percentileMs(0.99), 0, 'f', 1)
+                          .arg(endToEnd.percentileMs(0.5), 0, 'f', 0).arg(endToEnd.percentileMs(0.99), 0, 'f', 0)
+                          .arg(metrics.value(Metrics::FramesDropped))
+                          .arg(metrics.value(Metrics::DbQueueDepth)));
+
+    // 每个摄像头的帧率、采集到分析完成的延迟和丢帧数显示在画面下方
+    cameraFramesSeen.resize(cameraCaptions.size());
+    for (int i = 0; i < cameraCaptions.size(); ++i) {
+        const Metrics::CameraStats &stats = metrics.camera(i);
+        qint64 captured = stats.captured.load(std::memory_order_relaxed);
+        double fps = (captured - cameraFramesSeen[i]) * 1000.0 / kMetricsIntervalMs;
+        cameraFramesSeen[i] = captured;
+        cameraCaptions[i]->setText(QString("摄像头 %1: %2  %3 fps  延迟 p99: %4 ms  丢帧: %5")
+                                   .arg(i).arg(cameraSources.value(i)).arg(fps, 0, 'f', 1)
+                                   .arg(stats.latency.percentileMs(0.99), 0, 'f', 0)
+                                   .arg(stats.dropped.load(std::memory_order_relaxed)));
+    }
 
-    // 更新录入页面的视频标签显示图像
-    videoLabel->setPixmap(QPixmap::fromImage(img));
+    // 批量录入进度显示在按钮上
+    if (bulkEnroller) {
+        bulkEnrollButton->setText(QString("批量录入中 %1/%2").arg(bulkEnroller->progress()).arg(bulkEnroller->total()));
+    }
 
-    // 更新检测页面的视频标签显示图像
-    detectLabel->setPixmap(QPixmap::fromImage(img));
+    // 导出进度显示在按钮上
+    if (exporter) {
+        exportButton->setText(QString("导出中 %1/%2").arg(exporter->progress()).arg(exporter->total()));
+    }
+
+    // 定期导出指标文件供监控程序抓取
+    if (++metricsTicks % kMetricsExportTicks == 0) {
+        metrics.writeFile(kMetricsPath);
+    }
 }
 
 
@@ -339,38 +683,66 @@ void MainWindow::captureFaceAndRecord() {
         // 如果不在录入模式，设置为录入模式并更新按钮文本
         isRecording = true;
         captureButton->setText("停止");
+        enrollCandidates.clear(); // 录入期间由预览定时器采样候选帧
+        lastCandidateTime = 0;
     } else {
         // 如果已经在录入模式，停止录入并更新按钮文本
         isRecording = false;
         captureButton->setText("录入");
 
-        // 捕捉当前帧图像
-        cv::Mat frame;
-        cap >> frame; // 从摄像头捕获一帧图像
+        // 录入期间采样的若干帧，没有时取采集线程最近的一帧
+        std::vector<cv::Mat> candidates;
+        candidates.swap(enrollCandidates);
+        if (candidates.empty() && pipeline) {
+            candidates.push_back(pipeline->latestFrame());
+        }
 
         // 检查图像是否为空
-        if (frame.empty()) {
+        if (std::all_of(candidates.begin(), candidates.end(), [](const cv::Mat &candidate) { return candidate.empty(); })) {
             // 如果图像为空，弹出警告框
             QMessageBox::warning(this, "捕捉错误", "无法捕捉到面部图像");
             return;
         }
 
-        // 将图像转换为灰度图像以进行面部检测
-        cv::Mat gray;
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-        std::vector<cv::Rect> faces;
-        // 使用人脸检测级联分类器检测图像中的人脸
-        faceCascade.detectMultiScale(gray, faces);
+        // 在每一帧上检测人脸并评估质量，取质量合格且得分最高的一帧
+        cv::Mat frame;
+        cv::Rect face;
+        FaceQuality best;
+        FaceQuality rejected;
+        bool anyFace = false;
+        for (const cv::Mat &candidate : candidates) {
+            cv::Rect candidateFace;
+            if (candidate.empty() || !detectEnrollmentFace(candidate, candidateFace)) {
+                continue;
+            }
+            anyFace = true;
+            FaceQuality quality = qualityScorer.evaluate(candidate(candidateFace));
+            if (!quality.acceptable()) {
+                if (quality.score >= rejected.score) {
+                    rejected = quality;
+                }
+                continue;
+            }
+            if (frame.empty() || quality.score > best.score) {
+                frame = candidate;
+                face = candidateFace;
+                best = quality;
+            }
+        }
 
         // 检查是否检测到人脸
-        if (faces.empty()) {
+        if (!anyFace) {
             // 如果没有检测到人脸，弹出警告框
             QMessageBox::warning(this, "面部检测错误", "未检测到面部");
             return;
         }
 
-        // 提取检测到的第一个人脸区域
-        cv::Mat faceROI = frame(faces[0]);
+        // 所有帧的人脸质量都不合格时提示原因，不保存质量差的模板
+        if (frame.empty()) {
+            QMessageBox::warning(this, "面部质量不合格", QString("%1，请调整后重新录入").arg(rejected.reasonText()));
+            return;
+        }
+        cv::Mat faceROI = frame(face);
 
         // 将 BGR 格式的图像转换为 RGB 格式
         cv::Mat faceRGB;
@@ -378,20 +750,66 @@ void MainWindow::captureFaceAndRecord() {
 
         // 生成保存图像的文件名
         QString fileName = QString("D:/code/qt_project/OpenCV_Face/faces/%1.jpg").arg(employeeIDEdit->text());
-        // 将提取的人脸图像保存为文件
-        cv::imwrite(fileName.toStdString(), faceRGB);
-
-        // 插入员工信息到数据库
-        QSqlQuery query;
-        query.prepare("INSERT INTO employees (employee_id, name, department, face_image) VALUES (?, ?, ?, ?)");
+        QString pendingName = QString("D:/code/qt_project/OpenCV_Face/faces/%1.new.jpg").arg(employeeIDEdit->text()); // 提交前先写到临时文件
+        QString backupName = QString("D:/code/qt_project/OpenCV_Face/faces/%1.old.jpg").arg(employeeIDEdit->text()); // 替换期间保存原有图像
+
+        // 插入员工信息到数据库，编号已存在时更新该员工(重新录入)，主键保持不变
+        db.transaction();
+        QSqlQuery query(db);
+        query.prepare("INSERT INTO employees (employee_id, name, department, face_image) VALUES (?, ?, ?, ?) "
+                      "ON CONFLICT(employee_id) DO UPDATE SET name = excluded.name, department = excluded.department, face_image = excluded.face_image");
         query.addBindValue(employeeIDEdit->text()); // 员工编号
         query.addBindValue(employeeNameEdit->text()); // 姓名
         query.addBindValue(departmentEdit->text()); // 部门
         query.addBindValue(fileName); // 人脸图像文件名
-        if (!query.exec()) {
+        bool ok = query.exec();
+        int rowId = 0;
+        if (ok) {
+            // 更新已有员工时 lastInsertId 不可靠，按编号查主键
+            query.prepare("SELECT id FROM employees WHERE employee_id = ?");
+            query.addBindValue(employeeIDEdit->text());
+            ok = query.exec() && query.next();
+            rowId = ok ? query.value(0).toInt() : 0;
+            query.finish();
+        }
+        // 数据库写入成功后才保存人脸图像；在事务提交前替换图像，原有图像先改名保留，
+        // 替换或提交失败时还原并回滚，数据库、图像文件和人脸库始终一致
+        ok = ok && cv::imwrite(pendingName.toStdString(), faceRGB);
+        bool hadImage = QFile::exists(fileName);
+        bool replaced = false;
+        if (ok && hadImage) {
+            QFile::remove(backupName);
+            ok = QFile::rename(fileName, backupName);
+        }
+        if (ok) {
+            replaced = QFile::rename(pendingName, fileName);
+            ok = replaced && db.commit();
+        }
+        if (ok) {
+            QFile::remove(backupName);
+        } else {
+            qDebug() << "Error enrolling employee:" << query.lastError().text() << db.lastError().text();
+            db.rollback();
+            if (replaced) {
+                QFile::remove(fileName);
+            }
+            if (hadImage && !QFile::exists(fileName)) {
+                QFile::rename(backupName, fileName);
+            }
+            QFile::remove(pendingName);
+        }
+        if (!ok) {
             // 如果数据库操作失败，弹出警告框
             QMessageBox::warning(this, "录入错误", "无法录入员工信息");
         } else {
+            // 增量更新内存人脸库
+            EmployeeRecord record;
+            record.employeeId = employeeIDEdit->text();
+            record.name = employeeNameEdit->text();
+            record.department = departmentEdit->text();
+            record.faceImage = fileName;
+            gallery.addEmployee(rowId, record, embedder.extract(faceROI));
+
             // 如果数据库操作成功，弹出信息框
             QMessageBox::information(this, "录入成功", "员工信息已成功录入");
         }
@@ -399,104 +817,174 @@ void MainWindow::captureFaceAndRecord() {
 }
 
 
-void MainWindow::showAttendanceRecords() {
-    // 查询考勤记录
-    QSqlQuery query("SELECT employee_id, name, department, timestamp, face_image FROM attendance");
+bool MainWindow::detectEnrollmentFace(const cv::Mat &frame, cv::Rect &face) {
+    // 在缩小的图像上检测，人脸从原始分辨率的帧中裁剪
+    double scale = detectorConfig.detectionScale > 0.0 && detectorConfig.detectionScale < 1.0 ? detectorConfig.detectionScale : 1.0;
+    cv::Mat small = frame;
+    if (scale < 1.0) {
+        cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+
+    // 将图像转换为灰度图像以进行面部检测
+    cv::Mat gray;
+    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    std::vector<cv::Rect> faces;
+    // 使用人脸检测级联分类器检测图像中的人脸
+    int minSize = cvRound(detectorConfig.minFaceSize * scale);
+    faceCascade.detectMultiScale(gray, faces, detectorConfig.scaleFactor, detectorConfig.minNeighbors, 0, cv::Size(minSize, minSize));
+    if (faces.empty()) {
+        return false;
+    }
 
-    // 执行查询
-    if (!query.exec()) {
-        // 如果查询执行失败，输出错误信息
-        qDebug() << "Error fetching attendance records:" << query.lastError().text();
+    // 取最大的人脸，换算回原始帧坐标
+    cv::Rect largest = *std::max_element(faces.begin(), faces.end(), [](const cv::Rect &a, const cv::Rect &b) { return a.area() < b.area(); });
+    face = cv::Rect(cvRound(largest.x / scale), cvRound(largest.y / scale), cvRound(largest.width / scale), cvRound(largest.height / scale))
+            & cv::Rect(0, 0, frame.cols, frame.rows);
+    return face.area() > 0;
+}
+
+
+void MainWindow::deleteEmployee() {
+    QString employeeID = employeeIDEdit->text();
+    if (employeeID.isEmpty()) {
+        QMessageBox::warning(this, "删除错误", "请输入员工编号");
         return;
     }
 
-    // 用于存储所有考勤记录的字符串
-    QString records;
-    // 遍历查询结果
-    while (query.next()) {
-        // 获取每条记录的各个字段
-        QString employeeID = query.value(0).toString(); // 员工编号
-        QString name = query.value(1).toString(); // 姓名
-        QString department = query.value(2).toString(); // 部门
-        QString timestamp = query.value(3).toString(); // 签到时间
-        QString faceImagePath = query.value(4).toString(); // 人脸图像的完整路径
+    // 确认后再删除
+    if (QMessageBox::question(this, "删除员工", QString("确定删除员工 %1 吗？").arg(employeeID)) != QMessageBox::Yes) {
+        return;
+    }
 
-        // 从完整路径中提取文件名
-        QString faceImageName = QFileInfo(faceImagePath).fileName();
+    QSqlQuery query;
+    query.prepare("DELETE FROM employees WHERE employee_id = ?");
+    query.addBindValue(employeeID);
+    if (!query.exec() || query.numRowsAffected() == 0) {
+        QMessageBox::warning(this, "删除错误", "未找到该员工");
+        return;
+    }
 
-        // 将记录格式化为字符串并添加到记录列表中
-        records += QString("部门: %1\n员工编号: %2\n姓名: %3\n签到时间: %4\n人脸图像: %5\n\n")
-                       .arg(department).arg(employeeID).arg(name).arg(timestamp).arg(faceImageName);
+    // 增量更新内存人脸库
+    gallery.removeEmployee(employeeID);
+    QMessageBox::information(this, "删除成功", "员工信息已删除");
+}
+
+
+void MainWindow::bulkEnroll() {
+    if (bulkEnroller) {
+        return; // 上一次批量录入还没有结束
     }
 
-    // 弹出信息框显示所有考勤记录
-    QMessageBox::information(this, "Attendance Records", records);
+    QString photoDir = QFileDialog::getExistingDirectory(this, "选择照片目录");
+    if (photoDir.isEmpty()) {
+        return;
+    }
+    QString csvPath = QFileDialog::getOpenFileName(this, "选择员工名单", photoDir, "员工名单 (*.csv *.txt)");
+    if (csvPath.isEmpty()) {
+        return;
+    }
+
+    BulkEnrollConfig config;
+    config.photoDir = photoDir;
+    config.csvPath = csvPath;
+    config.faceDir = "D:/code/qt_project/OpenCV_Face/faces";
+    config.embeddingModelPath = embeddingModelPath;
+    config.detectorConfig = detectorConfig;
+    config.threadCount = qMax(1, BulkEnroller::defaultThreadCount() - 1); // 留一个核心给界面和识别线程
+
+    // 读名单和写数据库使用界面线程的连接，只有特征提取放到后台线程
+    bulkEnroller = new BulkEnroller(config);
+    if (!bulkEnroller->load(db)) {
+        QMessageBox::warning(this, "批量录入错误", bulkEnroller->errorString());
+        delete bulkEnroller;
+        bulkEnroller = nullptr;
+        return;
+    }
+
+    BulkEnroller *enroller = bulkEnroller;
+    bulkEnrollThread = QThread::create([enroller]() { enroller->extract(); });
+    connect(bulkEnrollThread, &QThread::finished, this, &MainWindow::onBulkEnrollFinished);
+    bulkEnrollButton->setEnabled(false);
+    bulkEnrollThread->start();
 }
 
-void MainWindow::detectAndRecordAttendance(const cv::Mat &faceROI) {
-    static QDateTime lastAttendanceTime; // 记录上次签到时间
-    double maxSimilarity = 0.5; // 设置一个适当的相似度阈值
-    QString matchedEmployeeID = "unknown"; // 匹配到的员工编号
-    QString matchedEmployeeName = "unknown"; // 匹配到的员工姓名
-    QString matchedDepartment = "unknown"; // 匹配到的员工部门
-    QString matchedFaceImage; // 匹配到的员工人脸图像路径
-
-    // 遍历数据库中所有员工的人脸图像
-    QSqlQuery query("SELECT employee_id, name, department, face_image FROM employees");
-    while (query.next()) {
-        QString employeeID = query.value(0).toString(); // 员工编号
-        QString employeeName = query.value(1).toString(); // 员工姓名
-        QString department = query.value(2).toString(); // 员工部门
-        QString faceImagePath = query.value(3).toString(); // 员工人脸图像路径
-
-        // 从文件中加载保存的人脸图像
-        cv::Mat savedFace = cv::imread(faceImagePath.toStdString());
-        if (savedFace.empty()) {
-            continue; // 如果无法加载图像，则跳过
-        }
+void MainWindow::onBulkEnrollFinished() {
+    bulkEnrollThread->deleteLater();
+    bulkEnrollThread = nullptr;
 
-        // 比较当前人脸图像与保存的人脸图像
-        double similarity = calculateSimilarity(faceROI, savedFace);
-        if (similarity < maxSimilarity) { // 如果相似度小于阈值，则更新匹配记录
-            maxSimilarity = similarity;
-            matchedEmployeeID = employeeID;
-            matchedEmployeeName = employeeName;
-            matchedDepartment = department;
-            matchedFaceImage = faceImagePath;
-        }
+    bool ok = bulkEnroller->commit(db, &gallery);
+    if (ok) {
+        gallery.saveTemplates(); // 批量录入的特征立即写入模板文件，异常退出也不必重新提取
     }
+    BulkEnrollReport report = bulkEnroller->report();
+    QString error = bulkEnroller->errorString();
+    delete bulkEnroller;
+    bulkEnroller = nullptr;
+    bulkEnrollButton->setText("批量录入");
+    bulkEnrollButton->setEnabled(true);
+
+    if (!ok) {
+        QMessageBox::warning(this, "批量录入错误", error);
+        return;
+    }
+    qDebug().noquote() << report.toString();
+
+    // 失败原因较多时只显示前几条，完整报告输出到调试日志
+    QString text = QString("共 %1 人，成功录入 %2 人\n编号重复 %3，缺少照片 %4，未检测到人脸 %5，多张人脸 %6，质量不合格 %7，其他错误 %8\n耗时 %9 秒")
+                       .arg(report.rows).arg(report.enrolled)
+                       .arg(report.duplicateId).arg(report.missingPhoto).arg(report.noFace).arg(report.multipleFaces).arg(report.lowQuality)
+                       .arg(report.otherFailed + report.databaseFailed)
+                       .arg((report.extractMs + report.commitMs) / 1000.0, 0, 'f', 1);
+    if (!report.failures.isEmpty()) {
+        text += "\n\n" + report.failures.mid(0, 10).join("\n");
+    }
+    QMessageBox::information(this, "批量录入完成", text);
+}
 
-    // 检查匹配的员工是否在最近已经签到
-    if (maxSimilarity < 0.5) { // 如果相似度小于阈值，则记录签到信息
-        QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
 
-        // 防止频繁重复签到
-        if (lastAttendanceTime.isValid() && lastAttendanceTime.secsTo(QDateTime::currentDateTime()) < 60) {
-            return; // 如果上次签到时间距离现在小于60秒，则忽略
-        }
+void MainWindow::showAttendanceRecords() {
+    // 切换到考勤记录页面并重新加载第一页
+    tabWidget->setCurrentIndex(2);
+    updateRecordTable();
+}
 
-        // 将签到记录插入到数据库中
-        QSqlQuery query;
-        query.prepare("INSERT INTO attendance (employee_id, name, department, timestamp, face_image) VALUES (?, ?, ?, ?, ?)");
-        query.addBindValue(matchedEmployeeID);
-        query.addBindValue(matchedEmployeeName);
-        query.addBindValue(matchedDepartment);
-        query.addBindValue(timestamp);
-        query.addBindValue(matchedFaceImage);
-        if (!query.exec()) {
-            qDebug() << "Error recording attendance:" << query.lastError().text(); // 记录签到信息出错
+void MainWindow::drainNotifications() {
+    // 识别结果只通过无锁队列传给界面线程，提示不需要点击确认，签到不会因为界面而停顿
+    Notification notification;
+    while (notifications.pop(notification)) {
+        if (notification.kind == Notification::CheckedIn) {
+            const EmployeeRecord &employee = notification.employee;
+            toast->post("employee:" + employee.employeeId, ToastOverlay::Success, "签到成功",
+                        QString("%1  %2  %3  %4").arg(employee.name).arg(employee.employeeId).arg(employee.department).arg(notification.timestamp));
         } else {
-            lastAttendanceTime = QDateTime::currentDateTime(); // 更新上次签到时间
-            QMessageBox::information(this, "签到成功", QString("部门: %1\n员工编号: %2\n姓名: %3\n签到时间: %4\n人脸图像: %5")
-                                     .arg(matchedDepartment).arg(matchedEmployeeID).arg(matchedEmployeeName).arg(timestamp).arg(matchedFaceImage));
+            // 同一条轨迹的多次识别失败合并为一条提示
+            toast->post(QString("track:%1:%2").arg(notification.cameraId).arg(notification.trackId), ToastOverlay::Warning, "识别失败",
+                        QString("摄像头 %1 未能识别员工面部").arg(notification.cameraId));
         }
-    } else {
-        QMessageBox::warning(this, "识别失败", "未能识别员工面部"); // 如果识别失败，则显示警告信息
     }
 }
 
+void MainWindow::onDetectorChanged(int index) {
+    detectorConfig.backend = static_cast<DetectorConfig::Backend>(detectorCombo->itemData(index).toInt());
+    if (pipeline) {
+        pipeline->setDetectorConfig(detectorConfig); // 识别线程在下一帧切换检测器
+    }
+}
 
+void MainWindow::onDetectorStats(const QString &backend, double averageMs, qint64 frames) {
+    // 显示当前后端的平均检测耗时，便于比较不同后端的速度
+    detectorStatsLabel->setText(QString("%1 检测: %2 ms/帧 (%3 帧)").arg(backend).arg(averageMs, 0, 'f', 1).arg(frames));
+}
 
+void MainWindow::onDetectorFailed() {
+    // 每个识别线程都会报告一次，只处理第一次
+    if (!isDetecting) {
+        return;
+    }
+    stopDetection();
+    detectorStatsLabel->setText("检测器加载失败");
+    toast->post("detector", ToastOverlay::Warning, "检测错误", "无法加载人脸检测器，检测已停止");
+}
 
 void MainWindow::onTabChanged(int index) {
     // 检查当前选中的标签页索引
@@ -504,89 +992,87 @@ void MainWindow::onTabChanged(int index) {
         isOnRecordPage = false; // 设置标志位，表示当前不在“录入”页面
     } else if (index == 0) { // 如果选中的是“人脸录入”页面
         isOnRecordPage = true; // 设置标志位，表示当前在“录入”页面
+    } else if (index == 2) { // 如果选中的是“考勤记录”页面
+        updateRecordTable(); // 只加载最新的一页
+    } else if (index == 3) { // 如果选中的是“考勤统计”页面
+        dashboard->refresh(); // 只查询汇总表
     }
 }
 
 
-double MainWindow::calculateSimilarity(const cv::Mat &face1, const cv::Mat &face2) {
-    cv::Mat resizedFace1, resizedFace2;
-
-    // 确保两个图像大小和通道数相同
-    if (face1.size() != face2.size() || face1.channels() != face2.channels()) {
-        // 如果图像大小或通道数不同，调整 face2 的大小以匹配 face1
-        cv::resize(face2, resizedFace2, face1.size());
-        resizedFace1 = face1;
-    } else {
-        resizedFace1 = face1;
-        resizedFace2 = face2;
-    }
-
-    // 如果图像是彩色图像，则转换为灰度图像
-    if (resizedFace1.channels() == 3) {
-        cv::cvtColor(resizedFace1, resizedFace1, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(resizedFace2, resizedFace2, cv::COLOR_BGR2GRAY);
-    }
-
-    // 计算直方图
-    cv::Mat hist1, hist2;
-    int histSize[1] = {256}; // 直方图的大小（256个灰度级）
-    float range[] = {0, 256}; // 直方图的范围
-    const float* histRange[] = {range};
-
-    // 计算第一个图像的直方图
-    cv::calcHist(&resizedFace1, 1, 0, cv::Mat(), hist1, 1, histSize, histRange);
-    cv::normalize(hist1, hist1, 1, 0, cv::NORM_L1); // 归一化直方图
-
-    // 计算第二个图像的直方图
-    cv::calcHist(&resizedFace2, 1, 0, cv::Mat(), hist2, 1, histSize, histRange);
-    cv::normalize(hist2, hist2, 1, 0, cv::NORM_L1); // 归一化直方图
-
-    // 使用巴氏距离（Bhattacharyya distance）比较两个直方图
-    return cv::compareHist(hist1, hist2, cv::HISTCMP_BHATTACHARYYA);
-}
-
 void MainWindow::startDetection() {
-    detecting = true; // 设置检测标志为真，表示开始检测
+    pipeline->startAnalysis(); // 启动检测/识别线程
+    isDetecting = true;
     startDetectButton->setEnabled(false); // 禁用“开始检测”按钮
     stopDetectButton->setEnabled(true); // 启用“停止检测”按钮
 }
 
 void MainWindow::stopDetection() {
-    detecting = false; // 设置检测标志为假，表示停止检测
-    startDetectButton->setEnabled(true); // 启用“开始检测”按钮
+    pipeline->stopAnalysis(); // 停止检测/识别线程
+    isDetecting = false;
+    startDetectButton->setEnabled(startup->succeeded("gallery")); // 人脸库可用时启用“开始检测”按钮
     stopDetectButton->setEnabled(false); // 禁用“停止检测”按钮
 }
 
 void MainWindow::updateRecordTable() {
-    // 查找表格控件
-    QTableWidget *recordTable = findChild<QTableWidget *>("recordTable");
-    if (!recordTable) {
-        qDebug() << "Error: recordTable not found!"; // 如果未找到表格控件，则输出错误信息
+    if (!attendanceModel) {
         return;
     }
 
-    // 查询考勤记录
-    QSqlQuery query("SELECT employee_id, name, department, timestamp, face_image FROM attendance");
+    // 按界面上的筛选条件重新查询，只加载第一页
+    attendanceModel->setFilter(recordFilter());
+}
 
-    if (!query.exec()) {
-        qDebug() << "Error fetching attendance records:" << query.lastError().text(); // 如果查询失败，则输出错误信息
-        return;
+AttendanceFilter MainWindow::recordFilter() const {
+    AttendanceFilter filter;
+    if (dateFilterCheck->isChecked()) {
+        filter.from = QDateTime(fromDateEdit->date(), QTime(0, 0, 0));
+        filter.to = QDateTime(toDateEdit->date(), QTime(23, 59, 59));
     }
+    filter.department = departmentFilterEdit->text().trimmed();
+    filter.employeeId = employeeFilterEdit->text().trimmed();
+    return filter;
+}
 
-    // 清空表格
-    recordTable->setRowCount(0);
+void MainWindow::exportAttendance() {
+    if (exporter) {
+        return; // 上一次导出还没有结束
+    }
 
-    int row = 0;
-    // 遍历查询结果
-    while (query.next()) {
-        recordTable->insertRow(row); // 插入新行
-        recordTable->setItem(row, 0, new QTableWidgetItem(query.value(0).toString())); // 设置员工编号
-        recordTable->setItem(row, 1, new QTableWidgetItem(query.value(1).toString())); // 设置姓名
-        recordTable->setItem(row, 2, new QTableWidgetItem(query.value(2).toString())); // 设置部门
-        recordTable->setItem(row, 3, new QTableWidgetItem(query.value(3).toString())); // 设置签到时间
-        recordTable->setItem(row, 4, new QTableWidgetItem(query.value(4).toString())); // 设置人脸图像的名称或路径
-        row++;
+    QString path = QFileDialog::getSaveFileName(this, "导出考勤记录", "attendance.csv", "CSV 文件 (*.csv);;列式文件 (*.fatc)");
+    if (path.isEmpty()) {
+        return;
     }
+
+    ExportConfig config;
+    config.databasePath = db.databaseName();
+    config.outputPath = path;
+    config.format = ExportConfig::formatForPath(path);
+    config.filter = recordFilter();
+
+    exporter = new AttendanceExporter(config);
+    AttendanceExporter *job = exporter;
+    exportThread = QThread::create([job]() { job->run(); });
+    connect(exportThread, &QThread::finished, this, &MainWindow::onExportFinished);
+    exportButton->setEnabled(false);
+    exportThread->start();
 }
 
+void MainWindow::onExportFinished() {
+    exportThread->deleteLater();
+    exportThread = nullptr;
 
+    ExportReport report = exporter->report();
+    QString error = exporter->errorString();
+    delete exporter;
+    exporter = nullptr;
+    exportButton->setText("导出");
+    exportButton->setEnabled(true);
+
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, "导出错误", error);
+        return;
+    }
+    QMessageBox::information(this, "导出完成", QString("共导出 %1 条记录，%2 KB，耗时 %3 秒")
+                             .arg(report.rows).arg(report.bytes / 1024).arg(report.elapsedMs / 1000.0, 0, 'f', 1));
+}
@@ -3,6 +3,7 @@
 
 #include <QMainWindow>
 #include <QTimer>
+#include <QThread>
 #include <QLabel>
 #include <QPushButton>
 #include <QLineEdit>
@@ -12,10 +13,31 @@
 #include <QSqlError>
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
-#include <QTableWidget>
+#include <QTableView>
+#include <QCheckBox>
+#include <QDateEdit>
 #include <QFormLayout>
 #include <QWidget>
 #include <QVBoxLayout>
+#include <QComboBox>
+#include <QProgressBar>
+#include <QStringList>
+#include <QVector>
+#include "attendanceexporter.h"
+#include "attendancemodel.h"
+#include "attendancewriter.h"
+#include "bulkenroller.h"
+#include "dashboardview.h"
+#include "facedetector.h"
+#include "faceembedder.h"
+#include "facegallery.h"
+#include "facequality.h"
+#include "framepipeline.h"
+#include "httpserver.h"
+#include "notification.h"
+#include "previewview.h"
+#include "startupsequence.h"
+#include "toastoverlay.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -30,30 +52,59 @@ public:
     ~MainWindow();
 
 private slots:
-    void processFrameAndUpdateGUI();//处理摄像头帧并更新GUI
+    void processFrameAndUpdateGUI();//从预览队列取出最新帧并更新当前可见页面的画面，只负责绘制
     void captureFaceAndRecord();// 捕捉人脸并记录员工信息
+    void deleteEmployee();// 删除员工信息并从人脸库中移除
+    void bulkEnroll();//选择照片目录和员工名单 在后台线程中批量录入
+    void onBulkEnrollFinished();//批量录入的特征提取完成后写入数据库并显示报告
     void showAttendanceRecords();//显示考勤记录
     void startDetection();//开始人脸检测
     void stopDetection();//停止人脸检测
     void onTabChanged(int index);//当选项卡切换时的处理函数 index为当前选项卡的索引
-    void updateRecordTable();
+    void updateRecordTable();//按筛选条件重新加载考勤记录表
+    void exportAttendance();//按筛选条件在后台线程中导出考勤记录(CSV或列式格式)
+    void onExportFinished();//导出结束后显示结果
+    void onDetectorChanged(int index);//切换人脸检测后端 index为下拉框选中的索引
+    void onDetectorStats(const QString &backend, double averageMs, qint64 frames);//在状态栏显示检测耗时
+    void onDetectorFailed();//识别线程无法创建检测器时停止检测并恢复按钮
+    void updateMetrics();//在状态栏显示各阶段耗时分位数 并定期导出指标文件
+    void onStartupPhaseFinished(const QString &phase, bool ok);//一个启动阶段完成 依赖已就绪的功能随之启用
+    void onStartupFinished();//所有启动阶段完成 输出各阶段耗时
 
 private:
     void initializeDatabase();//初始化SQLite数据库
     void initializeDirectories();//初始化所需目录
     void setupUI();// 设置用户界面
-    void initializeDNN();//初始化深度神经网络(DNN)模型
-    void detectAndRecordAttendance(const cv::Mat &faceROI);//检测并记录考勤信息   faceROI为传入的人脸区域图像
-    double calculateSimilarity(const cv::Mat &face1, const cv::Mat &face2);//计算两张人脸图像的相似度 face1，2为第一，二张人脸图像 返回相似度分数
+    void initializeDNN();//初始化深度神经网络(DNN)检测器配置和人脸特征提取模型路径 模型在后台加载
+    bool loadGallery();//在后台线程中用自己的数据库连接加载人脸库
+    bool archiveAttendance();//在后台线程中用自己的数据库连接归档保留期之前的考勤分区
+    QStringList loadCameraSources();//读取视频源列表(cameras.txt)
+    void drainNotifications();//取出通知队列中的识别结果 显示为非模态提示
+    bool detectEnrollmentFace(const cv::Mat &frame, cv::Rect &face);//在录入帧中检测最大的人脸 返回原始帧坐标
+    AttendanceFilter recordFilter() const;//考勤记录页面上的筛选条件
 
     Ui::MainWindow *ui;
-    cv::VideoCapture cap;//视频捕获对象，用于从摄像头获取视频帧
+    FramePipeline *pipeline;//采集/检测/识别流水线，在后台线程中运行
+    AttendanceWriter *attendanceWriter;//考勤写入线程，使用独立的数据库连接批量写入
+    HttpServer *httpServer;//HTTP 接口线程，供门禁和薪资系统查询和提交识别 人脸库加载后启动
+    StartupSequence *startup;//分阶段启动 后台加载模型、分类器和人脸库
+    QProgressBar *startupProgress;//QProgressBar对象，用于在状态栏显示启动进度
     cv::CascadeClassifier faceCascade;//人脸检测分类器对象，用于检测图像中的人脸
-    cv::dnn::Net net;//深度神经网络对象，用于人脸识别
+    DetectorConfig detectorConfig;//人脸检测器配置(Haar/SSD)，由识别线程创建检测器
     QSqlDatabase db;//SQLite数据库对象，用于存储员工信息和考勤记录
-    QTimer *timer;//定时器对象，用于定时获取视频帧
-    QLabel *videoLabel;//QLabel对象，用于显示视频流
-    QLabel *detectLabel;//QLabel对象，用于显示检测状态信息
+    FaceGallery gallery;//内存人脸库，启动时加载一次，录入时增量更新
+    FaceQualityScorer qualityScorer;//人脸质量评估，录入时挑选最好的一帧
+    std::vector<cv::Mat> enrollCandidates;//录入期间采样的候选帧
+    qint64 lastCandidateTime;//上一个候选帧的采集时间(毫秒)
+    FaceEmbedder embedder;//人脸特征提取器，界面线程录入时使用(识别线程有自己的实例)
+    QString embeddingModelPath;//人脸特征提取模型路径
+    QTimer *timer;//定时器对象，用于定时从预览队列取帧绘制
+    PreviewView *videoLabel;//PreviewView对象，用于在录入页面显示视频流
+    PreviewView *detectLabel;//PreviewView对象，检测页面中0号摄像头的画面
+    QStringList cameraSources;//各摄像头的视频源
+    QVector<PreviewView *> cameraViews;//检测页面中各摄像头的画面
+    QVector<QLabel *> cameraCaptions;//各摄像头画面下方的统计信息
+    QVector<qint64> cameraFramesSeen;//上次刷新时各摄像头已采集的帧数，用于计算帧率
     QLabel *detectIDLabel;//QLabel对象，用于显示检测到的员工编号
     QLabel *detectNameLabel;//QLabel对象，用于显示检测到的员工姓名
     QLabel *detectDepartmentLabel;//QLabel对象，用于显示检测到的员工部门
@@ -62,16 +113,36 @@ private:
     QLineEdit *employeeNameEdit;//QLineEdit对象，用于输入员工姓名
     QLineEdit *departmentEdit;//QLineEdit对象，用于输入员工部门
     QPushButton *captureButton;//QPushButton对象，用于触发捕捉人脸并记录员工信息的功能
+    QPushButton *deleteButton;//QPushButton对象，用于删除员工信息
+    QPushButton *bulkEnrollButton;//QPushButton对象，用于从照片目录批量录入员工
+    BulkEnroller *bulkEnroller;//正在进行的批量录入 没有时为nullptr
+    QThread *bulkEnrollThread;//批量录入的特征提取线程
     QPushButton *startDetectButton;//QPushButton对象，用于触发开始人脸检测功能
     QPushButton *stopDetectButton;// QPushButton对象，用于触发停止人脸检测功能
+    QComboBox *detectorCombo;//QComboBox对象，用于选择人脸检测后端
+    QLabel *detectorStatsLabel;//QLabel对象，用于在状态栏显示检测耗时
+    QLabel *metricsLabel;//QLabel对象，用于在状态栏显示各阶段耗时分位数
+    NotificationQueue notifications;//识别线程和考勤写入线程发布的通知
+    ToastOverlay *toast;//非模态提示层，显示签到成功和未能识别
+    QTimer *metricsTimer;//定时器对象，用于定时刷新指标并导出指标文件
+    int metricsTicks;//指标刷新次数
     QTabWidget *tabWidget;//QTabWidget对象，用于管理不同功能的选项卡界面
-    QTableWidget *recordTable;//QTableWidget对象，用于显示考勤记录表
+    QTableView *recordTable;//QTableView对象，用于分页显示考勤记录表
+    AttendanceTableModel *attendanceModel;//考勤记录表模型，按需分页加载
+    QCheckBox *dateFilterCheck;//QCheckBox对象，是否按日期范围筛选
+    QDateEdit *fromDateEdit;//QDateEdit对象，筛选起始日期
+    QDateEdit *toDateEdit;//QDateEdit对象，筛选结束日期
+    QLineEdit *departmentFilterEdit;//QLineEdit对象，按部门筛选
+    QLineEdit *employeeFilterEdit;//QLineEdit对象，按员工编号筛选
+    QPushButton *exportButton;//QPushButton对象，用于导出考勤记录
+    AttendanceExporter *exporter;//正在进行的导出 没有时为nullptr
+    QThread *exportThread;//导出线程
+    DashboardView *dashboard;//考勤统计页面，只读考勤汇总表
     QWidget *videoContainer;//QWidget对象，用于容纳视频显示组件
     QVBoxLayout *buttonLayout;//QVBoxLayout对象，用于布局按钮
     bool isRecording;//标志变量，指示是否正在录入员工信息
     bool isOnRecordPage;// 标志变量，指示当前是否在录入页面
     bool isDetecting;//标志变量，指示当前是否正在进行人脸检测
-    bool detecting;//标志变量，指示是否正在进行检测
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,290 @@
+#include "metrics.h"
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QtAlgorithms>
+#include <QDebug>
+
+namespace {
+const double kQuantiles[] = {0.5, 0.9, 0.99}; // 导出的分位数
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketOf(quint64 micros) {
+    const quint64 sub = 1u << kSubBits;
+    if (micros < sub) {
+        return static_cast<int>(micros);
+    }
+    // 最高位决定所在的2的幂，其后 kSubBits 位决定子桶
+    int msb = 63 - qCountLeadingZeroBits(micros);
+    int bucket = (msb - kSubBits + 1) * static_cast<int>(sub) + static_cast<int>((micros >> (msb - kSubBits)) & (sub - 1));
+    return qMin(bucket, kBuckets - 1);
+}
+
+double LatencyHistogram::bucketUpperMs(int bucket) {
+    const int sub = 1 << kSubBits;
+    if (bucket < sub) {
+        return (bucket + 1) / 1000.0;
+    }
+    int msb = bucket / sub + kSubBits - 1;
+    quint64 upper = static_cast<quint64>(sub + bucket % sub + 1) << (msb - kSubBits);
+    return upper / 1000.0;
+}
+
+void LatencyHistogram::record(qint64 nanoseconds) {
+    quint64 ns = nanoseconds > 0 ? static_cast<quint64>(nanoseconds) : 0;
+    buckets[bucketOf(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sumNanos.fetch_add(ns, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::percentileMs(double p) const {
+    quint64 n = total.load(std::memory_order_relaxed);
+    if (n == 0) {
+        return 0.0;
+    }
+    // 返回累计计数首次达到 p*n 的桶的上界
+    quint64 target = qMax<quint64>(1, static_cast<quint64>(p * n + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return bucketUpperMs(i);
+        }
+    }
+    return bucketUpperMs(kBuckets - 1);
+}
+
+qint64 LatencyHistogram::count() const {
+    return static_cast<qint64>(total.load(std::memory_order_relaxed));
+}
+
+double LatencyHistogram::sumMs() const {
+    return sumNanos.load(std::memory_order_relaxed) / 1e6;
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < kBuckets; ++i) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sumNanos.store(0, std::memory_order_relaxed);
+}
+
+Metrics::Metrics() {
+    for (int i = 0; i < CounterCount; ++i) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < GaugeCount; ++i) {
+        gauges[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kMaxCameras; ++i) {
+        cameras[i].captured.store(0, std::memory_order_relaxed);
+        cameras[i].dropped.store(0, std::memory_order_relaxed);
+        cameras[i].analyzed.store(0, std::memory_order_relaxed);
+    }
+}
+
+Metrics &Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::record(Stage stage, qint64 nanoseconds) {
+    stages[stage].record(nanoseconds);
+}
+
+void Metrics::add(Counter counter, qint64 delta) {
+    counters[counter].fetch_add(delta, std::memory_order_relaxed);
+}
+
+void Metrics::set(Gauge gauge, qint64 value) {
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+Metrics::CameraStats &Metrics::camera(int cameraId) {
+    return cameras[qBound(0, cameraId, kMaxCameras - 1)];
+}
+
+const Metrics::CameraStats &Metrics::camera(int cameraId) const {
+    return cameras[qBound(0, cameraId, kMaxCameras - 1)];
+}
+
+const LatencyHistogram &Metrics::histogram(Stage stage) const {
+    return stages[stage];
+}
+
+qint64 Metrics::value(Counter counter) const {
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+qint64 Metrics::value(Gauge gauge) const {
+    return gauges[gauge].load(std::memory_order_relaxed);
+}
+
+void Metrics::reset() {
+    for (int i = 0; i < StageCount; ++i) {
+        stages[i].reset();
+    }
+    for (int i = 0; i < CounterCount; ++i) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < GaugeCount; ++i) {
+        gauges[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kMaxCameras; ++i) {
+        cameras[i].captured.store(0, std::memory_order_relaxed);
+        cameras[i].dropped.store(0, std::memory_order_relaxed);
+        cameras[i].analyzed.store(0, std::memory_order_relaxed);
+        cameras[i].latency.reset();
+    }
+}
+
+const char *Metrics::stageName(Stage stage) {
+    static const char *names[StageCount] = {
+        "capture", "motion", "convert", "detect", "track", "quality", "embed", "match", "db_commit", "preview", "paint", "end_to_end",
+        "http_request"
+    };
+    return names[stage];
+}
+
+const char *Metrics::counterName(Counter counter) {
+    static const char *names[CounterCount] = {
+        "frames_captured", "frames_dropped", "frames_idle", "faces_detected", "recognitions",
+        "matches", "unrecognized", "quality_rejected", "attendance_written", "attendance_failed",
+        "notifications_dropped", "http_requests", "http_rejected"
+    };
+    return names[counter];
+}
+
+const char *Metrics::gaugeName(Gauge gauge) {
+    static const char *names[GaugeCount] = {"db_queue_depth"};
+    return names[gauge];
+}
+
+QString Metrics::toPrometheus() const {
+    QString text;
+    QTextStream out(&text);
+    // 阶段耗时以 summary 形式导出(秒)
+    out << "# HELP attendance_stage_latency_seconds Per-stage latency.\n";
+    out << "# TYPE attendance_stage_latency_seconds summary\n";
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram &h = stages[i];
+        const char *name = stageName(static_cast<Stage>(i));
+        for (double q : kQuantiles) {
+            out << "attendance_stage_latency_seconds{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << h.percentileMs(q) / 1000.0 << "\n";
+        }
+        out << "attendance_stage_latency_seconds_sum{stage=\"" << name << "\"} " << h.sumMs() / 1000.0 << "\n";
+        out << "attendance_stage_latency_seconds_count{stage=\"" << name << "\"} " << h.count() << "\n";
+    }
+    for (int i = 0; i < CounterCount; ++i) {
+        QString name = QString("attendance_%1_total").arg(counterName(static_cast<Counter>(i)));
+        out << "# TYPE " << name << " counter\n";
+        out << name << " " << value(static_cast<Counter>(i)) << "\n";
+    }
+    for (int i = 0; i < GaugeCount; ++i) {
+        QString name = QString("attendance_%1").arg(gaugeName(static_cast<Gauge>(i)));
+        out << "# TYPE " << name << " gauge\n";
+        out << name << " " << value(static_cast<Gauge>(i)) << "\n";
+    }
+    // 只导出有数据的摄像头
+    out << "# TYPE attendance_camera_frames_total counter\n";
+    for (int i = 0; i < kMaxCameras; ++i) {
+        const CameraStats &stats = cameras[i];
+        qint64 captured = stats.captured.load(std::memory_order_relaxed);
+        if (captured == 0) {
+            continue;
+        }
+        out << "attendance_camera_frames_total{camera=\"" << i << "\",state=\"captured\"} " << captured << "\n";
+        out << "attendance_camera_frames_total{camera=\"" << i << "\",state=\"dropped\"} " << stats.dropped.load(std::memory_order_relaxed) << "\n";
+        out << "attendance_camera_frames_total{camera=\"" << i << "\",state=\"analyzed\"} " << stats.analyzed.load(std::memory_order_relaxed) << "\n";
+    }
+    out << "# TYPE attendance_camera_latency_seconds summary\n";
+    for (int i = 0; i < kMaxCameras; ++i) {
+        const LatencyHistogram &h = cameras[i].latency;
+        if (h.count() == 0) {
+            continue;
+        }
+        for (double q : kQuantiles) {
+            out << "attendance_camera_latency_seconds{camera=\"" << i << "\",quantile=\"" << q << "\"} "
+                << h.percentileMs(q) / 1000.0 << "\n";
+        }
+        out << "attendance_camera_latency_seconds_sum{camera=\"" << i << "\"} " << h.sumMs() / 1000.0 << "\n";
+        out << "attendance_camera_latency_seconds_count{camera=\"" << i << "\"} " << h.count() << "\n";
+    }
+    return text;
+}
+
+QString Metrics::toJson() const {
+    QJsonObject stageObject;
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram &h = stages[i];
+        QJsonObject entry;
+        entry["count"] = h.count();
+        entry["sum_ms"] = h.sumMs();
+        entry["p50_ms"] = h.percentileMs(0.5);
+        entry["p90_ms"] = h.percentileMs(0.9);
+        entry["p99_ms"] = h.percentileMs(0.99);
+        stageObject[stageName(static_cast<Stage>(i))] = entry;
+    }
+    QJsonObject counterObject;
+    for (int i = 0; i < CounterCount; ++i) {
+        counterObject[counterName(static_cast<Counter>(i))] = value(static_cast<Counter>(i));
+    }
+    QJsonObject gaugeObject;
+    for (int i = 0; i < GaugeCount; ++i) {
+        gaugeObject[gaugeName(static_cast<Gauge>(i))] = value(static_cast<Gauge>(i));
+    }
+
+    QJsonObject cameraObject;
+    for (int i = 0; i < kMaxCameras; ++i) {
+        const CameraStats &stats = cameras[i];
+        if (stats.captured.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        QJsonObject entry;
+        entry["captured"] = stats.captured.load(std::memory_order_relaxed);
+        entry["dropped"] = stats.dropped.load(std::memory_order_relaxed);
+        entry["analyzed"] = stats.analyzed.load(std::memory_order_relaxed);
+        entry["p50_ms"] = stats.latency.percentileMs(0.5);
+        entry["p99_ms"] = stats.latency.percentileMs(0.99);
+        cameraObject[QString::number(i)] = entry;
+    }
+
+    QJsonObject root;
+    root["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+    root["stages"] = stageObject;
+    root["counters"] = counterObject;
+    root["gauges"] = gaugeObject;
+    root["cameras"] = cameraObject;
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+bool Metrics::writeFile(const QString &path) const {
+    // 先写临时文件再替换，监控程序不会读到写了一半的文件
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "Error writing metrics file:" << path;
+        return false;
+    }
+    QString text = path.endsWith(".json", Qt::CaseInsensitive) ? toJson() : toPrometheus();
+    file.write(text.toUtf8());
+    return file.commit();
+}
+
+ScopedTimer::ScopedTimer(Metrics::Stage stage)
+    : stage(stage)
+    , start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedTimer::~ScopedTimer() {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Metrics::instance().record(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
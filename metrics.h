@@ -0,0 +1,129 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+// 延迟直方图：按对数分桶(每个2的幂再分8个子桶，相对误差不超过12.5%)，只用原子计数，任意线程无锁记录
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 nanoseconds);//记录一次耗时
+    double percentileMs(double p) const;//分位数(毫秒) p取0~1
+    qint64 count() const;//记录次数
+    double sumMs() const;//耗时总和(毫秒)
+    void reset();//清空
+
+    static const int kSubBits = 3;//每个2的幂分成 2^kSubBits 个子桶
+    static const int kBuckets = 240;//桶数 覆盖1微秒到约35分钟
+
+private:
+    static int bucketOf(quint64 micros);//微秒值所在的桶
+    static double bucketUpperMs(int bucket);//桶的上界(毫秒)
+
+    std::atomic<quint64> buckets[kBuckets];//各桶计数
+    std::atomic<quint64> total;//记录次数
+    std::atomic<quint64> sumNanos;//耗时总和(纳秒)
+};
+
+// 全局性能指标：各阶段耗时直方图、计数器和瞬时值
+// 热路径上只做原子加法；界面线程定时读取显示在状态栏，并导出为监控程序可抓取的文本文件
+class Metrics
+{
+public:
+    enum Stage {
+        Capture,//读取摄像头帧
+        Motion,//缩小帧上的运动检测
+        Convert,//BGR转灰度
+        Detect,//全帧人脸检测
+        Track,//两次检测之间的模板匹配跟踪
+        Quality,//人脸质量评估
+        Embed,//人脸特征提取
+        Match,//人脸库搜索
+        DbCommit,//考勤写入事务
+        Preview,//预览帧包装为QImage(Qt不支持BGR888时还包括颜色转换)
+        Paint,//预览控件绘制画面和人脸框
+        EndToEnd,//从采集到显示的总延迟
+        HttpRequest,//HTTP接口从收到完整请求到写出响应的耗时
+        StageCount
+    };
+
+    enum Counter {
+        FramesCaptured,//采集的帧数
+        FramesDropped,//队列满时丢弃的帧数
+        FramesIdle,//画面静止且没有人脸、跳过检测的帧数
+        FacesDetected,//检测到的人脸数
+        Recognitions,//识别次数
+        Matches,//识别为已录入员工的次数
+        Unrecognized,//未能识别的次数
+        QualityRejected,//质量不合格、未送去识别的人脸数
+        AttendanceWritten,//写入数据库的签到记录数
+        AttendanceFailed,//写入失败的签到记录数
+        NotificationsDropped,//通知队列满时丢弃的通知数
+        HttpRequests,//HTTP接口处理的请求数
+        HttpRejected,//识别请求过多时以503拒绝的请求数
+        CounterCount
+    };
+
+    enum Gauge {
+        DbQueueDepth,//等待写入的签到记录数
+        GaugeCount
+    };
+
+    // 每个摄像头的统计
+    struct CameraStats
+    {
+        std::atomic<qint64> captured;//采集的帧数
+        std::atomic<qint64> dropped;//丢弃的帧数
+        std::atomic<qint64> analyzed;//分析完成的帧数
+        LatencyHistogram latency;//从采集到分析完成的延迟
+    };
+
+    static const int kMaxCameras = 16;//最多统计的摄像头数
+
+    static Metrics &instance();//全局实例
+
+    void record(Stage stage, qint64 nanoseconds);//记录一次阶段耗时
+    void add(Counter counter, qint64 delta = 1);//计数器加delta
+    void set(Gauge gauge, qint64 value);//设置瞬时值
+
+    CameraStats &camera(int cameraId);//摄像头的统计 超出范围的编号共用最后一项
+    const CameraStats &camera(int cameraId) const;
+    const LatencyHistogram &histogram(Stage stage) const;//阶段耗时直方图
+    qint64 value(Counter counter) const;//计数器的值
+    qint64 value(Gauge gauge) const;//瞬时值
+    void reset();//清空所有指标
+
+    QString toPrometheus() const;//Prometheus 文本格式
+    QString toJson() const;//JSON 格式
+    bool writeFile(const QString &path) const;//原子地写入指标文件 扩展名为.json时写JSON 否则写Prometheus格式
+
+    static const char *stageName(Stage stage);//阶段名称
+    static const char *counterName(Counter counter);//计数器名称
+    static const char *gaugeName(Gauge gauge);//瞬时值名称
+
+private:
+    Metrics();
+
+    LatencyHistogram stages[StageCount];//各阶段耗时
+    std::atomic<qint64> counters[CounterCount];//计数器
+    std::atomic<qint64> gauges[GaugeCount];//瞬时值
+    CameraStats cameras[kMaxCameras];//各摄像头的统计
+};
+
+// 作用域计时器：构造时开始计时，析构时把耗时记入对应阶段
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Metrics::Stage stage);
+    ~ScopedTimer();
+
+private:
+    Metrics::Stage stage;//记录到的阶段
+    std::chrono::steady_clock::time_point start;//开始时间
+};
+
+#endif // METRICS_H
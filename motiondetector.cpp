@@ -0,0 +1,95 @@
+#include "motiondetector.h"
+
+MotionDetector::MotionDetector(const MotionConfig &config)
+    : config(config)
+{
+}
+
+void MotionDetector::setConfig(const MotionConfig &config) {
+    this->config = config;
+    reset();
+}
+
+const std::vector<cv::Rect> &MotionDetector::regions() const {
+    return changed;
+}
+
+void MotionDetector::reset() {
+    previous.release();
+    changed.clear();
+}
+
+void MotionDetector::mergeOverlapping(std::vector<cv::Rect> &rects) {
+    // 区域个数很少(通常不超过几个)，反复两两合并直到没有重叠
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rects.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                if ((rects[i] & rects[j]).area() > 0) {
+                    rects[i] |= rects[j];
+                    rects.erase(rects.begin() + static_cast<long>(j));
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool MotionDetector::update(const cv::Mat &frame) {
+    changed.clear();
+    cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    if (!config.enabled || frame.empty()) {
+        changed.push_back(bounds);
+        return true;
+    }
+
+    // 缩小后再转灰度，差分的计算量与原始分辨率无关
+    double scale = static_cast<double>(config.analysisWidth) / frame.cols;
+    cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    cv::cvtColor(small, current, cv::COLOR_BGR2GRAY);
+    cv::GaussianBlur(current, current, cv::Size(5, 5), 0);
+
+    if (previous.empty() || previous.size() != current.size()) {
+        // 第一帧没有参照，按整帧变化处理
+        cv::swap(previous, current);
+        changed.push_back(bounds);
+        return true;
+    }
+
+    cv::absdiff(current, previous, diff);
+    cv::threshold(diff, diff, config.pixelThreshold, 255, cv::THRESH_BINARY);
+    cv::swap(previous, current);
+
+    int changedPixels = cv::countNonZero(diff);
+    if (changedPixels < config.minChangedFraction * diff.total()) {
+        return false;
+    }
+
+    // 膨胀后取外轮廓，把相邻的变化像素连成区域
+    cv::dilate(diff, diff, cv::Mat(), cv::Point(-1, -1), 2);
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(diff, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    double inverse = 1.0 / scale;
+    for (const std::vector<cv::Point> &contour : contours) {
+        cv::Rect box = cv::boundingRect(contour);
+        cv::Rect region(cvFloor(box.x * inverse) - config.padding, cvFloor(box.y * inverse) - config.padding,
+                        cvCeil(box.width * inverse) + 2 * config.padding, cvCeil(box.height * inverse) + 2 * config.padding);
+        region &= bounds;
+        if (region.area() > 0) {
+            changed.push_back(region);
+        }
+    }
+    mergeOverlapping(changed);
+
+    int area = 0;
+    for (const cv::Rect &region : changed) {
+        area += region.area();
+    }
+    if (changed.empty() || area > config.fullFrameFraction * bounds.area()) {
+        changed.assign(1, bounds);
+    }
+    return true;
+}
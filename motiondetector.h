@@ -0,0 +1,41 @@
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 运动检测参数
+struct MotionConfig
+{
+    bool enabled = true;//是否启用运动门控 关闭时每次都检测整帧
+    int analysisWidth = 160;//差分前把帧缩小到的宽度(像素)
+    int pixelThreshold = 25;//灰度变化超过该值的像素视为变化
+    double minChangedFraction = 0.002;//变化像素占比低于该值视为静止
+    int padding = 48;//变化区域向外扩展的像素(输入帧坐标)，保证整张人脸落在区域内
+    double fullFrameFraction = 0.5;//变化区域面积超过整帧的该比例时直接检测整帧
+};
+
+// 运动检测：在缩小的灰度帧上做帧差，判断是否有变化并给出变化区域
+// 走廊无人时不需要做人脸检测，有人时只在变化区域内检测；不是线程安全的，每个摄像头一个实例
+class MotionDetector
+{
+public:
+    explicit MotionDetector(const MotionConfig &config = MotionConfig());
+
+    void setConfig(const MotionConfig &config);//修改参数
+    bool update(const cv::Mat &frame);//输入一帧BGR图像 返回与上一帧相比是否有运动
+    const std::vector<cv::Rect> &regions() const;//最近一帧的变化区域(输入帧坐标，已扩展并合并)
+    void reset();//清空上一帧 下一帧视为整帧变化
+
+    static void mergeOverlapping(std::vector<cv::Rect> &rects);//把相互重叠的矩形合并为外接矩形
+
+private:
+    MotionConfig config;//参数
+    cv::Mat small;//缩小后的帧，重复使用
+    cv::Mat current;//当前帧的模糊灰度图
+    cv::Mat previous;//上一帧的模糊灰度图
+    cv::Mat diff;//差分结果和二值掩码，重复使用
+    std::vector<cv::Rect> changed;//变化区域
+};
+
+#endif // MOTIONDETECTOR_H
@@ -0,0 +1,25 @@
+#ifndef NOTIFICATION_H
+#define NOTIFICATION_H
+
+#include <QString>
+#include "facegallery.h"
+#include "lockfreequeue.h"
+
+// 识别结果通知：由识别线程和考勤写入线程发布，界面线程定时取出显示
+struct Notification
+{
+    enum Kind {
+        CheckedIn,//签到记录已写入数据库
+        Unrecognized//检测到人脸但未能识别
+    };
+
+    Kind kind = Unrecognized;//通知类型
+    int cameraId = 0;//摄像头编号
+    int trackId = 0;//轨迹编号 未识别的人脸按轨迹合并
+    EmployeeRecord employee;//签到的员工 签到的通知按员工合并
+    QString timestamp;//签到时间
+};
+
+typedef LockFreeQueue<Notification> NotificationQueue;//通知队列 发布方从不阻塞，队列满时丢弃
+
+#endif // NOTIFICATION_H
@@ -0,0 +1,54 @@
+#include "previewview.h"
+#include "metrics.h"
+#include <QPainter>
+
+PreviewView::PreviewView(QWidget *parent)
+    : QWidget(parent)
+{
+    // 每次都整块重绘画面，不需要先擦除背景
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void PreviewView::setFrame(const cv::Mat &bgr, const std::vector<cv::Rect> &faces) {
+    ScopedTimer timer(Metrics::Preview);
+    frame = bgr;
+    this->faces.assign(faces.begin(), faces.end()); // 复用已有容量
+    if (frame.empty() || frame.type() != CV_8UC3) {
+        image = QImage();
+    } else {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        // Qt 5.14 起可以直接绘制 BGR 数据
+        image = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_BGR888);
+#else
+        // 转换到重复使用的缓冲区，尺寸不变时 cvtColor 不会重新分配
+        cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+        image = QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888);
+#endif
+    }
+    update(); // 合并到下一次绘制，控件不可见时不会绘制
+}
+
+void PreviewView::clear() {
+    frame.release();
+    image = QImage();
+    faces.clear();
+    update();
+}
+
+void PreviewView::paintEvent(QPaintEvent *) {
+    ScopedTimer timer(Metrics::Paint);
+    QPainter painter(this);
+    if (image.isNull()) {
+        painter.fillRect(rect(), Qt::black);
+        return;
+    }
+
+    // 画面缩放到控件大小，人脸框按同样比例换算
+    painter.drawImage(rect(), image);
+    double sx = static_cast<double>(width()) / image.width();
+    double sy = static_cast<double>(height()) / image.height();
+    painter.setPen(QPen(QColor(0, 0, 255), 2));
+    for (const cv::Rect &face : faces) {
+        painter.drawRect(QRectF(face.x * sx, face.y * sy, face.width * sx, face.height * sy));
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef PREVIEWVIEW_H
+#define PREVIEWVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 预览画面：直接在 paintEvent 中绘制帧，人脸框用 QPainter 叠加
+// 不修改、不复制原始帧，Qt 支持 BGR888 时连颜色转换也省去；不创建 QPixmap，控件不可见时不会绘制
+class PreviewView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewView(QWidget *parent = nullptr);
+
+    void setFrame(const cv::Mat &bgr, const std::vector<cv::Rect> &faces);//设置要显示的BGR帧和人脸框 只保存引用 在下次绘制时使用
+    void clear();//清空画面
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    cv::Mat frame;//当前帧(与队列中的帧共享数据，放入队列后不再修改)
+    cv::Mat rgb;//不支持BGR888时的转换缓冲区，尺寸不变时重复使用
+    QImage image;//包装frame或rgb的图像，不持有像素
+    std::vector<cv::Rect> faces;//人脸框(原始帧坐标)
+};
+
+#endif // PREVIEWVIEW_H
@@ -0,0 +1,121 @@
+#include "recognitionworker.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QDebug>
+
+namespace {
+const qint64 kStatsInterval = 100; // 每检测多少帧报告一次耗时
+const int kMaxSsdBatch = 4; // SSD 一次前向计算最多合并的帧数(每个摄像头最多一帧)
+}
+
+RecognitionWorker::RecognitionWorker(const DetectorConfig &config, const QString &embeddingModelPath, const FaceGallery *gallery, QObject *parent)
+    : QThread(parent)
+    , detectorConfig(config)
+    , configChanged(true)
+    , trackerConfigChanged(true)
+    , embeddingModelPath(embeddingModelPath)
+    , gallery(gallery)
+    , attendanceWriter(nullptr)
+    , notifications(nullptr)
+    , inputQueue(nullptr)
+{
+}
+
+void RecognitionWorker::setQueues(FairQueue<FramePacket> *inputQueue, const QVector<BoundedQueue<FramePacket> *> &previewQueues) {
+    this->inputQueue = inputQueue;
+    this->previewQueues = previewQueues;
+}
+
+void RecognitionWorker::setAttendanceWriter(AttendanceWriter *writer) {
+    attendanceWriter = writer;
+}
+
+void RecognitionWorker::setNotificationQueue(NotificationQueue *queue) {
+    notifications = queue;
+}
+
+void RecognitionWorker::setDetectorConfig(const DetectorConfig &config) {
+    QMutexLocker locker(&configMutex);
+    detectorConfig = config;
+    configChanged = true;
+}
+
+void RecognitionWorker::setTrackerConfig(const TrackerConfig &config) {
+    QMutexLocker locker(&configMutex);
+    trackerConfig = config;
+    trackerConfigChanged = true;
+}
+
+void RecognitionWorker::run() {
+    // 检测器和特征提取网络不能在多个线程间共享，识别线程使用自己的实例
+    FrameAnalyzer analyzer(gallery);
+    analyzer.loadEmbedder(embeddingModelPath, detectorConfig.dnnBackend, detectorConfig.dnnTarget);
+    qint64 lastReported = 0;
+
+    while (!isInterruptionRequested()) {
+        {
+            QMutexLocker locker(&configMutex);
+            if (configChanged || !analyzer.detector()) {
+                configChanged = false;
+                if (!analyzer.setDetectorConfig(detectorConfig)) {
+                    // 没有可用的检测器时不再取帧，通知界面停止检测
+                    qDebug() << "Error creating face detector, recognition worker stopped";
+                    emit detectorFailed();
+                    return;
+                }
+                lastReported = 0;
+            }
+            if (trackerConfigChanged) {
+                trackerConfigChanged = false;
+                analyzer.setTrackerConfig(trackerConfig);
+            }
+        }
+
+        // SSD 时把几个摄像头同时就绪的帧一起取出，合并为一次前向计算；Haar 逐帧检测，合并没有好处，还会让其他识别线程闲着
+        int maxBatch = analyzer.detector()->backend() == DetectorConfig::Ssd ? kMaxSsdBatch : 1;
+        std::vector<FramePacket> packets;
+        if (inputQueue->popBatch(packets, maxBatch, 50) == 0) {
+            continue;
+        }
+
+        // 检测、跟踪并识别，只返回身份新确定的轨迹
+        std::vector<RecognitionEvent> events = packets.size() == 1 ? analyzer.analyze(packets[0]) : analyzer.analyzeBatch(packets);
+        for (const RecognitionEvent &event : events) {
+            if (event.recognized) {
+                // 签到直接交给写入线程，去重也在写入线程中完成，不经过界面线程
+                if (attendanceWriter) {
+                    attendanceWriter->submit(event.employee);
+                }
+                emit faceRecognized(event.employee, event.score);
+            } else if (notifications) {
+                // 只放入无锁队列，界面来不及显示时丢弃通知，不影响识别
+                Notification notification;
+                notification.kind = Notification::Unrecognized;
+                notification.cameraId = event.cameraId;
+                notification.trackId = event.trackId;
+                if (!notifications->push(notification)) {
+                    Metrics::instance().add(Metrics::NotificationsDropped);
+                }
+            }
+        }
+
+        FaceDetector *detector = analyzer.detector();
+        if (detector->frameCount() - lastReported >= kStatsInterval) {
+            lastReported = detector->frameCount();
+            emit detectorStats(detector->name(), detector->averageLatencyMs(), detector->frameCount());
+        }
+
+        for (const FramePacket &packet : packets) {
+            // 按摄像头统计从采集到分析完成的延迟
+            Metrics::CameraStats &stats = Metrics::instance().camera(packet.cameraId);
+            stats.analyzed.fetch_add(1, std::memory_order_relaxed);
+            stats.latency.record((QDateTime::currentMSecsSinceEpoch() - packet.captureTime) * 1000000);
+
+            BoundedQueue<FramePacket> *previewQueue = previewQueues.value(packet.cameraId, nullptr);
+            if (previewQueue && previewQueue->push(packet)) {
+                Metrics::instance().add(Metrics::FramesDropped);
+                stats.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef RECOGNITIONWORKER_H
+#define RECOGNITIONWORKER_H
+
+#include <QThread>
+#include <QString>
+#include <QMutex>
+#include <QVector>
+#include <opencv2/opencv.hpp>
+#include "capturethread.h"
+#include "attendancewriter.h"
+#include "frameanalyzer.h"
+#include "notification.h"
+
+// 检测/识别线程：从分析队列取帧，检测、跟踪人脸并在人脸库中匹配
+// 每条轨迹的识别结果只发一次：识别成功的直接提交给考勤写入线程，未能识别的发布到通知队列，都不等待界面线程
+// 带人脸框的帧送入所属摄像头的预览队列；一个线程可以轮流处理多个摄像头
+// 使用SSD检测时，几个摄像头同时有帧就绪就各取一帧合并为一次批量检测
+class RecognitionWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    RecognitionWorker(const DetectorConfig &config, const QString &embeddingModelPath, const FaceGallery *gallery, QObject *parent = nullptr);
+
+    void setQueues(FairQueue<FramePacket> *inputQueue, const QVector<BoundedQueue<FramePacket> *> &previewQueues);//设置输入队列和各摄像头的预览队列(按摄像头编号)
+    void setAttendanceWriter(AttendanceWriter *writer);//设置考勤写入线程
+    void setNotificationQueue(NotificationQueue *queue);//设置通知队列 为空时不发布通知
+    void setDetectorConfig(const DetectorConfig &config);//切换检测器 下一帧生效
+    void setTrackerConfig(const TrackerConfig &config);//设置跟踪参数 下一帧生效
+
+signals:
+    void faceRecognized(const EmployeeRecord &employee, double score);//识别到员工 score为余弦相似度
+    void detectorStats(const QString &backend, double averageMs, qint64 frames);//检测器耗时统计
+    void detectorFailed();//检测器(包括退回的Haar分类器)无法创建 线程已退出
+
+protected:
+    void run() override;
+
+private:
+    QMutex configMutex;//保护检测器配置
+    DetectorConfig detectorConfig;//检测器配置
+    bool configChanged;//配置是否已修改，需要重新创建检测器
+    TrackerConfig trackerConfig;//跟踪参数
+    bool trackerConfigChanged;//跟踪参数是否已修改
+    QString embeddingModelPath;//人脸特征提取模型路径
+    const FaceGallery *gallery;//共享的内存人脸库
+    AttendanceWriter *attendanceWriter;//考勤写入线程
+    NotificationQueue *notifications;//通知队列
+    FairQueue<FramePacket> *inputQueue;//分析队列
+    QVector<BoundedQueue<FramePacket> *> previewQueues;//各摄像头的预览队列
+};
+
+#endif // RECOGNITIONWORKER_H
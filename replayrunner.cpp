@@ -0,0 +1,347 @@
+#include "replayrunner.h"
+#include "attendancestore.h"
+#include "attendancewriter.h"
+#include "databaseschema.h"
+#include "faceembedder.h"
+#include "facegallery.h"
+#include "frameanalyzer.h"
+#include "metrics.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+
+namespace {
+const char *kReplayConnection = "replay"; // 临时数据库的连接名
+const char *kGalleryConnection = "replay_gallery"; // 人脸库数据库的连接名(只读)
+const double kDefaultSourceFps = 25.0; // 图片目录或视频没有帧率信息时使用
+const int kScaleReportFrames = 200; // 分辨率对比默认使用的帧数
+const double kMatchIou = 0.5; // 与基准人脸框的交并比达到该值视为检测到同一张人脸
+}
+
+QString ReplayReport::toString() const {
+    QString text;
+    QTextStream out(&text);
+    out << "frames:          " << frames << "\n";
+    out << "elapsed:         " << QString::number(elapsedMs / 1000.0, 'f', 2) << " s\n";
+    out << "throughput:      " << QString::number(throughputFps, 'f', 1) << " fps\n";
+    out << "latency (ms):    mean " << QString::number(meanMs, 'f', 2)
+        << "  p50 " << QString::number(p50Ms, 'f', 2)
+        << "  p90 " << QString::number(p90Ms, 'f', 2)
+        << "  p99 " << QString::number(p99Ms, 'f', 2)
+        << "  max " << QString::number(maxMs, 'f', 2) << "\n";
+    out << "detector:        " << detectorName << " (" << detectorFrames << " detector frames)\n";
+    out << "idle frames:     " << idleFrames << "\n";
+    out << "detections:      " << detections << "\n";
+    out << "recognitions:    " << recognitions << "\n";
+    out << "low quality:     " << qualityRejected << "\n";
+    out << "matches:         " << matches << "\n";
+    out << "unrecognized:    " << unrecognized << "\n";
+    out << "attendance rows: " << attendanceRows << "\n";
+    out << "gallery size:    " << gallerySize << "\n";
+    return text;
+}
+
+ReplayRunner::ReplayRunner(const ReplayConfig &config)
+    : config(config)
+    , nextImage(0)
+    , sourceFps(kDefaultSourceFps)
+{
+}
+
+const ReplayReport &ReplayRunner::report() const {
+    return result;
+}
+
+QString ReplayRunner::errorString() const {
+    return error;
+}
+
+bool ReplayRunner::openSource() {
+    QFileInfo info(config.source);
+    if (info.isDir()) {
+        QDir dir(config.source);
+        QStringList filters = {"*.jpg", "*.jpeg", "*.png", "*.bmp"};
+        images.clear();
+        for (const QString &name : dir.entryList(filters, QDir::Files, QDir::Name)) {
+            images.append(dir.filePath(name));
+        }
+        nextImage = 0;
+        if (images.isEmpty()) {
+            error = "no images in " + config.source;
+            return false;
+        }
+        return true;
+    }
+
+    if (!video.open(config.source.toStdString())) {
+        error = "cannot open video " + config.source;
+        return false;
+    }
+    double fps = video.get(cv::CAP_PROP_FPS);
+    if (fps > 0.0) {
+        sourceFps = fps;
+    }
+    return true;
+}
+
+bool ReplayRunner::nextFrame(cv::Mat &frame) {
+    if (video.isOpened()) {
+        return video.read(frame) && !frame.empty();
+    }
+    // 跳过无法解码的图片
+    while (nextImage < images.size()) {
+        frame = cv::imread(images[nextImage++].toStdString());
+        if (!frame.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double ReplayRunner::percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+double ReplayRunner::overlap(const cv::Rect &a, const cv::Rect &b) {
+    int intersection = (a & b).area();
+    int unionArea = a.area() + b.area() - intersection;
+    return unionArea > 0 ? static_cast<double>(intersection) / unionArea : 0.0;
+}
+
+QString ReplayRunner::scaleReport(const std::vector<double> &scales) {
+    if (!openSource()) {
+        return QString();
+    }
+
+    // 帧先全部解码到内存，计时只包含缩小和检测
+    std::vector<cv::Mat> frames;
+    int limit = config.maxFrames > 0 ? config.maxFrames : kScaleReportFrames;
+    cv::Mat frame;
+    while (static_cast<int>(frames.size()) < limit && nextFrame(frame)) {
+        frames.push_back(frame.clone());
+    }
+    if (frames.empty()) {
+        error = "no frames in " + config.source;
+        return QString();
+    }
+
+    // 原始分辨率的检测结果作为基准
+    std::vector<std::vector<cv::Rect>> reference;
+    std::unique_ptr<FaceDetector> baseline(FaceDetector::create(config.detectorConfig));
+    if (!baseline) {
+        error = "cannot load face detector";
+        return QString();
+    }
+    for (const cv::Mat &image : frames) {
+        reference.push_back(baseline->detect(image));
+    }
+    double baselineMs = baseline->averageLatencyMs();
+
+    QString text;
+    QTextStream out(&text);
+    out << "detector " << baseline->name() << ", " << frames.size() << " frames at "
+        << frames[0].cols << "x" << frames[0].rows << "\n";
+    out << "scale  resolution  resize(ms)  detect(ms)  speedup  faces  recall  precision\n";
+    for (double scale : scales) {
+        if (scale <= 0.0 || scale > 1.0) {
+            continue;
+        }
+        DetectorConfig scaled = config.detectorConfig;
+        scaled.minFaceSize = cvRound(config.detectorConfig.minFaceSize * scale);
+        std::unique_ptr<FaceDetector> detector(FaceDetector::create(scaled));
+        if (!detector) {
+            continue;
+        }
+
+        qint64 resizeNanos = 0;
+        qint64 found = 0;
+        qint64 matched = 0;
+        qint64 expected = 0;
+        cv::Mat small;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            QElapsedTimer resizeTimer;
+            resizeTimer.start();
+            if (scale < 1.0) {
+                cv::resize(frames[i], small, cv::Size(), scale, scale, cv::INTER_AREA);
+            } else {
+                small = frames[i];
+            }
+            resizeNanos += resizeTimer.nsecsElapsed();
+
+            // 换算回原始帧坐标后与基准逐一贪心匹配
+            std::vector<cv::Rect> faces = detector->detect(small);
+            std::vector<bool> used(reference[i].size(), false);
+            for (const cv::Rect &face : faces) {
+                cv::Rect mapped(cvRound(face.x / scale), cvRound(face.y / scale), cvRound(face.width / scale), cvRound(face.height / scale));
+                for (size_t j = 0; j < reference[i].size(); ++j) {
+                    if (!used[j] && overlap(mapped, reference[i][j]) >= kMatchIou) {
+                        used[j] = true;
+                        ++matched;
+                        break;
+                    }
+                }
+            }
+            found += static_cast<qint64>(faces.size());
+            expected += static_cast<qint64>(reference[i].size());
+        }
+
+        double detectMs = detector->averageLatencyMs();
+        out << QString("%1  %2x%3  %4  %5  %6x  %7  %8  %9\n")
+               .arg(scale, 5, 'f', 2)
+               .arg(cvRound(frames[0].cols * scale), 5).arg(cvRound(frames[0].rows * scale), -5)
+               .arg(resizeNanos / 1e6 / frames.size(), 10, 'f', 2)
+               .arg(detectMs, 10, 'f', 2)
+               .arg(detectMs > 0.0 ? baselineMs / detectMs : 0.0, 6, 'f', 2)
+               .arg(found, 5)
+               .arg(expected > 0 ? static_cast<double>(matched) / expected : 1.0, 6, 'f', 3)
+               .arg(found > 0 ? static_cast<double>(matched) / found : 1.0, 9, 'f', 3);
+    }
+    return text;
+}
+
+bool ReplayRunner::run() {
+    result = ReplayReport();
+    if (!openSource()) {
+        return false;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        error = "cannot create temporary directory";
+        return false;
+    }
+    QString databasePath = tempDir.filePath("replay.db");
+
+    FaceGallery gallery;
+    bool ok = true;
+    {
+        // 临时数据库使用与界面相同的表结构
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", kReplayConnection);
+        db.setDatabaseName(databasePath);
+        if (!db.open() || !DatabaseSchema::create(db)) {
+            error = "cannot create temporary database: " + db.lastError().text();
+            ok = false;
+        }
+
+        // 人脸库从正式数据库只读加载，不写回索引文件
+        if (ok && !config.galleryDatabasePath.isEmpty()) {
+            QSqlDatabase galleryDb = QSqlDatabase::addDatabase("QSQLITE", kGalleryConnection);
+            galleryDb.setDatabaseName(config.galleryDatabasePath);
+            galleryDb.setConnectOptions("QSQLITE_OPEN_READONLY");
+            if (galleryDb.open()) {
+                FaceEmbedder embedder;
+                embedder.load(config.embeddingModelPath, config.detectorConfig.dnnBackend, config.detectorConfig.dnnTarget);
+                gallery.loadFromDatabase(galleryDb, embedder);
+                galleryDb.close();
+            } else {
+                qDebug() << "Error opening gallery database:" << galleryDb.lastError().text();
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(kGalleryConnection);
+    if (!ok) {
+        QSqlDatabase::removeDatabase(kReplayConnection);
+        return false;
+    }
+    result.gallerySize = gallery.size();
+
+    FrameAnalyzer analyzer(&gallery);
+    if (!analyzer.setDetectorConfig(config.detectorConfig)) {
+        error = "cannot load face detector";
+        QSqlDatabase::removeDatabase(kReplayConnection);
+        return false;
+    }
+    analyzer.loadEmbedder(config.embeddingModelPath, config.detectorConfig.dnnBackend, config.detectorConfig.dnnTarget);
+    analyzer.setTrackerConfig(config.trackerConfig);
+    analyzer.setMotionConfig(config.motionConfig);
+    analyzer.setQualityConfig(config.qualityConfig);
+    qint64 idleBefore = Metrics::instance().value(Metrics::FramesIdle);
+    result.detectorName = analyzer.detector()->name();
+
+    AttendanceWriter writer(databasePath);
+    writer.start();
+
+    // 采集时间按源的帧率生成，跟踪器的重新识别间隔和签到去重与实时运行时一致
+    double interval = 1000.0 / (config.fps > 0.0 ? config.fps : sourceFps);
+    qint64 baseTime = QDateTime::currentMSecsSinceEpoch();
+
+    std::vector<double> latencies;
+    QElapsedTimer wall;
+    QElapsedTimer frameTimer;
+    wall.start();
+    cv::Mat frame;
+    while ((config.maxFrames <= 0 || result.frames < config.maxFrames) && nextFrame(frame)) {
+        // 固定帧率回放：等到这一帧的时间再处理
+        if (config.fps > 0.0) {
+            qint64 due = static_cast<qint64>(result.frames * interval);
+            qint64 wait = due - wall.elapsed();
+            if (wait > 0) {
+                QThread::msleep(static_cast<unsigned long>(wait));
+            }
+        }
+
+        FramePacket packet;
+        packet.frame = frame;
+        packet.sequence = result.frames;
+        packet.captureTime = baseTime + static_cast<qint64>(result.frames * interval);
+
+        frameTimer.start();
+        std::vector<RecognitionEvent> events = analyzer.analyze(packet);
+        for (const RecognitionEvent &event : events) {
+            if (event.recognized) {
+                ++result.matches;
+                writer.submit(event.employee, QDateTime::fromMSecsSinceEpoch(packet.captureTime));
+            } else {
+                ++result.unrecognized;
+            }
+        }
+        latencies.push_back(frameTimer.nsecsElapsed() / 1e6);
+
+        result.detections += static_cast<qint64>(packet.faces.size());
+        ++result.frames;
+    }
+    writer.stop(); // 写完队列中剩余的签到记录
+    result.elapsedMs = wall.nsecsElapsed() / 1e6;
+
+    result.detectorFrames = analyzer.detector()->frameCount();
+    result.recognitions = analyzer.recognitionCount();
+    result.qualityRejected = analyzer.qualityRejectedCount();
+    result.idleFrames = Metrics::instance().value(Metrics::FramesIdle) - idleBefore;
+    if (result.elapsedMs > 0.0) {
+        result.throughputFps = result.frames * 1000.0 / result.elapsedMs;
+    }
+    if (!latencies.empty()) {
+        double total = 0.0;
+        for (double ms : latencies) {
+            total += ms;
+        }
+        result.meanMs = total / latencies.size();
+        std::sort(latencies.begin(), latencies.end());
+        result.p50Ms = percentile(latencies, 0.50);
+        result.p90Ms = percentile(latencies, 0.90);
+        result.p99Ms = percentile(latencies, 0.99);
+        result.maxMs = latencies.back();
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::database(kReplayConnection);
+        result.attendanceRows = qMax<qint64>(0, AttendanceStore(db).count(AttendanceFilter()));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(kReplayConnection);
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef REPLAYRUNNER_H
+#define REPLAYRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "facedetector.h"
+#include "facequality.h"
+#include "facetracker.h"
+#include "motiondetector.h"
+
+// 回放参数
+struct ReplayConfig
+{
+    QString source;//视频文件或图片目录
+    double fps = 0.0;//回放帧率 0表示尽可能快
+    int maxFrames = 0;//最多回放的帧数 0表示不限
+    QString galleryDatabasePath;//人脸库所在的数据库(只读) 为空时人脸库为空
+    QString embeddingModelPath;//人脸特征提取模型路径
+    DetectorConfig detectorConfig;//人脸检测器配置
+    TrackerConfig trackerConfig;//跟踪参数
+    MotionConfig motionConfig;//运动检测参数
+    QualityConfig qualityConfig;//人脸质量门限
+};
+
+// 回放结果
+struct ReplayReport
+{
+    qint64 frames = 0;//回放的帧数
+    double elapsedMs = 0.0;//总耗时(毫秒)
+    double throughputFps = 0.0;//吞吐量(帧/秒)
+    double meanMs = 0.0;//平均每帧耗时
+    double p50Ms = 0.0;//每帧耗时的中位数
+    double p90Ms = 0.0;//每帧耗时的90分位
+    double p99Ms = 0.0;//每帧耗时的99分位
+    double maxMs = 0.0;//每帧耗时的最大值
+    QString detectorName;//实际使用的检测后端
+    qint64 detectorFrames = 0;//做了检测(整帧或变化区域)的帧数
+    qint64 idleFrames = 0;//画面静止被跳过的帧数
+    qint64 detections = 0;//所有帧中人脸框的总数
+    qint64 recognitions = 0;//识别(特征提取+搜索)次数
+    qint64 qualityRejected = 0;//质量不合格、跳过识别的次数
+    qint64 matches = 0;//识别为已录入员工的次数
+    qint64 unrecognized = 0;//未能识别的次数
+    qint64 attendanceRows = 0;//写入临时数据库的签到记录数
+    int gallerySize = 0;//人脸库员工数量
+
+    QString toString() const;//格式化为文本报告
+};
+
+// 无界面回放：把录制的视频或图片目录按固定帧率或最快速度送入与界面相同的检测、识别和考勤写入代码
+// 签到写入临时 SQLite 数据库，不影响正式数据，不需要摄像头和显示器
+class ReplayRunner
+{
+public:
+    explicit ReplayRunner(const ReplayConfig &config);
+
+    bool run();//回放全部帧 返回是否成功
+    QString scaleReport(const std::vector<double> &scales);//在不同检测分辨率下检测同一批帧 以原始分辨率的结果为基准报告耗时和召回率 失败时返回空字符串
+    const ReplayReport &report() const;//回放结果
+    QString errorString() const;//失败原因
+
+private:
+    bool openSource();//打开视频文件或列出目录中的图片
+    bool nextFrame(cv::Mat &frame);//读取下一帧 没有更多帧时返回false
+    static double percentile(const std::vector<double> &sorted, double p);//已排序数据的分位数
+    static double overlap(const cv::Rect &a, const cv::Rect &b);//交并比
+
+    ReplayConfig config;//回放参数
+    ReplayReport result;//回放结果
+    QString error;//失败原因
+    cv::VideoCapture video;//视频源
+    QStringList images;//图片源(按文件名排序)
+    int nextImage;//下一张图片的下标
+    double sourceFps;//源的帧率，用于生成采集时间
+};
+
+#endif // REPLAYRUNNER_H
@@ -0,0 +1,137 @@
+#include "startupsequence.h"
+#include <QThread>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+StartupSequence::StartupSequence(QObject *parent)
+    : QObject(parent)
+    , done(false)
+{
+    clock.start();
+}
+
+StartupSequence::~StartupSequence() {
+    // 加载线程引用了窗口的成员，退出前等它们结束
+    for (const std::unique_ptr<Phase> &phase : phases) {
+        if (phase->thread) {
+            phase->thread->wait();
+            delete phase->thread;
+        }
+    }
+}
+
+void StartupSequence::addPhase(const QString &name, const QStringList &after, std::function<bool()> work) {
+    std::unique_ptr<Phase> phase(new Phase);
+    phase->name = name;
+    phase->after = after;
+    phase->work = work;
+    phases.push_back(std::move(phase));
+}
+
+void StartupSequence::addExternalPhase(const QString &name) {
+    std::unique_ptr<Phase> phase(new Phase);
+    phase->name = name;
+    phase->started = true;
+    phase->startMs = clock.elapsed();
+    phases.push_back(std::move(phase));
+}
+
+void StartupSequence::finishPhase(const QString &name, bool ok) {
+    Phase *phase = find(name);
+    if (phase && !phase->finished) {
+        complete(phase, ok, clock.elapsed());
+    }
+}
+
+void StartupSequence::start() {
+    startReady();
+}
+
+bool StartupSequence::isFinished(const QString &name) const {
+    Phase *phase = find(name);
+    return phase && phase->finished;
+}
+
+bool StartupSequence::succeeded(const QString &name) const {
+    Phase *phase = find(name);
+    return phase && phase->finished && phase->ok;
+}
+
+int StartupSequence::finishedCount() const {
+    return static_cast<int>(std::count_if(phases.begin(), phases.end(),
+                                          [](const std::unique_ptr<Phase> &phase) { return phase->finished; }));
+}
+
+int StartupSequence::phaseCount() const {
+    return static_cast<int>(phases.size());
+}
+
+QString StartupSequence::report() const {
+    QString text;
+    QTextStream out(&text);
+    out << "startup phases (ms since start):\n";
+    qint64 last = 0;
+    for (const std::unique_ptr<Phase> &phase : phases) {
+        out << "  " << phase->name.leftJustified(16) << " start " << QString::number(phase->startMs).rightJustified(6);
+        if (phase->finished) {
+            out << "  took " << QString::number(phase->endMs - phase->startMs).rightJustified(6)
+                << "  " << (phase->ok ? "ok" : "FAILED") << "\n";
+            last = std::max(last, phase->endMs);
+        } else {
+            out << "  pending\n";
+        }
+    }
+    out << "  ready after " << last << " ms\n";
+    return text;
+}
+
+StartupSequence::Phase *StartupSequence::find(const QString &name) const {
+    for (const std::unique_ptr<Phase> &phase : phases) {
+        if (phase->name == name) {
+            return phase.get();
+        }
+    }
+    return nullptr;
+}
+
+void StartupSequence::startReady() {
+    for (const std::unique_ptr<Phase> &entry : phases) {
+        Phase *phase = entry.get();
+        if (phase->started) {
+            continue;
+        }
+        bool ready = std::all_of(phase->after.begin(), phase->after.end(), [this](const QString &name) {
+            Phase *dependency = find(name);
+            return !dependency || dependency->finished;
+        });
+        if (!ready) {
+            continue;
+        }
+
+        phase->started = true;
+        phase->startMs = clock.elapsed();
+
+        // 结果由加载线程写入，finished 信号在界面线程中处理时线程已结束
+        std::function<bool()> work = phase->work;
+        const QElapsedTimer *startClock = &clock;
+        phase->thread = QThread::create([phase, work, startClock]() {
+            phase->ok = work();
+            phase->endMs = startClock->elapsed();
+        });
+        connect(phase->thread, &QThread::finished, this, [this, phase]() { complete(phase, phase->ok, phase->endMs); });
+        phase->thread->start();
+    }
+}
+
+void StartupSequence::complete(Phase *phase, bool ok, qint64 endMs) {
+    phase->finished = true;
+    phase->ok = ok;
+    phase->endMs = endMs;
+    emit phaseFinished(phase->name, ok);
+    startReady();
+    if (finishedCount() == phaseCount() && !done) {
+        done = true;
+        emit allFinished();
+    }
+}
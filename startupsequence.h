@@ -0,0 +1,64 @@
+#ifndef STARTUPSEQUENCE_H
+#define STARTUPSEQUENCE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+// 分阶段启动：窗口先显示，模型、分类器和人脸库在后台线程中并行加载
+// 每个阶段在它依赖的阶段完成后开始(依赖失败时由阶段自己决定如何退化)，完成时在界面线程中发出信号；记录每个阶段相对启动时刻的开始和结束时间
+// 外部阶段(如摄像头打开)由别的线程完成，调用 finishPhase 标记
+// 只在界面线程中调用
+class StartupSequence : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StartupSequence(QObject *parent = nullptr);//从构造时开始计时
+    ~StartupSequence();
+
+    void addPhase(const QString &name, const QStringList &after, std::function<bool()> work);//添加后台阶段 after中的阶段都完成(无论成败)后在新线程中执行work 返回是否成功
+    void addExternalPhase(const QString &name);//添加外部阶段 从添加时开始计时
+    void finishPhase(const QString &name, bool ok);//外部阶段完成
+    void start();//启动没有依赖的后台阶段
+
+    bool isFinished(const QString &name) const;//阶段是否已完成(成功或失败)
+    bool succeeded(const QString &name) const;//阶段是否成功完成
+    int finishedCount() const;//已完成的阶段数
+    int phaseCount() const;//阶段总数
+    QString report() const;//各阶段的开始时刻、耗时和结果 每阶段一行
+
+signals:
+    void phaseFinished(const QString &name, bool ok);//一个阶段完成
+    void allFinished();//所有阶段完成
+
+private:
+    struct Phase
+    {
+        QString name;//阶段名称
+        QStringList after;//依赖的阶段
+        std::function<bool()> work;//后台执行的工作 外部阶段为空
+        QThread *thread = nullptr;//执行线程
+        bool started = false;//是否已开始
+        bool finished = false;//是否已完成
+        bool ok = false;//是否成功
+        qint64 startMs = 0;//开始时刻(相对启动，毫秒)
+        qint64 endMs = 0;//结束时刻(相对启动，毫秒)
+    };
+
+    Phase *find(const QString &name) const;//按名称查找阶段
+    void startReady();//启动依赖都已完成的后台阶段
+    void complete(Phase *phase, bool ok, qint64 endMs);//记录阶段结果并启动后续阶段
+
+    QElapsedTimer clock;//启动计时
+    std::vector<std::unique_ptr<Phase>> phases;//所有阶段 按添加顺序
+    bool done;//是否已发出 allFinished
+};
+
+#endif // STARTUPSEQUENCE_H
@@ -0,0 +1,168 @@
+#include "toastoverlay.h"
+#include <QPainter>
+#include <QEvent>
+#include <QDateTime>
+
+namespace {
+const int kToastMs = 3000; // 每条提示的显示时间
+const int kFadeMs = 500; // 消失前的淡出时间
+const int kMaxToasts = 4; // 同时显示的提示上限，超出时移除最旧的
+const double kToastsPerSecond = 2.0; // 新提示的平均速率上限
+const double kBurst = 3.0; // 允许的突发提示数
+const int kToastWidth = 320;
+const int kToastHeight = 58;
+const int kMargin = 12;
+const char *kSummaryKey = "__summary"; // 汇总提示的键
+}
+
+ToastOverlay::ToastOverlay(QWidget *parent)
+    : QWidget(parent)
+    , timer(new QTimer(this))
+    , tokens(kBurst)
+    , lastRefill(QDateTime::currentMSecsSinceEpoch())
+    , suppressed(0)
+{
+    // 只负责显示，鼠标和键盘事件交给下面的控件
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setFocusPolicy(Qt::NoFocus);
+    setGeometry(parent->rect());
+    parent->installEventFilter(this);
+
+    timer->setInterval(50);
+    connect(timer, &QTimer::timeout, this, &ToastOverlay::expire);
+}
+
+void ToastOverlay::post(const QString &key, Kind kind, const QString &title, const QString &text) {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // 已在显示的键直接合并，不消耗令牌
+    for (const Toast &toast : toasts) {
+        if (toast.key == key) {
+            place(key, kind, title, text, now);
+            return;
+        }
+    }
+
+    if (takeToken(now)) {
+        place(key, kind, title, text, now);
+        return;
+    }
+
+    // 超出速率的提示只计数，显示为一条汇总提示
+    ++suppressed;
+    place(kSummaryKey, Summary, "通知过多", QString("另有 %1 条识别结果未单独显示").arg(suppressed), now);
+}
+
+bool ToastOverlay::takeToken(qint64 now) {
+    tokens = qMin(kBurst, tokens + (now - lastRefill) * kToastsPerSecond / 1000.0);
+    lastRefill = now;
+    if (tokens < 1.0) {
+        return false;
+    }
+    tokens -= 1.0;
+    return true;
+}
+
+void ToastOverlay::place(const QString &key, Kind kind, const QString &title, const QString &text, qint64 now) {
+    for (int i = 0; i < toasts.size(); ++i) {
+        if (toasts[i].key == key) {
+            // 合并后移到最新的位置，重新计时
+            Toast toast = toasts[i];
+            toasts.remove(i);
+            toast.kind = kind;
+            toast.title = title;
+            toast.text = text;
+            toast.repeats += key == kSummaryKey ? 0 : 1;
+            toast.expiresAt = now + kToastMs;
+            toasts.append(toast);
+            update();
+            return;
+        }
+    }
+
+    Toast toast;
+    toast.key = key;
+    toast.kind = kind;
+    toast.title = title;
+    toast.text = text;
+    toast.repeats = 1;
+    toast.expiresAt = now + kToastMs;
+    toasts.append(toast);
+    while (toasts.size() > kMaxToasts) {
+        toasts.removeFirst();
+    }
+
+    raise();
+    if (!timer->isActive()) {
+        timer->start();
+    }
+    update();
+}
+
+void ToastOverlay::expire() {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (int i = toasts.size() - 1; i >= 0; --i) {
+        if (toasts[i].expiresAt <= now) {
+            if (toasts[i].key == kSummaryKey) {
+                suppressed = 0;
+            }
+            toasts.remove(i);
+        }
+    }
+    if (toasts.isEmpty()) {
+        timer->stop();
+    }
+    update();
+}
+
+void ToastOverlay::paintEvent(QPaintEvent *) {
+    if (toasts.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont titleFont = font();
+    titleFont.setBold(true);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // 最新的提示在最上面
+    int y = kMargin;
+    for (int i = toasts.size() - 1; i >= 0; --i) {
+        const Toast &toast = toasts[i];
+        qint64 left = toast.expiresAt - now;
+        painter.setOpacity(left < kFadeMs ? qMax<qint64>(left, 0) / static_cast<double>(kFadeMs) : 1.0);
+
+        QRect card(width() - kToastWidth - kMargin, y, kToastWidth, kToastHeight);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(color(toast.kind));
+        painter.drawRoundedRect(card, 6, 6);
+
+        QRect content = card.adjusted(12, 6, -12, -6);
+        QString title = toast.repeats > 1 ? QString("%1  ×%2").arg(toast.title).arg(toast.repeats) : toast.title;
+        painter.setPen(Qt::white);
+        painter.setFont(titleFont);
+        painter.drawText(content, Qt::AlignLeft | Qt::AlignTop, title);
+        painter.setFont(font());
+        painter.drawText(content, Qt::AlignLeft | Qt::AlignBottom, painter.fontMetrics().elidedText(toast.text, Qt::ElideRight, content.width()));
+
+        y += kToastHeight + kMargin / 2;
+    }
+}
+
+bool ToastOverlay::eventFilter(QObject *watched, QEvent *event) {
+    // 跟随父控件的大小
+    if (watched == parentWidget() && event->type() == QEvent::Resize) {
+        setGeometry(parentWidget()->rect());
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+QColor ToastOverlay::color(Kind kind) {
+    switch (kind) {
+    case Success: return QColor(76, 175, 80, 230); // 与录入按钮相同的绿色
+    case Warning: return QColor(255, 152, 0, 230);
+    default: return QColor(96, 125, 139, 230);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef TOASTOVERLAY_H
+#define TOASTOVERLAY_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QString>
+#include <QVector>
+#include <QColor>
+
+// 非模态提示层：覆盖在父控件上，在右上角叠放几条自动消失的提示，不拦截鼠标和键盘
+// 同一个键(员工或轨迹)的提示合并为一条并计数；新提示按令牌桶限速，超出的合并成一条汇总提示
+class ToastOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Kind {
+        Success,//签到成功
+        Warning,//未能识别
+        Summary//被限速合并的提示
+    };
+
+    explicit ToastOverlay(QWidget *parent);
+
+    void post(const QString &key, Kind kind, const QString &title, const QString &text);//显示一条提示 同一个键的提示正在显示时合并
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void expire();//移除到期的提示 刷新淡出效果
+
+private:
+    struct Toast
+    {
+        QString key;//合并用的键
+        Kind kind;//提示类型
+        QString title;//标题
+        QString text;//正文
+        int repeats;//合并的次数
+        qint64 expiresAt;//消失时间(毫秒)
+    };
+
+    bool takeToken(qint64 now);//取一个令牌 限速时返回false
+    void place(const QString &key, Kind kind, const QString &title, const QString &text, qint64 now);//显示或合并一条提示
+    static QColor color(Kind kind);//提示的背景色
+
+    QVector<Toast> toasts;//正在显示的提示 最新的在最后
+    QTimer *timer;//到期检查定时器 没有提示时停止
+    double tokens;//令牌桶中的令牌数
+    qint64 lastRefill;//上次补充令牌的时间(毫秒)
+    int suppressed;//被限速合并到汇总提示中的提示数
+};
+
+#endif // TOASTOVERLAY_H